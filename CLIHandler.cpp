@@ -3,6 +3,7 @@
 #include "SDCardManager.h"
 #include "PinConfig.h"
 #include "hardware/gpio.h"
+#include "hardware/clocks.h"
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -166,6 +167,31 @@ void CLIHandler::processCommand() {
     else if (strcmp(cmd, "test") == 0) {
         handleTest();
     }
+    else if (strcmp(cmd, "gcrmode") == 0) {
+        handleGCRMode(argCount >= 2 ? args[1] : nullptr);
+    }
+    else if (strcmp(cmd, "pll") == 0) {
+        handlePLL(argCount >= 2 ? args[1] : nullptr);
+    }
+    else if (strcmp(cmd, "plltest") == 0) {
+        handlePLLTest(argCount >= 2 ? args[1] : nullptr);
+    }
+    else if (strcmp(cmd, "tcache") == 0) {
+        handleTrackCache(argCount >= 2 ? args[1] : nullptr);
+    }
+    else if (strcmp(cmd, "sdbench") == 0) {
+        handleSDBench(argCount >= 2 ? args[1] : nullptr);
+    }
+    else if (strcmp(cmd, "sdasync") == 0) {
+        handleSDAsync(argCount >= 2 ? args[1] : nullptr, argCount >= 3 ? args[2] : nullptr,
+                      argCount >= 4 ? args[3] : nullptr);
+    }
+    else if (strcmp(cmd, "dirindex") == 0) {
+        handleDirIndex(argCount >= 2 ? args[1] : nullptr);
+    }
+    else if (strcmp(cmd, "rpm") == 0) {
+        handleRPM(argCount >= 2 ? args[1] : nullptr);
+    }
     else {
         char msg[64];
         snprintf(msg, sizeof(msg), "Unknown command: %s\r\n", cmd);
@@ -216,6 +242,14 @@ void CLIHandler::handleHelp() {
     sendResponse("  seek <track>     - Seek to track (0-34)\r\n");
     sendResponse("  read <t> <s>       - Read track and sector\r\n");
     sendResponse("  gpio/pins          - Show GPIO pin states\r\n");
+    sendResponse("  gcrmode [disk|track] - Whole-disk or per-track GCR encoding\r\n");
+    sendResponse("  pll [tolerance%] - Show/set write data separator tolerance\r\n");
+    sendResponse("  plltest [jitter%] - Decode synthetic write streams at -5..+5% speed\r\n");
+    sendResponse("  tcache [reset]    - Show track cache slots and prefetch hit rate\r\n");
+    sendResponse("  sdbench [track]   - Time a track flush (rewrites the track with its own data)\r\n");
+    sendResponse("  sdasync [reset|read <block> [count]] - Async SD engine stats / read\r\n");
+    sendResponse("  dirindex [on|off|rebuild] - Directory index file for large folders (off by default)\r\n");
+    sendResponse("  rpm [rpm|measure] - Show/set read drive speed, measure the bit cell on READ\r\n");
     sendResponse("  test               - Test emulator\r\n");
 }
 
@@ -236,18 +270,28 @@ void CLIHandler::handleLoad(const char* filename) {
     uint32_t diskSize = GET_FLOPPY()->getDiskImageSize();
     uint32_t bytesRead = 0;
     
-    if (GET_SD()->loadDiskImage(filename, diskImage, diskSize, &bytesRead)) {
+    // Flush pending writes of the old image before the buffer is overwritten
+    GET_FLOPPY()->beginDiskImageLoad();
+    
+    // Mount time = SD card read + GCR pre-encoding
+    uint32_t loadStart = time_us_32();
+    // The emulator keeps the open file handle - track saves then need no directory lookup
+    if (GET_SD()->loadDiskImage(filename, diskImage, diskSize, &bytesRead, GET_FLOPPY()->getCurrentFile())) {
+        // Set SD card manager and file type in FloppyEmulator for saving tracks
+        // File type first - loadDiskImage() needs it (.dsk/.nic) to pre-encode GCR
+        GET_FLOPPY()->setSDCardManager(GET_SD());
+        GET_FLOPPY()->updateCurrentFileType();
+        
         // Call FloppyEmulator::loadDiskImage() to set initial track to 17
         GET_FLOPPY()->loadDiskImage(diskImage, bytesRead);
-        
-        // Set SD card manager and filename in FloppyEmulator for saving tracks
-        GET_FLOPPY()->setSDCardManager(GET_SD());
-        GET_FLOPPY()->setCurrentFileName(filename);
+        uint32_t loadUs = time_us_32() - loadStart;
         
         char msg[128];
-        snprintf(msg, sizeof(msg), "Loaded %u bytes from %s\r\n", bytesRead, filename);
+        snprintf(msg, sizeof(msg), "Loaded %u bytes from %s in %lu.%03lu ms\r\n", bytesRead, filename,
+                 (unsigned long)(loadUs / 1000), (unsigned long)(loadUs % 1000));
         sendResponse(msg);
     } else {
+        GET_FLOPPY()->abortDiskImageLoad();
         sendResponse("Failed to load disk image\r\n");
     }
 }
@@ -258,17 +302,38 @@ void CLIHandler::handleList() {
         return;
     }
     
-    char fileList[1024];
-    uint32_t fileCount = 0;
+    FAT32* fat32 = GET_SD()->getFAT32();
+    if (!GET_SD()->isInitialized() || !fat32) {
+        sendResponse("Failed to list files or no files found\r\n");
+        return;
+    }
     
-    if (GET_SD()->listFiles(fileList, sizeof(fileList), &fileCount)) {
-        char msg[128];
-        snprintf(msg, sizeof(msg), "Found %u files:\r\n", fileCount);
-        sendResponse(msg);
-        sendResponse(fileList);
-    } else {
+    // Stream the whole listing in one go - no limit on the directory size, no pass per page
+    // (sorted when that is free, else directory order - see FAT32::listAll())
+    uint32_t total = 0;
+    bool sorted = false;
+    uint32_t passesBefore = fat32->getListPasses();
+    uint32_t startTime = time_us_32();
+    char msg[128];
+    
+    if (!fat32->listAll(sendListEntry, this, &total, &sorted)) {
         sendResponse("Failed to list files or no files found\r\n");
+        return;
     }
+    
+    snprintf(msg, sizeof(msg), "%lu files (%s), listed in %lu ms (%lu directory passes)\r\n",
+             (unsigned long)total, sorted ? "sorted" : "directory order",
+             (unsigned long)((time_us_32() - startTime) / 1000),
+             (unsigned long)(fat32->getListPasses() - passesBefore));
+    sendResponse(msg);
+}
+
+// FAT32::listAll() callback of handleList() - context is the CLIHandler
+bool CLIHandler::sendListEntry(const FAT32_ListEntry* entry, void* context) {
+    char msg[FAT32_FILE_NAME_SIZE + 16];
+    snprintf(msg, sizeof(msg), "%s%s\r\n", entry->name, entry->isDirectory ? " <DIR>" : "");
+    ((CLIHandler*)context)->sendResponse(msg);
+    return true;
 }
 
 void CLIHandler::handleInfo() {
@@ -278,6 +343,7 @@ void CLIHandler::handleInfo() {
     }
     
     FloppyEmulator* floppy = GET_FLOPPY();
+    uint32_t headBit = floppy->getHeadBitPosition();
     char msg[256];
     snprintf(msg, sizeof(msg), 
         "Disk Image Info:\r\n"
@@ -286,10 +352,12 @@ void CLIHandler::handleInfo() {
         "  Sectors per track: 16\r\n"
         "  Bytes per sector: 256\r\n"
         "  Current track: %d\r\n"
+        "  Head position: byte %lu bit %lu\r\n"
         "  At track 0: %s\r\n"
         "  Drive selected: %s\r\n",
         floppy->getDiskImageSize(),
         floppy->getCurrentTrack(),
+        (unsigned long)(headBit / 8), (unsigned long)(headBit % 8),
         floppy->isAtTrack0() ? "Yes" : "No",
         floppy->isDriveSelected() ? "Yes" : "No"
     );
@@ -300,10 +368,44 @@ void CLIHandler::handleStatus() {
     handleInfo();
     
     if (sdCardManager) {
-        char msg[64];
+        char msg[128];
         snprintf(msg, sizeof(msg), "SD Card: %s\r\n", 
                  GET_SD()->isInitialized() ? "Initialized" : "Not initialized");
         sendResponse(msg);
+        
+        FAT32* fat32 = GET_SD()->getFAT32();
+        if (fat32) {
+            FAT32_CacheStats cache;
+            fat32->getFATCacheStats(&cache);
+            snprintf(msg, sizeof(msg), "FAT cache: %lu hits, %lu card reads\r\n",
+                     (unsigned long)cache.hits, (unsigned long)cache.misses);
+            sendResponse(msg);
+            
+            FAT32_DirCacheStats dirCache;
+            fat32->getDirCacheStats(&dirCache);
+            snprintf(msg, sizeof(msg), "Dir cache: %lu hits, %lu scans, %lu builds (%lu entries%s)\r\n",
+                     (unsigned long)dirCache.hits, (unsigned long)dirCache.scans, (unsigned long)dirCache.builds,
+                     (unsigned long)fat32->getDirCacheCount(), fat32->isDirCacheComplete() ? "" : ", partial");
+            sendResponse(msg);
+        }
+        
+        if (floppyEmulator && fat32 && fat32->isFileOpen(GET_FLOPPY()->getCurrentFile())) {
+            const FAT32File* file = GET_FLOPPY()->getCurrentFile();
+            snprintf(msg, sizeof(msg), "Open image: %s (%lu extent(s), entry at sector %lu #%u)\r\n",
+                     file->name, (unsigned long)file->extentCount, (unsigned long)file->entrySector, file->entryIndex);
+            sendResponse(msg);
+        }
+    }
+    
+    if (floppyEmulator) {
+        WriteBackStats stats;
+        GET_FLOPPY()->getWriteBackStats(&stats);
+        char msg[160];
+        snprintf(msg, sizeof(msg), "Write-back: %lu queued, %lu saved (%lu async, %lu retried), %lu pending, %lu deferred (queue full)\r\n",
+                 (unsigned long)stats.queued, (unsigned long)stats.completed,
+                 (unsigned long)stats.async, (unsigned long)stats.retried,
+                 (unsigned long)stats.pending, (unsigned long)stats.deferred);
+        sendResponse(msg);
     }
 }
 
@@ -354,6 +456,21 @@ void CLIHandler::handleGPIO() {
     int currentTrack = GET_FLOPPY()->getCurrentTrack();
     snprintf(msg, sizeof(msg), "Current Track: %d\r\n", currentTrack);
     sendResponse(msg);
+    
+    // How phase changes reach the emulator
+    StepperCaptureStats stats;
+    GET_FLOPPY()->getStepperCaptureStats(&stats);
+    if (GET_FLOPPY()->isPhaseCaptureReady()) {
+        snprintf(msg, sizeof(msg), "Phase capture: PIO + IRQ, %lu changes, %lu dropped, IRQ max %luus\r\n",
+                 (unsigned long)stats.events, (unsigned long)stats.dropped, (unsigned long)stats.maxIrqLatencyUs);
+    } else {
+        snprintf(msg, sizeof(msg), "Phase capture: polling every %dus\r\n", STEPPER_POLL_INTERVAL_US);
+    }
+    sendResponse(msg);
+    snprintf(msg, sizeof(msg), "Steps: %lu, last interval %luus, fastest %luus\r\n",
+             (unsigned long)stats.steps, (unsigned long)stats.lastStepIntervalUs,
+             (unsigned long)stats.minStepIntervalUs);
+    sendResponse(msg);
 }
 
 void CLIHandler::handleSeek(int track) {
@@ -588,3 +705,334 @@ void CLIHandler::handleTest() {
     sendResponse("Test complete\r\n");
 }
 
+void CLIHandler::handleGCRMode(const char* mode) {
+    if (!floppyEmulator) {
+        sendResponse("Floppy emulator not initialized\r\n");
+        return;
+    }
+    
+    FloppyEmulator* floppy = GET_FLOPPY();
+    if (mode != nullptr) {
+        if (strcmp(mode, "disk") == 0) {
+            floppy->setWholeDiskGCRMode(true);
+        } else if (strcmp(mode, "track") == 0) {
+            floppy->setWholeDiskGCRMode(false);
+        } else {
+            sendResponse("Usage: gcrmode [disk|track]\r\n");
+            return;
+        }
+        sendResponse("GCR mode changed (applies on next load)\r\n");
+    }
+    
+    char msg[128];
+    snprintf(msg, sizeof(msg), "GCR mode: %s (active: %s)\r\n",
+             floppy->getWholeDiskGCRMode() ? "disk" : "track",
+             floppy->isWholeDiskGCRActive() ? "disk" : "track");
+    sendResponse(msg);
+}
+
+void CLIHandler::handlePLL(const char* toleranceArg) {
+    if (!floppyEmulator) {
+        sendResponse("Floppy emulator not initialized\r\n");
+        return;
+    }
+    
+    FluxPLL* pll = GET_FLOPPY()->getWritePLL();
+    if (toleranceArg != nullptr) {
+        int tolerance = atoi(toleranceArg);
+        if (tolerance < 0 || tolerance > 50) {
+            sendResponse("Usage: pll [tolerance%] (0-50)\r\n");
+            return;
+        }
+        pll->setTolerance((uint8_t)tolerance);
+    }
+    
+    char msg[128];
+    snprintf(msg, sizeof(msg), "Write PLL: tolerance +/-%u%%, nominal cell %lu ticks, last cell %lu ticks\r\n",
+             pll->getTolerance(), (unsigned long)pll->getNominalCellTicks(), (unsigned long)pll->getCellTicks());
+    sendResponse(msg);
+}
+
+void CLIHandler::handlePLLTest(const char* jitterArg) {
+    if (!floppyEmulator) {
+        sendResponse("Floppy emulator not initialized\r\n");
+        return;
+    }
+    
+    uint32_t jitter = 10;
+    if (jitterArg != nullptr) {
+        jitter = (uint32_t)atoi(jitterArg);
+        if (jitter > 40) {
+            sendResponse("Usage: plltest [jitter%] (0-40)\r\n");
+            return;
+        }
+    }
+    
+    FluxPLL* pll = GET_FLOPPY()->getWritePLL();
+    static const int32_t speeds[] = { -50, -25, 0, 25, 50 };  // Permille: -5% .. +5%
+    char msg[128];
+    
+    for (uint32_t i = 0; i < sizeof(speeds) / sizeof(speeds[0]); i++) {
+        FluxPLLTestResult result;
+        FluxPLL::runSyntheticTest(pll->getNominalCellTicks(), pll->getTolerance(), speeds[i], jitter, 1024, &result);
+        
+        // Error rate in parts per million
+        uint32_t ppm = result.bitsSent ? (uint32_t)(((uint64_t)result.bitErrors * 1000000) / result.bitsSent) : 0;
+        snprintf(msg, sizeof(msg), "Speed %+ld.%ld%% jitter %lu%%: %lu/%lu bit errors (%lu ppm), cell %lu ticks\r\n",
+                 (long)(speeds[i] / 10), (long)(speeds[i] < 0 ? -speeds[i] % 10 : speeds[i] % 10),
+                 (unsigned long)jitter, (unsigned long)result.bitErrors, (unsigned long)result.bitsSent,
+                 (unsigned long)ppm, (unsigned long)result.finalCellTicks);
+        sendResponse(msg);
+    }
+}
+
+void CLIHandler::handleTrackCache(const char* arg) {
+    if (!floppyEmulator) {
+        sendResponse("Floppy emulator not initialized\r\n");
+        return;
+    }
+    
+    if (arg != nullptr) {
+        if (strcmp(arg, "reset") != 0) {
+            sendResponse("Usage: tcache [reset]\r\n");
+            return;
+        }
+        GET_FLOPPY()->resetTrackCacheStats();
+        sendResponse("Track cache counters reset\r\n");
+        return;
+    }
+    
+    GCRTrackCacheStats stats;
+    GET_FLOPPY()->getTrackCacheStats(&stats);
+    
+    char msg[128];
+    uint32_t lookups = stats.hits + stats.misses;
+    uint32_t hitRate = lookups ? (stats.hits * 100) / lookups : 0;
+    snprintf(msg, sizeof(msg), "Track cache: %lu hits, %lu misses (%lu%% hit rate)\r\n",
+             (unsigned long)stats.hits, (unsigned long)stats.misses, (unsigned long)hitRate);
+    sendResponse(msg);
+    snprintf(msg, sizeof(msg), "Prefetch: %lu tracks filled on core1, %lu used, direction %d\r\n",
+             (unsigned long)stats.prefetches, (unsigned long)stats.prefetchHits, stats.direction);
+    sendResponse(msg);
+    
+    for (int i = 0; i < GCR_TRACK_CACHE_SLOTS; i++) {
+        if (stats.slotTrack[i] >= 0) {
+            snprintf(msg, sizeof(msg), "  Slot %d: track %d%s\r\n", i, stats.slotTrack[i],
+                     i == stats.frontSlot ? " (streaming)" : "");
+        } else {
+            snprintf(msg, sizeof(msg), "  Slot %d: empty%s\r\n", i, i == stats.frontSlot ? " (streaming)" : "");
+        }
+        sendResponse(msg);
+    }
+}
+
+void CLIHandler::handleSDBench(const char* trackArg) {
+    if (!sdCardManager || !GET_SD()->isInitialized()) {
+        sendResponse("SD card not initialized\r\n");
+        return;
+    }
+    if (!floppyEmulator || GET_FLOPPY()->getCurrentFileName()[0] == 0) {
+        sendResponse("No disk image loaded\r\n");
+        return;
+    }
+    
+    int track = 17;
+    if (trackArg != nullptr) {
+        track = atoi(trackArg);
+        if (track < 0 || track >= APPLE_II_TRACKS) {
+            sendResponse("Usage: sdbench [track] (0-34)\r\n");
+            return;
+        }
+    }
+    
+    FloppyEmulator* floppy = GET_FLOPPY();
+    uint32_t trackSize = (floppy->getCurrentFileType() == DISK_FILE_TYPE_NIC) ? APPLE_II_NIC_BYTES_PER_TRACK : APPLE_II_BYTES_PER_TRACK;
+    SDWriteBenchResult result;
+    char msg[128];
+    
+    snprintf(msg, sizeof(msg), "Rewriting track %d of %s (%lu bytes)...\r\n", track, floppy->getCurrentFileName(), (unsigned long)trackSize);
+    sendResponse(msg);
+    if (!GET_SD()->benchmarkTrackWrite(floppy->getCurrentFile(), track, trackSize, &result)) {
+        sendResponse("Track write benchmark failed\r\n");
+        return;
+    }
+    
+    snprintf(msg, sizeof(msg), "Read-modify-write (CMD24): %lu us\r\n", (unsigned long)result.legacyUs);
+    sendResponse(msg);
+    snprintf(msg, sizeof(msg), "Multi-block (ACMD23+CMD25): %lu us\r\n", (unsigned long)result.multiBlockUs);
+    sendResponse(msg);
+    if (result.multiBlockUs > 0) {
+        snprintf(msg, sizeof(msg), "Speedup: %lu.%02lux\r\n", (unsigned long)(result.legacyUs / result.multiBlockUs),
+                 (unsigned long)((result.legacyUs % result.multiBlockUs) * 100 / result.multiBlockUs));
+        sendResponse(msg);
+    }
+}
+
+void CLIHandler::handleSDAsync(const char* arg, const char* blockArg, const char* countArg) {
+    char msg[128];
+    
+    if (!sdCardManager) {
+        sendResponse("SD card not initialized\r\n");
+        return;
+    }
+    SDAsyncEngine* engine = GET_SD()->getAsyncEngine();
+    
+    if (arg == nullptr) {
+        SDAsyncStats stats;
+        engine->getStats(&stats);
+        snprintf(msg, sizeof(msg), "Async SD: %lu submitted, %lu completed, %lu pending\r\n",
+                 (unsigned long)stats.submitted, (unsigned long)stats.completed, (unsigned long)engine->getPending());
+        sendResponse(msg);
+        snprintf(msg, sizeof(msg), "  %lu errors, %lu cancelled, %lu rejected (queue full), %lu polls\r\n",
+                 (unsigned long)stats.errors, (unsigned long)stats.cancelled, (unsigned long)stats.rejected,
+                 (unsigned long)stats.polls);
+        sendResponse(msg);
+        return;
+    }
+    
+    if (strcmp(arg, "reset") == 0) {
+        engine->resetStats();
+        sendResponse("Async SD counters reset\r\n");
+        return;
+    }
+    
+    if (strcmp(arg, "read") != 0 || blockArg == nullptr) {
+        sendResponse("Usage: sdasync [reset|read <block> [count]]\r\n");
+        return;
+    }
+    if (!GET_SD()->isInitialized()) {
+        sendResponse("SD card not initialized\r\n");
+        return;
+    }
+    
+    // Queue a read and drive the engine from here (CLI runs on core1, same as the engine)
+    // The data goes to the FAT32 index scratch buffer - no RAM of its own for a debug command
+    uint32_t scratchSize = 0;
+    uint8_t* readBuffer = GET_SD()->getFAT32() ? GET_SD()->getFAT32()->getScratchBuffer(&scratchSize) : nullptr;
+    if (readBuffer == nullptr || scratchSize < 8 * SD_BLOCK_SIZE) {
+        sendResponse("No FAT32 volume mounted\r\n");
+        return;
+    }
+    uint32_t block = strtoul(blockArg, nullptr, 0);
+    uint32_t count = countArg ? strtoul(countArg, nullptr, 0) : 1;
+    if (count < 1 || count > 8) {
+        sendResponse("Count must be 1-8\r\n");
+        return;
+    }
+    
+    SDAsyncStats before;
+    engine->getStats(&before);
+    absolute_time_t start = get_absolute_time();
+    uint32_t id = engine->submitRead(block, readBuffer, count);
+    if (id == 0) {
+        sendResponse("Async queue full\r\n");
+        return;
+    }
+    while (engine->poll()) {
+    }
+    uint32_t elapsedUs = (uint32_t)absolute_time_diff_us(start, get_absolute_time());
+    
+    SDAsyncStats after;
+    engine->getStats(&after);
+    bool ok = after.errors == before.errors;
+    snprintf(msg, sizeof(msg), "Read %lu block(s) at %lu: %s in %lu us (%lu polls)\r\n",
+             (unsigned long)count, (unsigned long)block, ok ? "OK" : "ERROR", (unsigned long)elapsedUs,
+             (unsigned long)(after.polls - before.polls));
+    sendResponse(msg);
+    if (ok) {
+        char* p = msg;
+        for (int i = 0; i < 16; i++) {
+            p += snprintf(p, sizeof(msg) - (p - msg), "%02X ", readBuffer[i]);
+        }
+        snprintf(p, sizeof(msg) - (p - msg), "...\r\n");
+        sendResponse(msg);
+    }
+}
+
+void CLIHandler::handleDirIndex(const char* arg) {
+    if (!sdCardManager || !GET_SD()->isInitialized() || !GET_SD()->getFAT32()) {
+        sendResponse("SD card not initialized\r\n");
+        return;
+    }
+    FAT32* fat32 = GET_SD()->getFAT32();
+    char msg[128];
+    
+    if (arg != nullptr) {
+        if (strcmp(arg, "on") == 0) {
+            fat32->setDirIndexEnabled(true);
+        } else if (strcmp(arg, "off") == 0) {
+            fat32->setDirIndexEnabled(false);
+        } else if (strcmp(arg, "rebuild") == 0) {
+            fat32->rebuildDirIndex();
+        } else {
+            sendResponse("Usage: dirindex [on|off|rebuild]\r\n");
+            return;
+        }
+    }
+    
+    // List the first page - (re)builds or checks the index of the current directory
+    FAT32_ListEntry page[1];
+    uint32_t count = 0;
+    uint32_t total = 0;
+    uint32_t passesBefore = fat32->getListPasses();
+    uint32_t startTime = time_us_32();
+    if (!fat32->listFilesPage(0, page, 1, &count, &total)) {
+        sendResponse("Failed to read directory\r\n");
+        return;
+    }
+    
+    snprintf(msg, sizeof(msg), "Directory index: %s (%d+ entries), %lu built since mount\r\n",
+             fat32->isDirIndexEnabled() ? "enabled" : "disabled", FAT32_INDEX_MIN_ENTRIES,
+             (unsigned long)fat32->getIndexBuilds());
+    sendResponse(msg);
+    snprintf(msg, sizeof(msg), "Current directory: %lu entries, listed %s (%lu ms, %lu directory passes)\r\n",
+             (unsigned long)total, fat32->isListFromIndex() ? "from index" : "by scanning",
+             (unsigned long)((time_us_32() - startTime) / 1000),
+             (unsigned long)(fat32->getListPasses() - passesBefore));
+    sendResponse(msg);
+}
+
+void CLIHandler::handleRPM(const char* arg) {
+    if (!floppyEmulator) {
+        sendResponse("Floppy emulator not initialized\r\n");
+        return;
+    }
+    
+    FloppyEmulator* floppy = GET_FLOPPY();
+    char msg[160];
+    
+    if (arg != nullptr && strcmp(arg, "measure") == 0) {
+        ReadCellMeasurement m;
+        if (!floppy->measureReadBitCell(&m)) {
+            sendResponse("Measurement failed (stream stopped, no free PIO SM, or no pulses on READ)\r\n");
+            return;
+        }
+        int32_t ppm = (int32_t)(((int64_t)m.cellPs - (int64_t)m.expectedPs) * 1000000 / (int64_t)m.expectedPs);
+        snprintf(msg, sizeof(msg), "Bit cell: %lu.%03lu us measured, %lu.%03lu us expected (%+ld ppm) over %lu cells\r\n",
+                 (unsigned long)(m.cellPs / 1000000), (unsigned long)(m.cellPs / 1000 % 1000),
+                 (unsigned long)(m.expectedPs / 1000000), (unsigned long)(m.expectedPs / 1000 % 1000),
+                 (long)ppm, (unsigned long)m.cells);
+        sendResponse(msg);
+        snprintf(msg, sizeof(msg), "Pulse width: %lu.%03lu us (%lu edges)%s\r\n",
+                 (unsigned long)(m.pulsePs / 1000000), (unsigned long)(m.pulsePs / 1000 % 1000),
+                 (unsigned long)m.edges, m.overrun ? " - OVERRUN, edges dropped" : "");
+        sendResponse(msg);
+        return;
+    }
+    
+    if (arg != nullptr) {
+        int rpm = atoi(arg);
+        if (!floppy->setReadRPM(rpm > 0 ? (uint32_t)rpm : 0)) {
+            snprintf(msg, sizeof(msg), "Usage: rpm [rpm|measure] (%d-%d)\r\n", FLOPPY_RPM_MIN, FLOPPY_RPM_MAX);
+            sendResponse(msg);
+            return;
+        }
+    }
+    
+    uint32_t cellPs = floppy->getReadCellPs();
+    uint32_t div = floppy->getReadClockDivider();
+    snprintf(msg, sizeof(msg), "Read stream: %lu RPM, bit cell %lu.%03lu us (PIO divider %lu + %lu/256, clk_sys %lu Hz)\r\n",
+             (unsigned long)floppy->getReadRPM(), (unsigned long)(cellPs / 1000000), (unsigned long)(cellPs / 1000 % 1000),
+             (unsigned long)(div >> 8), (unsigned long)(div & 0xFF), (unsigned long)clock_get_hz(clk_sys));
+    sendResponse(msg);
+}
@@ -4,6 +4,7 @@
 #include "pico/stdlib.h"
 #include "hardware/uart.h"
 #include "PinConfig.h"
+#include "FAT32.h"
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -33,6 +34,7 @@ private:
     void handleHelp();
     void handleLoad(const char* filename);
     void handleList();
+    static bool sendListEntry(const FAT32_ListEntry* entry, void* context);  // FAT32::listAll() callback
     void handleInfo();
     void handleStatus();
     void handleSeek(int track);
@@ -42,6 +44,14 @@ private:
     void handleChangeDirectory(const char* dirname);
     void handlePrintWorkingDirectory();
     void handleTest();
+    void handleGCRMode(const char* mode);
+    void handlePLL(const char* toleranceArg);
+    void handlePLLTest(const char* jitterArg);
+    void handleTrackCache(const char* arg);
+    void handleSDBench(const char* trackArg);
+    void handleSDAsync(const char* arg, const char* blockArg, const char* countArg);
+    void handleDirIndex(const char* arg);
+    void handleRPM(const char* arg);
     
     // Use void* to avoid circular dependencies
     void* floppyEmulator;
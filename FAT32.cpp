@@ -3,6 +3,48 @@
 #include <string.h>
 #include <ctype.h>
 #include <stdio.h>
+#include <stdlib.h>
+
+// Incremented by every init() - FAT32File handles from an earlier mount are rejected
+// (global: SDCardManager re-creates the FAT32 object after a card swap)
+static uint32_t g_fat32MountCount = 0;
+
+// Case-insensitive string comparison for sorting
+static int strcasecmp_sort(const char* s1, const char* s2) {
+    while (*s1 && *s2) {
+        char c1 = (*s1 >= 'A' && *s1 <= 'Z') ? (*s1 + 32) : *s1;
+        char c2 = (*s2 >= 'A' && *s2 <= 'Z') ? (*s2 + 32) : *s2;
+        if (c1 != c2) {
+            return c1 - c2;
+        }
+        s1++;
+        s2++;
+    }
+    return *s1 - *s2;
+}
+
+// 8.3 directory name ("NAME    EXT") as "NAME.EXT"
+static void format83Display(const uint8_t* name83, char* out) {
+    int nameIdx = 0;
+    
+    // Copy name (8 chars)
+    for (int j = 0; j < 8; j++) {
+        if (name83[j] != ' ') {
+            out[nameIdx++] = name83[j];
+        }
+    }
+    
+    // Add extension if present
+    if (name83[8] != ' ') {
+        out[nameIdx++] = '.';
+        for (int j = 8; j < 11; j++) {
+            if (name83[j] != ' ') {
+                out[nameIdx++] = name83[j];
+            }
+        }
+    }
+    out[nameIdx] = 0;
+}
 
 // Constructor
 FAT32::FAT32(SDCardManager* sdCardManager) {
@@ -18,6 +60,40 @@ FAT32::FAT32(SDCardManager* sdCardManager) {
     memset(currentPath, 0, sizeof(currentPath));
     strcpy(currentPath, "/");
     lastError = FAT32_OK;
+    fatCacheClock = 0;
+    fatCacheStats.hits = 0;
+    fatCacheStats.misses = 0;
+    invalidateFATCache();
+    memset(&nameFile, 0, sizeof(nameFile));
+    mountId = 0;
+    memset(&scanIter, 0, sizeof(scanIter));
+    listWindowStart = 0;
+    listWindowCount = 0;
+    listTotal = 0;
+    listDirCluster = 0;
+    listMountId = 0;
+    listPasses = 0;
+    listSignature = 0;
+    dirIndexEnabled = FAT32_DIR_INDEX_DEFAULT;
+    listFromIndex = false;
+    indexRebuild = false;
+    memset(&indexFile, 0, sizeof(indexFile));
+    indexDataSector = 0;
+    indexBuilds = 0;
+    indexEntryFound = false;
+    indexEntrySector = 0;
+    indexEntryIndex = 0;
+    freeSlotSector = 0;
+    freeSlotIndex = 0;
+    freeClusterHint = 2;
+    indexOrphanCluster = 0;
+    dirCacheCount = 0;
+    dirCacheCluster = 0;
+    dirCacheMountId = 0;
+    dirCacheComplete = false;
+    dirCacheEvict = 0;
+    memset(&dirCacheStats, 0, sizeof(dirCacheStats));
+    multiBlockWrite = true;
 }
 
 // Detect filesystem type from boot sector
@@ -148,6 +224,11 @@ static uint32_t findFirstPartition(uint8_t* mbrBuffer) {
 // Initialize FAT32 filesystem
 bool FAT32::init() {
     lastError = FAT32_OK;
+    invalidateFATCache();  // New card / new mount
+    mountId = ++g_fat32MountCount;  // Invalidates handles opened on an earlier mount
+    listDirCluster = 0;             // and the listing window
+    invalidateDirCache();
+    freeClusterHint = 2;
     
     if (!sdCard) {
         lastError = FAT32_ERROR_NO_SDCARD;
@@ -278,8 +359,8 @@ uint32_t FAT32::readFATEntry(uint32_t cluster) {
     uint32_t fatSector = partitionStartSector + fatStartSector + (fatOffset / 512);
     uint32_t fatEntryOffset = fatOffset % 512;
     
-    uint8_t fatBuffer[512];
-    if (!sdCard->readBlock(fatSector, fatBuffer)) {
+    const uint8_t* fatBuffer = getFATSector(fatSector);
+    if (!fatBuffer) {
         return FAT32_CLUSTER_EOF_MIN;
     }
     
@@ -293,22 +374,368 @@ uint32_t FAT32::readFATEntry(uint32_t cluster) {
     return nextCluster & 0x0FFFFFFF;
 }
 
-// Read a cluster
-bool FAT32::readCluster(uint32_t cluster, uint8_t* buffer) {
-    if (!sdCard || !buffer) {
+// Return a FAT sector from the cache, reading it into the least recently used entry on a miss
+const uint8_t* FAT32::getFATSector(uint32_t sector) {
+    int victim = 0;
+    for (int i = 0; i < FAT32_FAT_CACHE_SECTORS; i++) {
+        if (fatCacheSector[i] == sector) {
+            fatCacheLastUse[i] = ++fatCacheClock;
+            fatCacheStats.hits++;
+            return fatCacheData[i];
+        }
+        if (fatCacheSector[i] == 0xFFFFFFFF ||
+            (fatCacheSector[victim] != 0xFFFFFFFF && fatCacheLastUse[i] < fatCacheLastUse[victim])) {
+            victim = i;
+        }
+    }
+    
+    fatCacheStats.misses++;
+    if (!sdCard->readBlock(sector, fatCacheData[victim])) {
+        fatCacheSector[victim] = 0xFFFFFFFF;
+        return nullptr;
+    }
+    fatCacheSector[victim] = sector;
+    fatCacheLastUse[victim] = ++fatCacheClock;
+    return fatCacheData[victim];
+}
+
+void FAT32::invalidateFATCache() {
+    for (int i = 0; i < FAT32_FAT_CACHE_SECTORS; i++) {
+        fatCacheSector[i] = 0xFFFFFFFF;
+        fatCacheLastUse[i] = 0;
+    }
+}
+
+// Keep cached FAT sectors identical to the card after a write through this driver
+// (file data never overlaps the FAT on a sane volume - this guards a corrupt chain
+// from serving stale entries)
+void FAT32::updateFATCache(uint32_t sector, const uint8_t* data, uint32_t count) {
+    for (int i = 0; i < FAT32_FAT_CACHE_SECTORS; i++) {
+        if (fatCacheSector[i] >= sector && fatCacheSector[i] - sector < count) {
+            memcpy(fatCacheData[i], data + (fatCacheSector[i] - sector) * 512, 512);
+        }
+    }
+}
+
+// Clusters in the data region (valid cluster numbers are 2 .. count + 1)
+uint32_t FAT32::getClusterCount() const {
+    return (bootSector.total_sectors_32 - dataStartSector) / sectorsPerCluster;
+}
+
+// Write a modified FAT sector (partition-relative numbering of FAT copy 0) to every FAT copy
+bool FAT32::writeFATSector(uint32_t sector, const uint8_t* data) {
+    for (uint32_t fat = 0; fat < bootSector.num_fats; fat++) {
+        if (!sdCard->writeBlock(sector + fat * bootSector.sectors_per_fat_32, data)) {
+            return false;
+        }
+    }
+    updateFATCache(sector, data, 1);
+    return true;
+}
+
+// Set one FAT entry (read-modify-write of its sector, upper 4 reserved bits kept)
+bool FAT32::writeFATEntry(uint32_t cluster, uint32_t value) {
+    uint32_t fatOffset = cluster * 4;
+    uint32_t fatSector = partitionStartSector + fatStartSector + (fatOffset / 512);
+    const uint8_t* cached = getFATSector(fatSector);
+    if (!cached) {
+        return false;
+    }
+    
+    static uint8_t sectorBuffer[512];
+    memcpy(sectorBuffer, cached, 512);
+    uint8_t* p = sectorBuffer + (fatOffset % 512);
+    value = (value & 0x0FFFFFFF) | ((uint32_t)(p[3] & 0xF0) << 24);
+    p[0] = value & 0xFF;
+    p[1] = (value >> 8) & 0xFF;
+    p[2] = (value >> 16) & 0xFF;
+    p[3] = (value >> 24) & 0xFF;
+    return writeFATSector(fatSector, sectorBuffer);
+}
+
+// First cluster of count consecutive free clusters at or after the allocation hint (0 = none)
+uint32_t FAT32::findFreeRun(uint32_t count) {
+    uint32_t maxCluster = getClusterCount() + 1;
+    uint32_t runStart = 0;
+    uint32_t runLength = 0;
+    uint32_t start = (freeClusterHint >= 2 && freeClusterHint <= maxCluster) ? freeClusterHint : 2;
+    
+    for (uint32_t cluster = start; cluster <= maxCluster; cluster++) {
+        if (readFATEntry(cluster) == FAT32_CLUSTER_FREE) {
+            if (runLength == 0) {
+                runStart = cluster;
+            }
+            if (++runLength == count) {
+                return runStart;
+            }
+        } else {
+            runLength = 0;
+        }
+    }
+    return 0;
+}
+
+// Append count free clusters to the chain ending at prevCluster (0 = start a new chain)
+// The FAT is searched from the end of the last allocation; every FAT sector touched is written
+// once, plus once more where the chain crosses into the next sector
+bool FAT32::allocateClusters(uint32_t count, uint32_t prevCluster, uint32_t* firstCluster) {
+    static uint8_t sectorBuffer[512];
+    uint32_t maxCluster = getClusterCount() + 1;
+    uint32_t bufferSector = 0;      // FAT sector in sectorBuffer (0 = none)
+    bool dirty = false;
+    uint32_t tail = prevCluster;
+    uint32_t allocated = 0;
+    uint32_t linkFrom = 0;          // Link into a FAT sector not written yet - set once it is,
+    uint32_t linkTo = 0;            // so an interrupted allocation never points at a free cluster
+    *firstCluster = 0;
+    
+    // Prefer one contiguous run (a fragmented file past FAT32_MAX_EXTENTS needs chain walks),
+    // else take free clusters as they come from the hint on
+    uint32_t cluster = findFreeRun(count);
+    if (cluster == 0) {
+        cluster = (freeClusterHint >= 2 && freeClusterHint <= maxCluster) ? freeClusterHint : 2;
+    }
+    for (uint32_t checked = 0; checked < maxCluster - 1 && allocated < count; checked++) {
+        uint32_t fatSector = partitionStartSector + fatStartSector + (cluster * 4) / 512;
+        if (fatSector != bufferSector) {
+            if (dirty && !writeFATSector(bufferSector, sectorBuffer)) {
+                return false;
+            }
+            if (linkFrom != 0) {
+                if (!writeFATEntry(linkFrom, linkTo)) {
+                    return false;
+                }
+                linkFrom = 0;
+            }
+            const uint8_t* cached = getFATSector(fatSector);
+            if (!cached) {
+                return false;
+            }
+            memcpy(sectorBuffer, cached, 512);
+            bufferSector = fatSector;
+            dirty = false;
+        }
+        
+        uint8_t* p = sectorBuffer + (cluster * 4) % 512;
+        uint32_t value = p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+        if ((value & 0x0FFFFFFF) == FAT32_CLUSTER_FREE) {
+            // New end of chain
+            value = (value & 0xF0000000) | FAT32_CLUSTER_EOF_MAX;
+            p[0] = value & 0xFF;
+            p[1] = (value >> 8) & 0xFF;
+            p[2] = (value >> 16) & 0xFF;
+            p[3] = (value >> 24) & 0xFF;
+            dirty = true;
+            
+            // Link the previous end to it
+            if (tail != 0) {
+                uint32_t tailSector = partitionStartSector + fatStartSector + (tail * 4) / 512;
+                if (tailSector == bufferSector) {
+                    uint8_t* t = sectorBuffer + (tail * 4) % 512;
+                    t[0] = cluster & 0xFF;
+                    t[1] = (cluster >> 8) & 0xFF;
+                    t[2] = (cluster >> 16) & 0xFF;
+                    t[3] = (t[3] & 0xF0) | ((cluster >> 24) & 0x0F);
+                } else {
+                    linkFrom = tail;
+                    linkTo = cluster;
+                }
+            }
+            if (*firstCluster == 0) {
+                *firstCluster = cluster;
+            }
+            tail = cluster;
+            allocated++;
+        }
+        
+        cluster = (cluster >= maxCluster) ? 2 : cluster + 1;
+    }
+    if (dirty && !writeFATSector(bufferSector, sectorBuffer)) {
+        return false;
+    }
+    if (linkFrom != 0 && !writeFATEntry(linkFrom, linkTo)) {
+        return false;
+    }
+    if (allocated < count) {
+        printf("allocateClusters: volume full (%lu of %lu clusters)\r\n",
+               (unsigned long)allocated, (unsigned long)count);
+        return false;
+    }
+    freeClusterHint = tail + 1;
+    invalidateFSInfo();
+    return true;
+}
+
+// Free a cluster chain (every entry set to FAT32_CLUSTER_FREE) - each FAT sector of the chain is
+// written once per visit, like allocateClusters()
+bool FAT32::freeClusterChain(uint32_t cluster) {
+    static uint8_t sectorBuffer[512];
+    uint32_t bufferSector = 0;      // FAT sector in sectorBuffer (0 = none)
+    bool dirty = false;
+    uint32_t maxClusters = getClusterCount();
+    uint32_t freed = 0;
+    
+    while (cluster >= FAT32_CLUSTER_RESERVED_MIN && cluster <= FAT32_CLUSTER_RESERVED_MAX &&
+           freed <= maxClusters) {
+        uint32_t fatSector = partitionStartSector + fatStartSector + (cluster * 4) / 512;
+        if (fatSector != bufferSector) {
+            if (dirty && !writeFATSector(bufferSector, sectorBuffer)) {
+                return false;
+            }
+            const uint8_t* cached = getFATSector(fatSector);
+            if (!cached) {
+                return false;
+            }
+            memcpy(sectorBuffer, cached, 512);
+            bufferSector = fatSector;
+            dirty = false;
+        }
+        
+        uint8_t* p = sectorBuffer + (cluster * 4) % 512;
+        uint32_t next = (p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24)) & 0x0FFFFFFF;
+        p[0] = 0;
+        p[1] = 0;
+        p[2] = 0;
+        p[3] &= 0xF0;
+        dirty = true;
+        if (cluster < freeClusterHint) {
+            freeClusterHint = cluster;
+        }
+        freed++;
+        cluster = next;
+    }
+    if (dirty && !writeFATSector(bufferSector, sectorBuffer)) {
+        return false;
+    }
+    if (freed > 0) {
+        invalidateFSInfo();
+    }
+    return true;
+}
+
+// FSInfo free count is stale after an allocation or free - mark it unknown (it is only a hint)
+// and pass on the next free hint
+void FAT32::invalidateFSInfo() {
+    static uint8_t fsInfo[512];
+    uint32_t fsInfoSector = partitionStartSector + bootSector.fs_info_sector;
+    if (bootSector.fs_info_sector != 0 && sdCard->readBlock(fsInfoSector, fsInfo) &&
+        fsInfo[0] == 0x52 && fsInfo[1] == 0x52 && fsInfo[2] == 0x61 && fsInfo[3] == 0x41) {
+        memset(fsInfo + 488, 0xFF, 4);
+        fsInfo[492] = freeClusterHint & 0xFF;
+        fsInfo[493] = (freeClusterHint >> 8) & 0xFF;
+        fsInfo[494] = (freeClusterHint >> 16) & 0xFF;
+        fsInfo[495] = (freeClusterHint >> 24) & 0xFF;
+        sdCard->writeBlock(fsInfoSector, fsInfo);
+    }
+}
+
+// Overwrite one directory entry in place
+bool FAT32::writeDirEntry(uint32_t sector, uint16_t index, const FAT32_DirEntry* entry) {
+    static uint8_t sectorBuffer[512];
+    if (!sdCard->readBlock(sector, sectorBuffer)) {
+        return false;
+    }
+    memcpy(sectorBuffer + index * 32, entry, 32);
+    invalidateDirCache();
+    if (!sdCard->writeBlock(sector, sectorBuffer)) {
         return false;
     }
+    return true;
+}
+
+// Grow an open file to size bytes: clusters appended to its chain, the directory entry updated and
+// the handle remapped (new bytes are not cleared - the caller writes them before reading)
+bool FAT32::growFile(FAT32File* file, uint32_t size) {
+    uint32_t firstCluster = file->entry.cluster_low | (file->entry.cluster_high << 16);
+    uint32_t needClusters = (size + bytesPerCluster - 1) / bytesPerCluster;
+    
+    // The chain may already be longer than the file size - follow it to its end
+    uint32_t chainClusters = 0;
+    uint32_t lastCluster = 0;
+    uint32_t cluster = firstCluster;
+    uint32_t maxClusters = getClusterCount();
+    while (cluster >= FAT32_CLUSTER_RESERVED_MIN && cluster <= FAT32_CLUSTER_RESERVED_MAX &&
+           chainClusters <= maxClusters) {
+        lastCluster = cluster;
+        chainClusters++;
+        cluster = readFATEntry(cluster);
+    }
+    
+    if (needClusters > chainClusters) {
+        uint32_t count = needClusters - chainClusters;
+        if (lastCluster == 0) {
+            // Empty file: its first cluster goes into the directory entry before the rest is
+            // allocated - an interrupted allocation then leaves a shorter chain owned by the file
+            // (reused by the next growFile()), not clusters no entry points at
+            if (!allocateClusters(1, 0, &firstCluster)) {
+                return false;
+            }
+            file->entry.cluster_low = firstCluster & 0xFFFF;
+            file->entry.cluster_high = (firstCluster >> 16) & 0xFFFF;
+            if (!writeDirEntry(file->entrySector, file->entryIndex, &file->entry)) {
+                freeClusterChain(firstCluster);
+                return false;
+            }
+            lastCluster = firstCluster;
+            count--;
+        }
+        uint32_t newCluster;
+        if (count > 0 && !allocateClusters(count, lastCluster, &newCluster)) {
+            return false;  // Clusters allocated so far are linked to the file's chain
+        }
+    }
     
-    uint32_t startSector = getClusterSector(cluster);
+    file->entry.cluster_low = firstCluster & 0xFFFF;
+    file->entry.cluster_high = (firstCluster >> 16) & 0xFFFF;
+    file->entry.file_size = size;
+    if (!writeDirEntry(file->entrySector, file->entryIndex, &file->entry)) {
+        return false;
+    }
     
-    // Read all sectors in the cluster
-    for (uint32_t i = 0; i < sectorsPerCluster; i++) {
-        if (!sdCard->readBlock(startSector + i, buffer + (i * 512))) {
+    char name[FAT32_FILE_NAME_SIZE];
+    strcpy(name, file->name);
+    return openEntry(name, file->dirCluster, file);
+}
+
+// Shrink an open file to size bytes: its chain ends after the last cluster still needed, the rest
+// is freed, the directory entry updated and the handle remapped
+bool FAT32::truncateFile(FAT32File* file, uint32_t size) {
+    uint32_t firstCluster = file->entry.cluster_low | (file->entry.cluster_high << 16);
+    uint32_t keepClusters = (size + bytesPerCluster - 1) / bytesPerCluster;
+    uint32_t freeFrom = 0;
+    
+    if (keepClusters == 0) {
+        freeFrom = firstCluster;
+        firstCluster = 0;
+    } else {
+        uint32_t lastKept = firstCluster;
+        for (uint32_t i = 1; i < keepClusters; i++) {
+            lastKept = readFATEntry(lastKept);
+            if (lastKept < FAT32_CLUSTER_RESERVED_MIN || lastKept > FAT32_CLUSTER_RESERVED_MAX) {
+                return false;  // Chain shorter than the file claims
+            }
+        }
+        freeFrom = readFATEntry(lastKept);
+        if (freeFrom >= FAT32_CLUSTER_RESERVED_MIN && freeFrom <= FAT32_CLUSTER_RESERVED_MAX &&
+            !writeFATEntry(lastKept, FAT32_CLUSTER_EOF_MAX)) {
             return false;
         }
     }
     
-    return true;
+    // Entry first: if freeing fails, the clusters are lost space - never cross-linked
+    file->entry.cluster_low = firstCluster & 0xFFFF;
+    file->entry.cluster_high = (firstCluster >> 16) & 0xFFFF;
+    file->entry.file_size = size;
+    if (!writeDirEntry(file->entrySector, file->entryIndex, &file->entry)) {
+        return false;
+    }
+    if (!freeClusterChain(freeFrom)) {
+        return false;
+    }
+    
+    char name[FAT32_FILE_NAME_SIZE];
+    strcpy(name, file->name);
+    return openEntry(name, file->dirCluster, file);
 }
 
 // Format filename to 8.3 format
@@ -509,100 +936,337 @@ bool FAT32::readLFNEntries(FAT32_DirEntry* entries, int count, char* lfnBuffer,
     return true;
 }
 
+// Case-insensitive name hashes for the directory entry cache: FNV-1a and djb2 of the lower-case name
+static void hashName(const char* name, uint32_t* hash, uint32_t* hash2) {
+    uint32_t h1 = 2166136261u;
+    uint32_t h2 = 5381;
+    for (const char* p = name; *p; p++) {
+        uint8_t c = (uint8_t)tolower((uint8_t)*p);
+        h1 = (h1 ^ c) * 16777619u;
+        h2 = h2 * 33 + c;
+    }
+    *hash = h1;
+    *hash2 = h2;
+}
+
+// Drop the directory entry cache (directory changed or written)
+void FAT32::invalidateDirCache() {
+    dirCacheCluster = 0;
+    dirCacheCount = 0;
+    dirCacheComplete = false;
+}
+
+// Start filling the cache for a new directory (the caller sets dirCacheCluster once the pass is done)
+void FAT32::dirCacheBegin() {
+    invalidateDirCache();
+    for (int i = 0; i < FAT32_DIR_CACHE_BUCKETS; i++) {
+        dirCacheBuckets[i] = FAT32_DIR_CACHE_END;
+    }
+    dirCacheComplete = true;
+    dirCacheEvict = 0;
+}
+
+// Add an entry under the hash of its name. A full cache marks itself incomplete; with evict the
+// entry replaces a round-robin victim (a lookup result of a large directory)
+void FAT32::dirCacheInsert(const FAT32_DirItem* item, bool evict) {
+    uint32_t slot;
+    if (dirCacheCount < FAT32_DIR_CACHE_ENTRIES) {
+        slot = dirCacheCount++;
+    } else {
+        dirCacheComplete = false;
+        if (!evict) {
+            return;
+        }
+        slot = dirCacheEvict++ % FAT32_DIR_CACHE_ENTRIES;
+        
+        // Unlink the victim from its bucket
+        uint16_t* link = &dirCacheBuckets[dirCache[slot].hash % FAT32_DIR_CACHE_BUCKETS];
+        while (*link != FAT32_DIR_CACHE_END && *link != slot) {
+            link = &dirCache[*link].next;
+        }
+        if (*link == slot) {
+            *link = dirCache[slot].next;
+        }
+    }
+    
+    FAT32_DirCacheEntry* cached = &dirCache[slot];
+    hashName(item->name, &cached->hash, &cached->hash2);
+    cached->nameLength = (uint16_t)strlen(item->name);
+    strncpy(cached->name, item->name, sizeof(cached->name) - 1);
+    cached->name[sizeof(cached->name) - 1] = 0;
+    cached->entry = item->entry;
+    cached->entrySector = item->entrySector;
+    cached->entryIndex = item->entryIndex;
+    uint16_t* bucket = &dirCacheBuckets[cached->hash % FAT32_DIR_CACHE_BUCKETS];
+    cached->next = *bucket;
+    *bucket = (uint16_t)slot;
+}
+
+// Look a name up in the cache: by hash of the (long) name, then by 8.3 name - an alias like
+// "GAMETI~1.DSK" of an entry cached under its long name. A hash match counts only if the
+// cached name compares equal too (a name longer than the cached prefix: prefix, length and
+// both hashes)
+bool FAT32::dirCacheLookup(const char* filename, const char* name83, const FAT32_DirCacheEntry** found) {
+    uint32_t hash;
+    uint32_t hash2;
+    hashName(filename, &hash, &hash2);
+    size_t length = strlen(filename);
+    
+    for (uint16_t i = dirCacheBuckets[hash % FAT32_DIR_CACHE_BUCKETS]; i != FAT32_DIR_CACHE_END; i = dirCache[i].next) {
+        const FAT32_DirCacheEntry* cached = &dirCache[i];
+        if (cached->hash != hash || cached->hash2 != hash2 || cached->nameLength != length) {
+            continue;
+        }
+        char prefix[FAT32_DIR_CACHE_NAME_SIZE];
+        strncpy(prefix, filename, sizeof(prefix) - 1);
+        prefix[sizeof(prefix) - 1] = 0;
+        if (strcasecmp_sort(cached->name, prefix) == 0) {
+            *found = cached;
+            return true;
+        }
+    }
+    for (uint32_t i = 0; i < dirCacheCount; i++) {
+        if (memcmp(dirCache[i].entry.name, name83, 11) == 0) {
+            *found = &dirCache[i];
+            return true;
+        }
+    }
+    return false;
+}
+
 // Find file in directory (supports both 8.3 and LFN)
-bool FAT32::findFileInDirectory(uint32_t dirCluster, const char* filename, FAT32_DirEntry* entry) {
+// The first lookup in a directory caches its entries by name hash (one pass); later lookups of
+// that directory are answered from RAM - also "not found" when the whole directory fit
+bool FAT32::findFileInDirectory(uint32_t dirCluster, const char* filename, FAT32_DirEntry* entry,
+                                uint32_t* entrySector, uint16_t* entryIndex) {
     if (!sdCard || !entry) {
         return false;
     }
     
-    // Use static buffer to avoid stack overflow (16KB is too large for stack)
-    static uint8_t clusterBuffer[512 * 32];  // Max cluster size (32 sectors = 16KB)
-    uint32_t currentCluster = dirCluster;
-    
     // Format filename to 8.3 for comparison
     char name83[11];
     format83Name(filename, name83);
     
-    // Convert filename to lowercase for case-insensitive comparison
-    char filenameLower[256];
-    strncpy(filenameLower, filename, sizeof(filenameLower) - 1);
-    filenameLower[sizeof(filenameLower) - 1] = 0;
-    for (int i = 0; filenameLower[i]; i++) {
-        filenameLower[i] = tolower(filenameLower[i]);
-    }
+    uint32_t cluster = dirCluster ? dirCluster : bootSector.root_cluster;
+    static FAT32_DirItem item;
     
-    // Search through directory clusters
-    while (currentCluster >= FAT32_CLUSTER_RESERVED_MIN && 
-           currentCluster <= FAT32_CLUSTER_RESERVED_MAX) {
-        
-        // Read cluster
-        if (!readCluster(currentCluster, clusterBuffer)) {
-            return false;
-        }
-        
-        // Search entries in this cluster
-        int entriesPerCluster = bytesPerCluster / 32;  // 32 bytes per entry
-        FAT32_DirEntry* dirEntries = (FAT32_DirEntry*)clusterBuffer;
-        
-        for (int i = 0; i < entriesPerCluster; i++) {
-            // Check if entry is valid (first byte != 0x00 and != 0xE5)
-            if (dirEntries[i].name[0] == 0x00) {
-                return false;  // End of directory
+    if (dirCacheCluster != cluster || dirCacheMountId != mountId) {
+        dirCacheBegin();
+        if (openDir(cluster, &scanIter)) {
+            while (readDir(&scanIter, &item)) {
+                dirCacheInsert(&item, false);
             }
-            
-            if (dirEntries[i].name[0] == 0xE5) {
-                continue;  // Deleted entry
+            // A pass cut short by a read error must not answer "not found" from RAM
+            if (!scanIter.error) {
+                dirCacheCluster = cluster;
+                dirCacheMountId = mountId;
+                dirCacheStats.builds++;
             }
-            
-            // Check if it's a long name entry - skip for now, we'll handle it below
-            if (dirEntries[i].attributes == FAT32_ATTR_LONG_NAME) {
-                continue;
+        }
+    }
+    
+    if (dirCacheCluster == cluster && dirCacheMountId == mountId) {
+        const FAT32_DirCacheEntry* cached;
+        if (dirCacheLookup(filename, name83, &cached)) {
+            dirCacheStats.hits++;
+            *entry = cached->entry;
+            if (entrySector) {
+                *entrySector = cached->entrySector;
             }
-            
-            // Try to read LFN if present
-            char lfnName[256];
-            bool hasLFN = false;
-            
-            // Check if there are LFN entries before this one
-            int lfnCount = 0;
-            for (int j = i - 1; j >= 0 && j >= i - 20; j--) {  // Max 20 LFN entries
-                if (dirEntries[j].attributes == FAT32_ATTR_LONG_NAME) {
-                    lfnCount++;
-                } else {
-                    break;
-                }
+            if (entryIndex) {
+                *entryIndex = cached->entryIndex;
             }
-            
-            if (lfnCount > 0) {
-                // Read LFN entries
-                hasLFN = readLFNEntries(&dirEntries[i - lfnCount], lfnCount + 1, lfnName, sizeof(lfnName));
-                if (hasLFN) {
-                    // Convert to lowercase for comparison
-                    for (int k = 0; lfnName[k]; k++) {
-                        lfnName[k] = tolower(lfnName[k]);
-                    }
-                }
+            return true;
+        }
+        if (dirCacheComplete) {
+            dirCacheStats.hits++;
+            return false;
+        }
+    }
+    
+    // Directory larger than the cache - stream it, one entry at a time, any length
+    dirCacheStats.scans++;
+    if (!openDir(cluster, &scanIter)) {
+        return false;
+    }
+    while (readDir(&scanIter, &item)) {
+        // Compare with 8.3 name, then case-insensitive with the long name
+        if (memcmp(item.entry.name, name83, 11) == 0 || strcasecmp_sort(item.name, filename) == 0) {
+            if (dirCacheCluster == cluster && dirCacheMountId == mountId) {
+                dirCacheInsert(&item, true);
             }
-            
-            // Compare with 8.3 name
-            bool match83 = (memcmp(dirEntries[i].name, name83, 11) == 0);
-            
-            // Compare with LFN name
-            bool matchLFN = hasLFN && (strcmp(lfnName, filenameLower) == 0);
-            
-            if (match83 || matchLFN) {
-                *entry = dirEntries[i];
-                return true;
+            *entry = item.entry;
+            if (entrySector) {
+                *entrySector = item.entrySector;
             }
+            if (entryIndex) {
+                *entryIndex = item.entryIndex;
+            }
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+// Start reading a directory at its first entry
+bool FAT32::openDir(uint32_t dirCluster, FAT32_DirIterator* iter) {
+    if (!sdCard || !iter || sectorsPerCluster == 0) {
+        return false;
+    }
+    
+    iter->cluster = dirCluster ? dirCluster : bootSector.root_cluster;
+    iter->sectorInCluster = 0;
+    // A directory can't have more clusters than the volume - stops a looped chain
+    iter->clustersLeft = (bootSector.total_sectors_32 - dataStartSector) / sectorsPerCluster;
+    iter->bufferSector = 0;
+    iter->bufferEntries = 0;
+    iter->entryPos = 0;
+    iter->done = false;
+    iter->error = false;
+    iter->lfnNext = 0;
+    iter->lfnComplete = false;
+    iter->freeSector = 0;
+    iter->freeIndex = 0;
+    return true;
+}
+
+// Read the next directory sectors into the iterator buffer (one multi-block transfer,
+// up to FAT32_DIR_BUFFER_SECTORS, never past the end of the cluster)
+// false at the end of the chain - with iter->error set when a read failed instead
+bool FAT32::loadDirSectors(FAT32_DirIterator* iter) {
+    if (iter->sectorInCluster >= sectorsPerCluster) {
+        // readFATEntry() reports a failed FAT read as end of chain - load the sector first
+        if (!getFATSector(partitionStartSector + fatStartSector + (iter->cluster * 4) / 512)) {
+            iter->error = true;
+            return false;
+        }
+        uint32_t nextCluster = readFATEntry(iter->cluster);
+        if (nextCluster < FAT32_CLUSTER_RESERVED_MIN || nextCluster > FAT32_CLUSTER_RESERVED_MAX) {
+            return false;  // End of chain
+        }
+        if (iter->clustersLeft == 0) {
+            printf("readDir: Directory chain at cluster %lu loops\r\n", (unsigned long)iter->cluster);
+            iter->error = true;
+            return false;
+        }
+        iter->clustersLeft--;
+        iter->cluster = nextCluster;
+        iter->sectorInCluster = 0;
+    }
+    
+    uint32_t count = sectorsPerCluster - iter->sectorInCluster;
+    if (count > FAT32_DIR_BUFFER_SECTORS) {
+        count = FAT32_DIR_BUFFER_SECTORS;
+    }
+    uint32_t sector = getClusterSector(iter->cluster) + iter->sectorInCluster;
+    if (!sdCard->readBlocks(sector, iter->buffer, count)) {
+        printf("readDir: Read of sector %lu failed\r\n", (unsigned long)sector);
+        iter->error = true;
+        return false;
+    }
+    
+    iter->bufferSector = sector;
+    iter->bufferEntries = count * 16;
+    iter->entryPos = 0;
+    iter->sectorInCluster += count;
+    return true;
+}
+
+// Add one LFN entry to the long name being collected
+// LFN entries precede their 8.3 entry from the highest sequence number (bit 6 set) down to 1,
+// each holding 13 characters at position (sequence - 1) * 13
+void FAT32::collectLFN(FAT32_DirIterator* iter, const FAT32_LFNEntry* lfn) {
+    uint8_t seq = lfn->sequence & 0x1F;
+    
+    if (lfn->sequence & 0x40) {
+        // First physical entry - starts a new name
+        memset(iter->lfn, 0, sizeof(iter->lfn));
+        iter->lfnChecksum = lfn->checksum;
+        iter->lfnNext = seq;
+        iter->lfnComplete = false;
+    }
+    
+    if (seq == 0 || seq != iter->lfnNext || lfn->checksum != iter->lfnChecksum) {
+        iter->lfnNext = 0;  // Orphaned or out of order - fall back to the 8.3 name
+        iter->lfnComplete = false;
+        return;
+    }
+    
+    // Packed UTF-16 fields - copy out before indexing
+    uint16_t chars[13];
+    memcpy(chars, lfn->name1, 10);
+    memcpy(chars + 5, lfn->name2, 12);
+    memcpy(chars + 11, lfn->name3, 4);
+    
+    uint32_t pos = (seq - 1) * 13;
+    for (int i = 0; i < 13 && pos < sizeof(iter->lfn) - 1; i++, pos++) {
+        if (chars[i] == 0x0000 || chars[i] == 0xFFFF) {
+            break;  // End of name
+        }
+        // Convert UTF-16 to ASCII (simplified - only handles ASCII range)
+        iter->lfn[pos] = chars[i] < 0x80 ? (char)chars[i] : '?';
+    }
+    
+    iter->lfnNext = seq - 1;
+    iter->lfnComplete = (seq == 1);
+}
+
+// Next entry of the directory: volume labels are returned too (attributes tell), LFN entries are
+// folded into the name of their 8.3 entry
+bool FAT32::readDir(FAT32_DirIterator* iter, FAT32_DirItem* item) {
+    if (!iter || !item) {
+        return false;
+    }
+    
+    while (!iter->done) {
+        if (iter->entryPos >= iter->bufferEntries && !loadDirSectors(iter)) {
+            iter->done = true;
+            break;
         }
         
-        // Get next cluster
-        currentCluster = readFATEntry(currentCluster);
+        uint32_t pos = iter->entryPos++;
+        const FAT32_DirEntry* dirEntry = (const FAT32_DirEntry*)iter->buffer + pos;
         
-        // Check if we've reached end of chain
-        if (currentCluster >= FAT32_CLUSTER_EOF_MIN) {
+        if (dirEntry->name[0] == 0x00 || dirEntry->name[0] == 0xE5) {
+            // Remember the first free slot (for the directory index file)
+            if (iter->freeSector == 0) {
+                iter->freeSector = iter->bufferSector + pos / 16;
+                iter->freeIndex = (uint16_t)(pos % 16);
+            }
+        }
+        if (dirEntry->name[0] == 0x00) {
+            iter->done = true;  // End of directory
             break;
         }
+        if (dirEntry->name[0] == 0xE5) {
+            iter->lfnNext = 0;  // Deleted entry
+            iter->lfnComplete = false;
+            continue;
+        }
+        if (dirEntry->attributes == FAT32_ATTR_LONG_NAME) {
+            collectLFN(iter, (const FAT32_LFNEntry*)dirEntry);
+            continue;
+        }
+        
+        item->entry = *dirEntry;
+        item->entrySector = iter->bufferSector + pos / 16;
+        item->entryIndex = (uint16_t)(pos % 16);  // 16 entries per sector
+        
+        if (iter->lfnComplete && calculateLFNChecksum(dirEntry->name) == iter->lfnChecksum) {
+            // Long name - trim trailing spaces
+            strcpy(item->name, iter->lfn);
+            int len = strlen(item->name);
+            while (len > 0 && item->name[len - 1] == ' ') {
+                item->name[--len] = 0;
+            }
+        } else {
+            format83Display(dirEntry->name, item->name);
+        }
+        
+        iter->lfnNext = 0;
+        iter->lfnComplete = false;
+        return true;
     }
     
     return false;
@@ -642,6 +1306,7 @@ bool FAT32::changeDirectory(const char* dirname) {
         // Go to root
         currentDirCluster = bootSector.root_cluster;
         strcpy(currentPath, "/");
+        invalidateDirCache();
         return true;
     }
     
@@ -654,6 +1319,7 @@ bool FAT32::changeDirectory(const char* dirname) {
         // For now, just go back to root (parent directory tracking would need more complexity)
         currentDirCluster = bootSector.root_cluster;
         strcpy(currentPath, "/");
+        invalidateDirCache();
         return true;
     }
     
@@ -676,6 +1342,7 @@ bool FAT32::changeDirectory(const char* dirname) {
     
     // Update current directory
     currentDirCluster = dirCluster;
+    invalidateDirCache();
     
     // Update path
     if (strcmp(currentPath, "/") != 0) {
@@ -745,55 +1412,150 @@ uint32_t FAT32::getTotalSizeMB() const {
 }
 
 // Read file
-bool FAT32::readFile(const char* filename, uint8_t* buffer, uint32_t maxSize, uint32_t* bytesRead) {
-    if (!sdCard || !buffer) {
+// Open a file in the current directory: directory entry, its location and the extent map
+// (the cluster chain folded into runs of consecutive sectors). Reads and writes through the
+// handle do no directory I/O and no FAT walk, and keep working after a 'cd'.
+bool FAT32::openFile(const char* filename, FAT32File* file) {
+    if (!sdCard || !filename || !file) {
         return false;
     }
+    file->open = false;
     
-    FAT32_DirEntry entry;
-    if (!findFile(filename, &entry)) {
+    if (!findFileInDirectory(currentDirCluster, filename, &file->entry, &file->entrySector, &file->entryIndex)) {
         return false;
     }
-    
-    // Get file size
-    uint32_t fileSize = entry.file_size;
-    if (fileSize > maxSize) {
-        fileSize = maxSize;
-    }
-    
-    // Get starting cluster
-    uint32_t cluster = entry.cluster_low | (entry.cluster_high << 16);
-    
-    uint32_t bytesReadSoFar = 0;
-    // Use static buffer to avoid stack overflow (16KB is too large for stack)
-    static uint8_t clusterBuffer[512 * 32];  // Max cluster size
-    
-    // Read file cluster by cluster
-    while (cluster >= FAT32_CLUSTER_RESERVED_MIN && 
-           cluster <= FAT32_CLUSTER_RESERVED_MAX &&
-           bytesReadSoFar < fileSize) {
-        
-        // Read cluster
-        if (!readCluster(cluster, clusterBuffer)) {
-            break;
+    return openEntry(filename, currentDirCluster, file);
+}
+
+// Build the extent map of the entry already in file->entry (entrySector / entryIndex set)
+bool FAT32::openEntry(const char* name, uint32_t dirCluster, FAT32File* file) {
+    file->open = false;
+    file->extentCount = 0;
+    uint32_t cluster = file->entry.cluster_low | (file->entry.cluster_high << 16);
+    uint32_t fileSectors = (file->entry.file_size + 511) / 512;
+    uint32_t sectorsMapped = 0;
+    uint32_t lastCluster = cluster;
+    
+    while (sectorsMapped < fileSectors) {
+        if (cluster < FAT32_CLUSTER_RESERVED_MIN || cluster > FAT32_CLUSTER_RESERVED_MAX) {
+            printf("openFile: Cluster chain of '%s' ends early\r\n", name);
+            return false;
         }
         
-        // Copy data from cluster to buffer
-        uint32_t bytesToCopy = bytesPerCluster;
-        if (bytesReadSoFar + bytesToCopy > fileSize) {
-            bytesToCopy = fileSize - bytesReadSoFar;
+        uint32_t lba = getClusterSector(cluster);
+        FAT32_Extent* last = file->extentCount > 0 ? &file->extents[file->extentCount - 1] : nullptr;
+        if (last && last->lba + last->sectors == lba) {
+            last->sectors += sectorsPerCluster;  // Chain stays contiguous - grow the run
+        } else {
+            if (file->extentCount >= FAT32_MAX_EXTENTS) {
+                // Map full - the rest of the file is reached by walking the chain (mapOffset())
+                printf("openFile: '%s' has more than %d fragments - rest follows the cluster chain\r\n",
+                       name, FAT32_MAX_EXTENTS);
+                break;
+            }
+            file->extents[file->extentCount].fileSector = sectorsMapped;
+            file->extents[file->extentCount].lba = lba;
+            file->extents[file->extentCount].sectors = sectorsPerCluster;
+            file->extentCount++;
         }
         
-        memcpy(buffer + bytesReadSoFar, clusterBuffer, bytesToCopy);
-        bytesReadSoFar += bytesToCopy;
-        
-        // Get next cluster
-        cluster = readFATEntry(cluster);
+        sectorsMapped += sectorsPerCluster;
+        lastCluster = cluster;
+        if (sectorsMapped < fileSectors) {
+            cluster = readFATEntry(cluster);
+        }
+    }
+    
+    file->mappedSectors = sectorsMapped;
+    file->tailCluster = lastCluster;
+    file->walkFileSector = sectorsMapped - sectorsPerCluster;
+    file->walkCluster = lastCluster;
+    file->fileSize = file->entry.file_size;
+    file->dirCluster = dirCluster;
+    file->mountId = mountId;
+    strncpy(file->name, name, sizeof(file->name) - 1);
+    file->name[sizeof(file->name) - 1] = 0;
+    file->open = true;
+    return true;
+}
+
+void FAT32::closeFile(FAT32File* file) {
+    if (file) {
+        file->open = false;
+        file->name[0] = 0;
+    }
+}
+
+// Handle was opened on this mount (a re-initialized card may hold different data at its sectors)
+bool FAT32::isFileOpen(const FAT32File* file) const {
+    return file && file->open && file->mountId == mountId;
+}
+
+// Handle for the name-based calls: reopened only when the name or directory changes
+FAT32File* FAT32::openByName(const char* filename) {
+    if (isFileOpen(&nameFile) && nameFile.dirCluster == currentDirCluster &&
+        strlen(filename) < sizeof(nameFile.name) && strcmp(nameFile.name, filename) == 0) {
+        return &nameFile;
+    }
+    return openFile(filename, &nameFile) ? &nameFile : nullptr;
+}
+
+bool FAT32::readFile(const char* filename, uint8_t* buffer, uint32_t maxSize, uint32_t* bytesRead) {
+    FAT32File* file = openByName(filename);
+    if (!file) {
+        return false;
+    }
+    return readFile(file, buffer, maxSize, bytesRead);
+}
+
+bool FAT32::readFile(FAT32File* file, uint8_t* buffer, uint32_t maxSize, uint32_t* bytesRead) {
+    if (!sdCard || !buffer || !isFileOpen(file)) {
+        return false;
+    }
+    
+    // Get file size
+    uint32_t fileSize = file->fileSize;
+    if (fileSize > maxSize) {
+        fileSize = maxSize;
+    }
+    
+    uint32_t bytesReadSoFar = 0;
+    // Last partial sector of the file goes through a bounce buffer (buffer may end mid-sector)
+    static uint8_t sectorBuffer[512];
+    
+    // Read file one extent (run of contiguous clusters) at a time - one CMD18 per extent
+    for (uint32_t i = 0; i < file->extentCount && bytesReadSoFar < fileSize; i++) {
+        const FAT32_Extent* extent = &file->extents[i];
         
-        // Check if we've reached end of file
-        if (cluster >= FAT32_CLUSTER_EOF_MIN) {
+        // Bytes of the file in this extent
+        uint32_t runBytes = extent->sectors * 512;
+        if (bytesReadSoFar + runBytes > fileSize) {
+            runBytes = fileSize - bytesReadSoFar;
+        }
+        
+        // Whole sectors straight into the caller's buffer
+        uint32_t wholeSectors = runBytes / 512;
+        if (wholeSectors > 0 && !sdCard->readBlocks(extent->lba, buffer + bytesReadSoFar, wholeSectors)) {
             break;
         }
+        bytesReadSoFar += wholeSectors * 512;
+        
+        // Tail of the file (less than one sector)
+        uint32_t tailBytes = runBytes - wholeSectors * 512;
+        if (tailBytes > 0) {
+            if (!sdCard->readBlock(extent->lba + wholeSectors, sectorBuffer)) {
+                break;
+            }
+            memcpy(buffer + bytesReadSoFar, sectorBuffer, tailBytes);
+            bytesReadSoFar += tailBytes;
+        }
+    }
+    
+    // Fragments beyond the extent map
+    if (bytesReadSoFar < fileSize && bytesReadSoFar == file->mappedSectors * 512) {
+        uint32_t chainBytes = 0;
+        readFileAtOffset(file, bytesReadSoFar, buffer + bytesReadSoFar, fileSize - bytesReadSoFar, &chainBytes);
+        bytesReadSoFar += chainBytes;
     }
     
     if (bytesRead) {
@@ -803,343 +1565,226 @@ bool FAT32::readFile(const char* filename, uint8_t* buffer, uint32_t maxSize, ui
     return bytesReadSoFar > 0;
 }
 
+// Translate a byte offset of an open file to its card sector (binary search over the extents)
+// sectorsLeft = consecutive sectors from there to the end of the extent
+// Past the extent map (files with more than FAT32_MAX_EXTENTS fragments) the cluster chain is
+// followed from the last mapped cluster - or from the previous walk, so sequential access
+// reads each FAT entry once
+bool FAT32::mapOffset(FAT32File* file, uint32_t offset, uint32_t* lba, uint32_t* sectorsLeft) {
+    if (offset >= file->fileSize || file->extentCount == 0) {
+        return false;
+    }
+    
+    uint32_t fileSector = offset / 512;
+    if (fileSector >= file->mappedSectors) {
+        if (fileSector < file->walkFileSector) {
+            // Behind the cursor - restart at the end of the map
+            file->walkFileSector = file->mappedSectors - sectorsPerCluster;
+            file->walkCluster = file->tailCluster;
+        }
+        while (fileSector - file->walkFileSector >= sectorsPerCluster) {
+            uint32_t nextCluster = readFATEntry(file->walkCluster);
+            if (nextCluster < FAT32_CLUSTER_RESERVED_MIN || nextCluster > FAT32_CLUSTER_RESERVED_MAX) {
+                return false;
+            }
+            file->walkCluster = nextCluster;
+            file->walkFileSector += sectorsPerCluster;
+        }
+        uint32_t sectorInCluster = fileSector - file->walkFileSector;
+        *lba = getClusterSector(file->walkCluster) + sectorInCluster;
+        *sectorsLeft = sectorsPerCluster - sectorInCluster;
+        return true;
+    }
+    
+    uint32_t lo = 0;
+    uint32_t hi = file->extentCount;
+    while (hi - lo > 1) {
+        uint32_t mid = (lo + hi) / 2;
+        if (file->extents[mid].fileSector <= fileSector) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    
+    const FAT32_Extent* extent = &file->extents[lo];
+    uint32_t sectorInExtent = fileSector - extent->fileSector;
+    if (sectorInExtent >= extent->sectors) {
+        return false;
+    }
+    *lba = extent->lba + sectorInExtent;
+    *sectorsLeft = extent->sectors - sectorInExtent;
+    return true;
+}
+
 // Read file at specific offset
 bool FAT32::readFileAtOffset(const char* filename, uint32_t offset, uint8_t* buffer, uint32_t size, uint32_t* bytesRead) {
-    //printf("readFileAtOffset: filename='%s', offset=%u, size=%u\r\n",
-    //       filename ? filename : "(null)", offset, size);
-    
-    if (!sdCard || !buffer || size == 0) {
-        printf("readFileAtOffset: Invalid parameters - sdCard=%p, buffer=%p, size=%u\r\n",
-               sdCard, buffer, size);
+    FAT32File* file = openByName(filename);
+    if (!file) {
+        printf("readFileAtOffset: File '%s' not found\r\n", filename);
         if (bytesRead) *bytesRead = 0;
         return false;
     }
-    
-    FAT32_DirEntry entry;
-    if (!findFile(filename, &entry)) {
-        printf("readFileAtOffset: File '%s' not found\r\n", filename);
+    return readFileAtOffset(file, offset, buffer, size, bytesRead);
+}
+
+bool FAT32::readFileAtOffset(FAT32File* file, uint32_t offset, uint8_t* buffer, uint32_t size, uint32_t* bytesRead) {
+    if (!sdCard || !buffer || size == 0 || !isFileOpen(file)) {
+        printf("readFileAtOffset: Invalid parameters - sdCard=%p, buffer=%p, size=%u\r\n",
+               sdCard, buffer, size);
         if (bytesRead) *bytesRead = 0;
         return false;
     }
     
-    //printf("readFileAtOffset: File found - size=%u, start_cluster=%u\r\n", 
-    //       entry.file_size, entry.cluster_low | (entry.cluster_high << 16));
-    
     // Check if offset is within file bounds
-    if (offset >= entry.file_size) {
-        //printf("readFileAtOffset: Offset %u >= file size %u\r\n", offset, entry.file_size);
+    if (offset >= file->fileSize) {
         if (bytesRead) *bytesRead = 0;
         return false;
     }
     
     // Limit size to remaining file data
-    uint32_t maxSize = entry.file_size - offset;
+    uint32_t maxSize = file->fileSize - offset;
     if (size > maxSize) {
         size = maxSize;
     }
     
-    // Get starting cluster
-    uint32_t cluster = entry.cluster_low | (entry.cluster_high << 16);
-    
-    // Calculate which cluster contains the offset
-    uint32_t clusterOffset = 0;
-    uint32_t currentCluster = cluster;
-    uint32_t bytesPerCluster = this->bytesPerCluster;
-    
-    // Find the cluster containing the offset
-    int clusterCount = 0;
-    while (clusterOffset + bytesPerCluster <= offset && 
-           currentCluster >= FAT32_CLUSTER_RESERVED_MIN && 
-           currentCluster <= FAT32_CLUSTER_RESERVED_MAX) {
-        clusterOffset += bytesPerCluster;
-        currentCluster = readFATEntry(currentCluster);
-        clusterCount++;
-        
-        if (currentCluster >= FAT32_CLUSTER_EOF_MIN) {
-            if (bytesRead) *bytesRead = 0;
-            return false;
-        }
-        
-        if (clusterCount > 100) {
-            if (bytesRead) *bytesRead = 0;
-            return false;
-        }
-    }
-    
-    // Verify cluster is valid
-    if (currentCluster < FAT32_CLUSTER_RESERVED_MIN || 
-        currentCluster > FAT32_CLUSTER_RESERVED_MAX ||
-        currentCluster >= FAT32_CLUSTER_EOF_MIN) {
-        if (bytesRead) *bytesRead = 0;
-        return false;
-    }
-    
-    // Calculate offset within cluster
-    uint32_t offsetInCluster = offset - clusterOffset;
-    
-    // Read data sector by sector
     uint32_t bytesReadSoFar = 0;
     static uint8_t sectorBuffer[512];
     
-    while (bytesReadSoFar < size && 
-           currentCluster >= FAT32_CLUSTER_RESERVED_MIN && 
-           currentCluster <= FAT32_CLUSTER_RESERVED_MAX) {
-        
-        // Calculate which sector in cluster we're reading from
-        uint32_t sectorInCluster = offsetInCluster / 512;
-        uint32_t offsetInSector = offsetInCluster % 512;
-        
-        // Check if sectorInCluster is within cluster bounds
-        if (sectorInCluster >= sectorsPerCluster) {
-            // Move to next cluster
-            uint32_t nextCluster = readFATEntry(currentCluster);
-            if (nextCluster >= FAT32_CLUSTER_EOF_MIN || 
-                nextCluster < FAT32_CLUSTER_RESERVED_MIN || 
-                nextCluster > FAT32_CLUSTER_RESERVED_MAX) {
-                break;
-            }
-            currentCluster = nextCluster;
-            offsetInCluster = 0;
-            sectorInCluster = 0;
-            offsetInSector = 0;
-        }
-        
-        // Verify cluster is still valid
-        if (currentCluster < FAT32_CLUSTER_RESERVED_MIN || 
-            currentCluster > FAT32_CLUSTER_RESERVED_MAX) {
+    while (bytesReadSoFar < size) {
+        uint32_t position = offset + bytesReadSoFar;
+        uint32_t sector;
+        uint32_t sectorsLeft;
+        if (!mapOffset(file, position, &sector, &sectorsLeft)) {
             break;
         }
         
-        // Get sector number
-        uint32_t startSector = getClusterSector(currentCluster);
-        uint32_t sectorToRead = startSector + sectorInCluster;
+        uint32_t offsetInSector = position % 512;
+        uint32_t remaining = size - bytesReadSoFar;
         
-        // Verify sector is within cluster bounds
-        if (sectorInCluster >= sectorsPerCluster) {
-            break;
+        if (offsetInSector == 0 && remaining >= 512) {
+            // Whole sectors up to the end of the extent in one transfer
+            uint32_t wholeSectors = remaining / 512;
+            if (wholeSectors > sectorsLeft) {
+                wholeSectors = sectorsLeft;
+            }
+            if (!sdCard->readBlocks(sector, buffer + bytesReadSoFar, wholeSectors)) {
+                printf("readFileAtOffset: Failed to read sectors %u-%u\r\n", sector, sector + wholeSectors - 1);
+                break;
+            }
+            bytesReadSoFar += wholeSectors * 512;
+            continue;
         }
         
-        // Read sector
-        if (!sdCard->readBlock(sectorToRead, sectorBuffer)) {
-            printf("readFileAtOffset: Failed to read sector %u\r\n", sectorToRead);
+        // Partial sector through the bounce buffer
+        if (!sdCard->readBlock(sector, sectorBuffer)) {
+            printf("readFileAtOffset: Failed to read sector %u\r\n", sector);
             break;
         }
-        
-        // Calculate how many bytes to read from this sector
         uint32_t bytesToRead = 512 - offsetInSector;
-        if (bytesToRead > (size - bytesReadSoFar)) {
-            bytesToRead = size - bytesReadSoFar;
+        if (bytesToRead > remaining) {
+            bytesToRead = remaining;
         }
-        
-        // Copy data from sector buffer
         memcpy(buffer + bytesReadSoFar, sectorBuffer + offsetInSector, bytesToRead);
         bytesReadSoFar += bytesToRead;
-        
-        // Move to next sector/cluster if needed
-        if (bytesReadSoFar < size) {
-            // Move to next sector
-            offsetInCluster += bytesToRead;
-            
-            // Check if we've moved to next cluster
-            if (offsetInCluster >= bytesPerCluster) {
-                // Move to next cluster
-                currentCluster = readFATEntry(currentCluster);
-                if (currentCluster >= FAT32_CLUSTER_EOF_MIN) {
-                    break;
-                }
-                offsetInCluster = 0;  // Reset offset for new cluster
-            }
-        }
     }
     
     if (bytesRead) {
         *bytesRead = bytesReadSoFar;
     }
     
-    //printf("readFileAtOffset: Completed - bytesReadSoFar=%u, requested=%u, success=%d\r\n",
-    //       bytesReadSoFar, size, bytesReadSoFar > 0);
-    
     return bytesReadSoFar > 0;
 }
 
 // Write file at specific offset
 // This function writes data to an existing file at a specific byte offset
 bool FAT32::writeFileAtOffset(const char* filename, uint32_t offset, const uint8_t* buffer, uint32_t size) {
-    if (!sdCard || !buffer || size == 0) {
-        return false;
-    }
-    
-    FAT32_DirEntry entry;
-    if (!findFile(filename, &entry)) {
+    FAT32File* file = openByName(filename);
+    if (!file) {
         return false;  // File not found
     }
-    
-    // Check if file is large enough
-    if (entry.file_size < (offset + size)) {
+    return writeFileAtOffset(file, offset, buffer, size);
+}
+
+bool FAT32::mapFileOffset(FAT32File* file, uint32_t offset, uint32_t* lba, uint32_t* sectorsLeft) {
+    if (!isFileOpen(file) || !lba || !sectorsLeft) {
         return false;
     }
-    
-    // Get starting cluster
-    uint32_t cluster = entry.cluster_low | (entry.cluster_high << 16);
-    
-    // Calculate which cluster contains the offset
-    uint32_t clusterOffset = 0;
-    uint32_t currentCluster = cluster;
-    uint32_t bytesPerCluster = this->bytesPerCluster;
-    uint32_t sectorsPerCluster = this->sectorsPerCluster;
-    
-    // Find the cluster containing the offset
-    int clusterCount = 0;
-    while (clusterOffset + bytesPerCluster <= offset && 
-           currentCluster >= FAT32_CLUSTER_RESERVED_MIN && 
-           currentCluster <= FAT32_CLUSTER_RESERVED_MAX) {
-        clusterOffset += bytesPerCluster;
-        currentCluster = readFATEntry(currentCluster);
-        clusterCount++;
-        
-        if (currentCluster >= FAT32_CLUSTER_EOF_MIN) {
-            return false;
-        }
-        
-        if (clusterCount > 100) {
-            return false;
-        }
-    }
-    
-    // Verify cluster is valid
-    if (currentCluster < FAT32_CLUSTER_RESERVED_MIN || 
-        currentCluster > FAT32_CLUSTER_RESERVED_MAX ||
-        currentCluster >= FAT32_CLUSTER_EOF_MIN) {
+    return mapOffset(file, offset, lba, sectorsLeft);
+}
+
+bool FAT32::writeFileAtOffset(FAT32File* file, uint32_t offset, const uint8_t* buffer, uint32_t size) {
+    if (!sdCard || !buffer || size == 0 || !isFileOpen(file)) {
         return false;
     }
     
-    // Now currentCluster contains the cluster we need to write to
-    // Calculate offset within cluster
-    uint32_t offsetInCluster = offset - clusterOffset;
-    
-    // Verify offsetInCluster is within cluster bounds
-    if (offsetInCluster >= bytesPerCluster) {
+    // Check if file is large enough
+    if (file->fileSize < (offset + size)) {
         return false;
     }
     
-    // Write data sector by sector
     uint32_t bytesWritten = 0;
     static uint8_t sectorBuffer[512];
     
-    while (bytesWritten < size && 
-           currentCluster >= FAT32_CLUSTER_RESERVED_MIN && 
-           currentCluster <= FAT32_CLUSTER_RESERVED_MAX) {
-        
-        // Calculate which sector in cluster we're writing to
-        uint32_t sectorInCluster = offsetInCluster / 512;
-        uint32_t offsetInSector = offsetInCluster % 512;
-        
-        // Check if sectorInCluster is within cluster bounds
-        if (sectorInCluster >= sectorsPerCluster) {
-            // Move to next cluster
-            uint32_t nextCluster = readFATEntry(currentCluster);
-            if (nextCluster >= FAT32_CLUSTER_EOF_MIN || 
-                nextCluster < FAT32_CLUSTER_RESERVED_MIN || 
-                nextCluster > FAT32_CLUSTER_RESERVED_MAX) {
-                break;
-            }
-            currentCluster = nextCluster;
-            offsetInCluster = 0;
-            sectorInCluster = 0;
-            offsetInSector = 0;
-        }
-        
-        // Verify cluster is still valid
-        if (currentCluster < FAT32_CLUSTER_RESERVED_MIN || 
-            currentCluster > FAT32_CLUSTER_RESERVED_MAX) {
-            break;
-        }
-        
-        // Get sector number
-        uint32_t startSector = getClusterSector(currentCluster);
-        uint32_t sectorToWrite = startSector + sectorInCluster;
-        
-        // Verify sector is within cluster bounds
-        if (sectorInCluster >= sectorsPerCluster) {
-            break;
-        }
-        
-        // Always read sector first to preserve existing data
-        // Try multiple times in case of transient read errors
-        bool readSuccess = false;
-        for (int retry = 0; retry < 3; retry++) {
-            if (sdCard->readBlock(sectorToWrite, sectorBuffer)) {
-                readSuccess = true;
-                break;
-            }
-        }
-        
-        if (!readSuccess) {
-            return false;
-        }
-        
-        // Calculate how many bytes to write in this sector
-        uint32_t bytesToWrite = 512 - offsetInSector;
-        if (bytesToWrite > (size - bytesWritten)) {
-            bytesToWrite = size - bytesWritten;
-        }
-        
-        // Copy data to sector buffer
-        memcpy(sectorBuffer + offsetInSector, buffer + bytesWritten, bytesToWrite);
-        
-        // Write sector back
-        if (!sdCard->writeBlock(sectorToWrite, sectorBuffer)) {
+    while (bytesWritten < size) {
+        uint32_t position = offset + bytesWritten;
+        uint32_t sectorToWrite;
+        uint32_t sectorsLeft;
+        if (!mapOffset(file, position, &sectorToWrite, &sectorsLeft)) {
             return false;
         }
         
-        bytesWritten += bytesToWrite;
-        
-        // Move to next sector/cluster if needed
-        if (bytesWritten < size) {
-            // Move to next sector
-            offsetInCluster += bytesToWrite;
-            
-            // Check if we've moved to next cluster
-            if (offsetInCluster >= bytesPerCluster) {
-                // Move to next cluster
-                currentCluster = readFATEntry(currentCluster);
-                if (currentCluster >= FAT32_CLUSTER_EOF_MIN) {
+        uint32_t offsetInSector = position % 512;
+        uint32_t bytesToWrite;
+        if (multiBlockWrite && offsetInSector == 0 && (size - bytesWritten) >= 512) {
+            // Whole sectors are overwritten completely - no read needed
+            // All whole sectors left in this extent go out in one multi-block transfer
+            uint32_t wholeSectors = (size - bytesWritten) / 512;
+            if (wholeSectors > sectorsLeft) {
+                wholeSectors = sectorsLeft;
+            }
+            if (!sdCard->writeBlocks(sectorToWrite, buffer + bytesWritten, wholeSectors)) {
+                return false;
+            }
+            updateFATCache(sectorToWrite, buffer + bytesWritten, wholeSectors);
+            bytesToWrite = wholeSectors * 512;
+        } else {
+            // Partial sector - read it first to preserve existing data
+            // Try multiple times in case of transient read errors
+            bool readSuccess = false;
+            for (int retry = 0; retry < 3; retry++) {
+                if (sdCard->readBlock(sectorToWrite, sectorBuffer)) {
+                    readSuccess = true;
                     break;
                 }
-                offsetInCluster = 0;  // Reset offset for new cluster
             }
+            
+            if (!readSuccess) {
+                return false;
+            }
+            
+            // Calculate how many bytes to write in this sector
+            bytesToWrite = 512 - offsetInSector;
+            if (bytesToWrite > (size - bytesWritten)) {
+                bytesToWrite = size - bytesWritten;
+            }
+            
+            // Copy data to sector buffer
+            memcpy(sectorBuffer + offsetInSector, buffer + bytesWritten, bytesToWrite);
+            
+            // Write sector back
+            if (!sdCard->writeBlock(sectorToWrite, sectorBuffer)) {
+                return false;
+            }
+            updateFATCache(sectorToWrite, sectorBuffer, 1);
         }
-    }
-    
-    if (bytesWritten != size) {
-        return false;
+        
+        bytesWritten += bytesToWrite;
     }
     
     return true;
 }
 
-// List files in current directory
-// Structure to hold file entry for sorting
-// Using smaller name buffer (64 bytes) to save RAM - sufficient for most filenames
-struct FileEntry {
-    char name[64];
-    bool isDirectory;
-};
-
-// Case-insensitive string comparison for sorting
-static int strcasecmp_sort(const char* s1, const char* s2) {
-    while (*s1 && *s2) {
-        char c1 = (*s1 >= 'A' && *s1 <= 'Z') ? (*s1 + 32) : *s1;
-        char c2 = (*s2 >= 'A' && *s2 <= 'Z') ? (*s2 + 32) : *s2;
-        if (c1 != c2) {
-            return c1 - c2;
-        }
-        s1++;
-        s2++;
-    }
-    return *s1 - *s2;
-}
-
 // Helper function to check if file has allowed extension (case-insensitive)
 static bool hasAllowedExtension(const char* filename, const char* ext1, const char* ext2) {
     if (!filename) return false;
@@ -1174,172 +1819,690 @@ static bool hasAllowedExtension(const char* filename, const char* ext1, const ch
     return false;
 }
 
-bool FAT32::listFiles(char* fileList, uint32_t maxSize, uint32_t* fileCount) {
-    if (!sdCard || !fileList) {
+// Directory index build buffer (sorted runs, merge input / output sectors) - also holds pages read
+// from the index (never both at once)
+static uint8_t g_indexScratch[FAT32_INDEX_SCRATCH_SECTORS * 512];
+
+uint8_t* FAT32::getScratchBuffer(uint32_t* size) {
+    *size = sizeof(g_indexScratch);
+    return g_indexScratch;
+}
+
+// Sort order of the listing: directories first, then files, both case-insensitive alphabetical
+// (names are unique case-insensitively within a FAT directory; strcmp() only keeps it total)
+static int compareListEntries(const FAT32_ListEntry* a, const FAT32_ListEntry* b) {
+    if (a->isDirectory != b->isDirectory) {
+        return a->isDirectory ? -1 : 1;
+    }
+    int result = strcasecmp_sort(a->name, b->name);
+    return result != 0 ? result : strcmp(a->name, b->name);
+}
+
+static int compareListEntriesQsort(const void* a, const void* b) {
+    return compareListEntries((const FAT32_ListEntry*)a, (const FAT32_ListEntry*)b);
+}
+
+// Listing entry of a directory item - false if the item is not listed
+// (volume label, index file, file that is not a .dsk / .nic image)
+static bool makeListEntry(const FAT32_DirItem* item, FAT32_ListEntry* listEntry) {
+    if (item->entry.attributes & FAT32_ATTR_VOLUME_ID) {
         return false;
     }
     
-    // Use static buffer to avoid stack overflow (16KB is too large for stack)
-    static uint8_t clusterBuffer[512 * 32];
-    // Static array to hold file entries for sorting (max 64 entries, ~4KB total)
-    // Reduced from 256 to save RAM - sufficient for most directories
-    static FileEntry entries[64];
-    uint32_t entryCount = 0;
-    uint32_t currentCluster = currentDirCluster;
+    // Directories are always shown, files are filtered by extension
+    bool isDirectory = (item->entry.attributes & FAT32_ATTR_DIRECTORY) != 0;
+    if (!isDirectory && !hasAllowedExtension(item->name, "dsk", "nic")) {
+        return false;
+    }
     
-    // First pass: collect all entries
-    while (currentCluster >= FAT32_CLUSTER_RESERVED_MIN && 
-           currentCluster <= FAT32_CLUSTER_RESERVED_MAX &&
-           entryCount < 64) {  // Max 64 entries
-        
-        // Read cluster
-        if (!readCluster(currentCluster, clusterBuffer)) {
-            break;
+    memset(listEntry, 0, sizeof(FAT32_ListEntry));
+    if (strlen(item->name) < sizeof(listEntry->name)) {
+        strcpy(listEntry->name, item->name);
+    } else {
+        format83Display(item->entry.name, listEntry->name);  // Too long - still opens by this name
+    }
+    listEntry->isDirectory = isDirectory;
+    listEntry->fileSize = item->entry.file_size;
+    return true;
+}
+
+// Directory signature: FNV-1a over every listed entry (name, type, size)
+static uint32_t signatureAdd(uint32_t hash, const FAT32_ListEntry* listEntry) {
+    const uint8_t* p = (const uint8_t*)listEntry->name;
+    for (; *p; p++) {
+        hash = (hash ^ *p) * 16777619u;
+    }
+    uint8_t tail[5] = { (uint8_t)listEntry->isDirectory,
+                        (uint8_t)listEntry->fileSize, (uint8_t)(listEntry->fileSize >> 8),
+                        (uint8_t)(listEntry->fileSize >> 16), (uint8_t)(listEntry->fileSize >> 24) };
+    for (int i = 0; i < 5; i++) {
+        hash = (hash ^ tail[i]) * 16777619u;
+    }
+    return hash;
+}
+
+// One pass over the current directory: collect the FAT32_LIST_WINDOW entries that follow anchor
+// (forward) or precede it (backward) in sort order into listWindow, ascending. anchor = nullptr
+// starts at the first entry. Memory is the window plus one directory iterator - the directory
+// itself can be any size. Also counts the listing (listTotal), hashes it (listSignature) and
+// notes the index file entry and a free directory slot.
+bool FAT32::scanListWindow(const FAT32_ListEntry* anchor, bool forward, uint32_t* count) {
+    // Anchor usually points into the window that is about to be overwritten
+    static FAT32_ListEntry anchorCopy;
+    if (anchor) {
+        anchorCopy = *anchor;
+    }
+    
+    listPasses++;
+    listDirCluster = 0;  // Window invalid until the pass completes
+    *count = 0;
+    
+    static FAT32_DirItem item;
+    static FAT32_ListEntry candidate;
+    uint32_t n = 0;
+    uint32_t total = 0;
+    uint32_t signature = 2166136261u;
+    char index83[11];
+    format83Name(FAT32_INDEX_FILE_NAME, index83);
+    indexEntryFound = false;
+    
+    // The pass sees every entry - fill the lookup cache on the way if it holds another directory
+    bool fillDirCache = (dirCacheCluster != currentDirCluster || dirCacheMountId != mountId);
+    if (fillDirCache) {
+        dirCacheBegin();
+    }
+    
+    if (!openDir(currentDirCluster, &scanIter)) {
+        return false;
+    }
+    while (readDir(&scanIter, &item)) {
+        if (fillDirCache) {
+            dirCacheInsert(&item, false);
+        }
+        if (memcmp(item.entry.name, index83, 11) == 0) {
+            indexEntryFound = true;
+            indexEntry = item.entry;
+            indexEntrySector = item.entrySector;
+            indexEntryIndex = item.entryIndex;
+            continue;
         }
+        if (!makeListEntry(&item, &candidate)) {
+            continue;
+        }
+        total++;
+        signature = signatureAdd(signature, &candidate);
         
-        // Search entries in this cluster
-        int entriesPerCluster = bytesPerCluster / 32;
-        FAT32_DirEntry* dirEntries = (FAT32_DirEntry*)clusterBuffer;
+        if (anchor) {
+            int order = compareListEntries(&candidate, &anchorCopy);
+            if (forward ? order <= 0 : order >= 0) {
+                continue;  // On the wrong side of the anchor
+            }
+        }
         
-        for (int i = 0; i < entriesPerCluster; i++) {
-            // Check if entry is valid
-            if (dirEntries[i].name[0] == 0x00) {
-                // End of directory
-                goto sort_and_format;
+        // Bounded insertion: forward keeps the smallest entries (drop from the end),
+        // backward keeps the largest (drop from the front)
+        uint32_t pos;
+        if (n < FAT32_LIST_WINDOW) {
+            pos = n;
+            while (pos > 0 && compareListEntries(&candidate, &listWindow[pos - 1]) < 0) {
+                pos--;
             }
-            
-            if (dirEntries[i].name[0] == 0xE5) {
-                continue;  // Deleted entry
+            memmove(&listWindow[pos + 1], &listWindow[pos], (n - pos) * sizeof(FAT32_ListEntry));
+            n++;
+        } else if (forward) {
+            if (compareListEntries(&candidate, &listWindow[n - 1]) >= 0) {
+                continue;
             }
-            
-            // Check if it's a long name entry - skip, we'll handle it with the 8.3 entry
-            if (dirEntries[i].attributes == FAT32_ATTR_LONG_NAME) {
+            pos = n - 1;
+            while (pos > 0 && compareListEntries(&candidate, &listWindow[pos - 1]) < 0) {
+                pos--;
+            }
+            memmove(&listWindow[pos + 1], &listWindow[pos], (n - 1 - pos) * sizeof(FAT32_ListEntry));
+        } else {
+            if (compareListEntries(&candidate, &listWindow[0]) <= 0) {
                 continue;
             }
-            
-            // Check if it's a volume label
-            if (dirEntries[i].attributes & FAT32_ATTR_VOLUME_ID) {
+            pos = 0;
+            while (pos < n - 1 && compareListEntries(&candidate, &listWindow[pos + 1]) > 0) {
+                pos++;
+            }
+            memmove(&listWindow[0], &listWindow[1], pos * sizeof(FAT32_ListEntry));
+        }
+        listWindow[pos] = candidate;
+    }
+    if (scanIter.error) {
+        return false;  // Count, signature and window of a partial pass would be wrong
+    }
+    
+    if (fillDirCache) {
+        dirCacheCluster = currentDirCluster;
+        dirCacheMountId = mountId;
+        dirCacheStats.builds++;
+    }
+    listTotal = total;
+    listSignature = signature;
+    freeSlotSector = scanIter.freeSector;
+    freeSlotIndex = scanIter.freeIndex;
+    listDirCluster = currentDirCluster;
+    listMountId = mountId;
+    *count = n;
+    return true;
+}
+
+// First listing of a directory (after cd / mount): one pass fills the window and checks the
+// signature; a large directory then lists from its index file, built here if missing or stale
+bool FAT32::prepareListing() {
+    uint32_t scanned;
+    listFromIndex = false;
+    if (!scanListWindow(nullptr, true, &scanned)) {
+        return false;
+    }
+    listWindowStart = 0;
+    listWindowCount = scanned;
+    
+    if (!dirIndexEnabled || listTotal < FAT32_INDEX_MIN_ENTRIES) {
+        return true;
+    }
+    
+    if (!indexRebuild && loadDirIndex()) {
+        listFromIndex = true;
+        return true;
+    }
+    indexRebuild = false;
+    
+    // Clusters a failed build could not free at the time (card writes failing) - retry first
+    if (indexOrphanCluster != 0 && freeClusterChain(indexOrphanCluster)) {
+        indexOrphanCluster = 0;
+    }
+    
+    uint32_t startTime = time_us_32();
+    closeFile(&indexFile);
+    if (buildDirIndex()) {
+        printf("Directory index: %lu entries sorted in %lu ms\r\n",
+               (unsigned long)listTotal, (unsigned long)((time_us_32() - startTime) / 1000));
+        listFromIndex = true;
+    } else {
+        printf("Directory index: build failed - sorting on the fly\r\n");
+        deleteDirIndex();
+    }
+    return true;
+}
+
+// Remove the index file of a failed build: the entry is deleted first, then its chain freed
+// (a failed free leaves lost clusters, never a file pointing at free ones - retried on the next build)
+void FAT32::deleteDirIndex() {
+    if (!isFileOpen(&indexFile)) {
+        return;  // Build failed before the file existed
+    }
+    uint32_t firstCluster = indexFile.entry.cluster_low | (indexFile.entry.cluster_high << 16);
+    indexFile.entry.name[0] = 0xE5;
+    bool deleted = writeDirEntry(indexFile.entrySector, indexFile.entryIndex, &indexFile.entry);
+    closeFile(&indexFile);
+    indexEntryFound = false;
+    if (!deleted) {
+        return;  // Entry still there - the next build reuses it and its clusters
+    }
+    if (firstCluster != 0 && !freeClusterChain(firstCluster)) {
+        indexOrphanCluster = firstCluster;
+    }
+}
+
+// Open the index file found by the last pass and check its header against the directory
+bool FAT32::loadDirIndex() {
+    if (!indexEntryFound) {
+        return false;
+    }
+    indexFile.entry = indexEntry;
+    indexFile.entrySector = indexEntrySector;
+    indexFile.entryIndex = indexEntryIndex;
+    if (!openEntry(FAT32_INDEX_FILE_NAME, currentDirCluster, &indexFile)) {
+        return false;
+    }
+    
+    static FAT32_IndexHeader header;
+    uint32_t bytesRead = 0;
+    if (!readFileAtOffset(&indexFile, 0, (uint8_t*)&header, sizeof(header), &bytesRead) ||
+        bytesRead != sizeof(header)) {
+        return false;
+    }
+    if (memcmp(header.magic, FAT32_INDEX_MAGIC, sizeof(FAT32_INDEX_MAGIC)) != 0 ||
+        header.dirCluster != currentDirCluster || header.signature != listSignature ||
+        header.entryCount != listTotal || header.recordSize != sizeof(FAT32_ListEntry) ||
+        header.dataSector == 0 ||
+        (header.dataSector * 512 + listTotal * sizeof(FAT32_ListEntry)) > indexFile.fileSize) {
+        return false;  // Directory changed since the build (or not our file)
+    }
+    
+    indexDataSector = header.dataSector;
+    return true;
+}
+
+// Build the index of the current directory (listTotal / listSignature from the pass just done):
+// 1. create or grow the index file: header sector + two record regions (merge ping-pong)
+// 2. one directory pass writes sorted runs of FAT32_INDEX_SCRATCH_SECTORS * 4 records
+// 3. k-way merges until one run is left, then the header goes out last
+bool FAT32::buildDirIndex() {
+    uint32_t recordsPerSector = 512 / sizeof(FAT32_ListEntry);
+    uint32_t regionSectors = (listTotal + recordsPerSector - 1) / recordsPerSector;
+    
+    // The runs start in the region that makes the last merge end in region A (file sector 1),
+    // so region B can be released afterwards - and is not needed at all without a merge
+    uint32_t passes = 0;
+    for (uint32_t length = FAT32_INDEX_SCRATCH_SECTORS * recordsPerSector; length < listTotal;
+         length *= FAT32_INDEX_SCRATCH_SECTORS - 1) {
+        passes++;
+    }
+    uint32_t finalSize = (1 + regionSectors) * 512;
+    uint32_t fileSize = (1 + (passes > 0 ? 2 : 1) * regionSectors) * 512;
+    
+    // Index file: reuse it, create it in the free slot found by the pass
+    if (indexEntryFound) {
+        indexFile.entry = indexEntry;
+        indexFile.entrySector = indexEntrySector;
+        indexFile.entryIndex = indexEntryIndex;
+        if (!openEntry(FAT32_INDEX_FILE_NAME, currentDirCluster, &indexFile)) {
+            return false;
+        }
+    } else {
+        if (freeSlotSector == 0) {
+            printf("Directory index: no free directory entry\r\n");
+            return false;
+        }
+        memset(&indexFile.entry, 0, sizeof(indexFile.entry));
+        format83Name(FAT32_INDEX_FILE_NAME, (char*)indexFile.entry.name);
+        indexFile.entry.attributes = FAT32_ATTR_HIDDEN | FAT32_ATTR_ARCHIVE;
+        indexFile.entrySector = freeSlotSector;
+        indexFile.entryIndex = freeSlotIndex;
+        if (!writeDirEntry(freeSlotSector, freeSlotIndex, &indexFile.entry) ||
+            !openEntry(FAT32_INDEX_FILE_NAME, currentDirCluster, &indexFile)) {
+            return false;
+        }
+        freeSlotSector = 0;
+    }
+    if (indexFile.fileSize < fileSize && !growFile(&indexFile, fileSize)) {
+        return false;
+    }
+    
+    // Header first zeroed: an interrupted build never looks valid
+    uint8_t* scratch = g_indexScratch;
+    memset(scratch, 0, 512);
+    if (!writeFileAtOffset(&indexFile, 0, scratch, 512)) {
+        return false;
+    }
+    
+    // Sorted runs into region A (file sector 1) or B
+    uint32_t src = (passes & 1) ? 1 + regionSectors : 1;
+    uint32_t dst = (passes & 1) ? 1 : 1 + regionSectors;
+    FAT32_ListEntry* records = (FAT32_ListEntry*)scratch;
+    uint32_t runLength = FAT32_INDEX_SCRATCH_SECTORS * recordsPerSector;
+    uint32_t n = 0;
+    uint32_t written = 0;
+    static FAT32_DirItem item;
+    
+    if (!openDir(currentDirCluster, &scanIter)) {
+        return false;
+    }
+    bool more = true;
+    while (more) {
+        more = readDir(&scanIter, &item);
+        if (more) {
+            if (memcmp(item.entry.name, indexFile.entry.name, 11) == 0 || !makeListEntry(&item, &records[n])) {
                 continue;
             }
-            
-            // Try to read LFN if present
-            char lfnName[256];
-            bool hasLFN = false;
-            
-            // Check if there are LFN entries before this one
-            int lfnCount = 0;
-            for (int j = i - 1; j >= 0 && j >= i - 20; j--) {  // Max 20 LFN entries
-                if (dirEntries[j].attributes == FAT32_ATTR_LONG_NAME) {
-                    lfnCount++;
-                } else {
-                    break;
-                }
+            n++;
+        }
+        if (n == runLength || (!more && n > 0)) {
+            if (written + n > listTotal) {
+                return false;  // Directory grew since the pass
             }
-            
-            if (lfnCount > 0) {
-                // Read LFN entries
-                hasLFN = readLFNEntries(&dirEntries[i - lfnCount], lfnCount + 1, lfnName, sizeof(lfnName));
+            qsort(records, n, sizeof(FAT32_ListEntry), compareListEntriesQsort);
+            uint32_t bytes = ((n + recordsPerSector - 1) / recordsPerSector) * 512;
+            memset((uint8_t*)&records[n], 0, bytes - n * sizeof(FAT32_ListEntry));
+            if (!writeFileAtOffset(&indexFile, (src + written / recordsPerSector) * 512, scratch, bytes)) {
+                return false;
             }
-            
-            // Format filename (use LFN if available, otherwise 8.3)
-            char filename[256];
-            if (hasLFN) {
-                strncpy(filename, lfnName, sizeof(filename) - 1);
-                filename[sizeof(filename) - 1] = 0;
-            } else {
-                // Format 8.3 name
-                int nameIdx = 0;
-                
-                // Copy name (8 chars)
-                for (int j = 0; j < 8; j++) {
-                    if (dirEntries[i].name[j] != ' ') {
-                        filename[nameIdx++] = dirEntries[i].name[j];
-                    }
+            written += n;
+            n = 0;
+        }
+    }
+    if (scanIter.error || written != listTotal) {
+        return false;
+    }
+    
+    // Merge passes, ping-pong between the regions
+    while (runLength < listTotal) {
+        if (!mergeIndexRuns(src, dst, runLength)) {
+            return false;
+        }
+        runLength *= FAT32_INDEX_SCRATCH_SECTORS - 1;
+        uint32_t swap = src;
+        src = dst;
+        dst = swap;
+    }
+    
+    FAT32_IndexHeader* header = (FAT32_IndexHeader*)scratch;
+    memset(scratch, 0, 512);
+    memcpy(header->magic, FAT32_INDEX_MAGIC, sizeof(FAT32_INDEX_MAGIC));
+    header->dirCluster = currentDirCluster;
+    header->signature = listSignature;
+    header->entryCount = listTotal;
+    header->dataSector = src;
+    header->recordSize = sizeof(FAT32_ListEntry);
+    if (!writeFileAtOffset(&indexFile, 0, scratch, 512)) {
+        return false;
+    }
+    
+    // Release the merge region (and the tail of an index of a directory that shrank)
+    if (indexFile.fileSize > finalSize && !truncateFile(&indexFile, finalSize)) {
+        printf("Directory index: could not release unused clusters\r\n");
+    }
+    
+    indexDataSector = src;
+    indexBuilds++;
+    return true;
+}
+
+// One merge pass: groups of up to FAT32_INDEX_SCRATCH_SECTORS - 1 sorted runs from the region at
+// srcSector become one run each in the region at dstSector. Every input run streams through one
+// sector of the scratch buffer, the last sector collects the output.
+bool FAT32::mergeIndexRuns(uint32_t srcSector, uint32_t dstSector, uint32_t runLength) {
+    const uint32_t fanIn = FAT32_INDEX_SCRATCH_SECTORS - 1;
+    const uint32_t recordsPerSector = 512 / sizeof(FAT32_ListEntry);
+    uint8_t* buffers = g_indexScratch;
+    uint32_t next[FAT32_INDEX_SCRATCH_SECTORS - 1];      // Next record of each run
+    uint32_t end[FAT32_INDEX_SCRATCH_SECTORS - 1];       // End of each run
+    uint32_t loaded[FAT32_INDEX_SCRATCH_SECTORS - 1];    // Record sector in the run's buffer
+    FAT32_ListEntry* out = (FAT32_ListEntry*)(buffers + fanIn * 512);
+    uint32_t outCount = 0;
+    uint32_t outSector = dstSector;
+    
+    for (uint32_t groupStart = 0; groupStart < listTotal; groupStart += runLength * fanIn) {
+        uint32_t runs = 0;
+        for (uint32_t r = groupStart; r < listTotal && runs < fanIn; r += runLength) {
+            next[runs] = r;
+            end[runs] = (r + runLength < listTotal) ? r + runLength : listTotal;
+            loaded[runs] = 0xFFFFFFFF;
+            runs++;
+        }
+        
+        while (true) {
+            // Smallest head record of the runs (load its sector on demand)
+            int best = -1;
+            const FAT32_ListEntry* bestEntry = nullptr;
+            for (uint32_t i = 0; i < runs; i++) {
+                if (next[i] >= end[i]) {
+                    continue;
                 }
-                
-                // Add extension if present
-                if (dirEntries[i].name[8] != ' ') {
-                    filename[nameIdx++] = '.';
-                    for (int j = 8; j < 11; j++) {
-                        if (dirEntries[i].name[j] != ' ') {
-                            filename[nameIdx++] = dirEntries[i].name[j];
-                        }
+                uint32_t sector = next[i] / recordsPerSector;
+                uint8_t* buffer = buffers + i * 512;
+                if (loaded[i] != sector) {
+                    uint32_t bytesRead = 0;
+                    if (!readFileAtOffset(&indexFile, (srcSector + sector) * 512, buffer, 512, &bytesRead) ||
+                        bytesRead != 512) {
+                        return false;
                     }
+                    loaded[i] = sector;
+                }
+                const FAT32_ListEntry* head = (const FAT32_ListEntry*)buffer + next[i] % recordsPerSector;
+                if (!bestEntry || compareListEntries(head, bestEntry) < 0) {
+                    best = i;
+                    bestEntry = head;
                 }
-                filename[nameIdx] = 0;
+            }
+            if (best < 0) {
+                break;  // Group done
             }
             
-            // Check if it's a directory
-            bool isDirectory = (dirEntries[i].attributes & FAT32_ATTR_DIRECTORY) != 0;
-            
-            // Directories are always shown, files are filtered by extension
-            if (!isDirectory) {
-                // Filter: only show files with .dsk or .nic extension (case-insensitive)
-                if (!hasAllowedExtension(filename, "dsk", "nic")) {
-                    continue;
+            out[outCount++] = *bestEntry;
+            next[best]++;
+            if (outCount == recordsPerSector) {
+                if (!writeFileAtOffset(&indexFile, outSector * 512, (uint8_t*)out, 512)) {
+                    return false;
                 }
+                outSector++;
+                outCount = 0;
             }
-            
-            // Store entry for sorting
-            if (entryCount < 64) {
-                strncpy(entries[entryCount].name, filename, sizeof(entries[entryCount].name) - 1);
-                entries[entryCount].name[sizeof(entries[entryCount].name) - 1] = 0;
-                entries[entryCount].isDirectory = isDirectory;
-                entryCount++;
+        }
+    }
+    
+    if (outCount > 0) {
+        memset(&out[outCount], 0, (recordsPerSector - outCount) * sizeof(FAT32_ListEntry));
+        if (!writeFileAtOffset(&indexFile, outSector * 512, (uint8_t*)out, 512)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Page of the listing from the index file - the records are consecutive, so this is one
+// multi-block read (unless the page straddles a fragment of the file)
+bool FAT32::readIndexPage(uint32_t startIndex, FAT32_ListEntry* page, uint32_t count) {
+    const uint32_t recordsPerSector = 512 / sizeof(FAT32_ListEntry);
+    uint8_t* pageBuffer = g_indexScratch;  // A page of FAT32_LIST_WINDOW records spans at most 9 sectors
+    
+    uint32_t firstSector = startIndex / recordsPerSector;
+    uint32_t lastSector = (startIndex + count - 1) / recordsPerSector;
+    uint32_t bytes = (lastSector - firstSector + 1) * 512;
+    uint32_t bytesRead = 0;
+    if (!readFileAtOffset(&indexFile, (indexDataSector + firstSector) * 512, pageBuffer, bytes, &bytesRead) ||
+        bytesRead != bytes) {
+        return false;
+    }
+    memcpy(page, pageBuffer + (startIndex % recordsPerSector) * sizeof(FAT32_ListEntry),
+           count * sizeof(FAT32_ListEntry));
+    return true;
+}
+
+// Sorted listing page. A directory with an index file reads the page from it. Otherwise the
+// window of FAT32_LIST_WINDOW sorted entries around the last page is kept, so scrolling through
+// it is free; a page outside costs one directory pass per window moved (a page right next to the
+// window: one pass). Changing directory or re-mounting drops both.
+bool FAT32::listFilesPage(uint32_t startIndex, FAT32_ListEntry* page, uint32_t maxEntries,
+                          uint32_t* count, uint32_t* total) {
+    if (!sdCard || !page || !count) {
+        return false;
+    }
+    if (maxEntries > FAT32_LIST_WINDOW) {
+        maxEntries = FAT32_LIST_WINDOW;
+    }
+    *count = 0;
+    
+    // (an empty window can't anchor a pass - rescan from the start)
+    if (listDirCluster != currentDirCluster || listMountId != mountId ||
+        (!listFromIndex && listWindowCount == 0)) {
+        if (!prepareListing()) {
+            return false;
+        }
+    }
+    
+    if (listFromIndex) {
+        if (isFileOpen(&indexFile) && startIndex < listTotal) {
+            uint32_t n = listTotal - startIndex;
+            if (n > maxEntries) {
+                n = maxEntries;
             }
+            if (!readIndexPage(startIndex, page, n)) {
+                listDirCluster = 0;  // Try again from the directory next time
+                return false;
+            }
+            *count = n;
+        }
+        if (total) {
+            *total = listTotal;
+        }
+        return true;
+    }
+    
+    uint32_t scanned;
+    while (startIndex < listTotal) {
+        uint32_t windowEnd = listWindowStart + listWindowCount;
+        uint32_t pageEnd = startIndex + maxEntries;
+        if (pageEnd > listTotal) {
+            pageEnd = listTotal;
+        }
+        if (startIndex >= listWindowStart && pageEnd <= windowEnd) {
+            break;  // Page inside the window
         }
         
-        // Get next cluster
-        currentCluster = readFATEntry(currentCluster);
-        
-        if (currentCluster >= FAT32_CLUSTER_EOF_MIN) {
-            break;
+        uint32_t anchorRank;
+        if (startIndex < listWindowStart) {
+            // Backward - end the new window at the page end if that lies inside the window
+            anchorRank = (pageEnd >= listWindowStart && pageEnd < windowEnd) ? pageEnd : listWindowStart;
+            if (!scanListWindow(&listWindow[anchorRank - listWindowStart], false, &scanned)) {
+                return false;
+            }
+            listWindowStart = anchorRank - scanned;
+        } else {
+            // Forward - start the new window at the page start if that lies inside the window
+            anchorRank = (startIndex > listWindowStart && startIndex <= windowEnd) ? startIndex - 1 : windowEnd - 1;
+            if (!scanListWindow(&listWindow[anchorRank - listWindowStart], true, &scanned)) {
+                return false;
+            }
+            listWindowStart = anchorRank + 1;
+        }
+        listWindowCount = scanned;
+        if (scanned == 0) {
+            break;  // Directory changed under us - nothing on that side of the anchor
         }
     }
     
-sort_and_format:
-    // Sort entries: directories first, then files, both alphabetically
-    // Simple bubble sort (efficient enough for small lists)
-    for (uint32_t i = 0; i < entryCount - 1; i++) {
-        for (uint32_t j = 0; j < entryCount - i - 1; j++) {
-            bool swap = false;
-            
-            // Directories come before files
-            if (entries[j].isDirectory && !entries[j + 1].isDirectory) {
-                swap = false;  // Already in correct order (dir before file)
-            } else if (!entries[j].isDirectory && entries[j + 1].isDirectory) {
-                swap = true;  // Need to swap (file before dir)
-            } else {
-                // Both are same type, sort alphabetically
-                if (strcasecmp_sort(entries[j].name, entries[j + 1].name) > 0) {
-                    swap = true;
+    if (startIndex >= listWindowStart && startIndex < listWindowStart + listWindowCount) {
+        uint32_t n = listWindowStart + listWindowCount - startIndex;
+        if (n > maxEntries) {
+            n = maxEntries;
+        }
+        memcpy(page, &listWindow[startIndex - listWindowStart], n * sizeof(FAT32_ListEntry));
+        *count = n;
+    }
+    if (total) {
+        *total = listTotal;
+    }
+    return true;
+}
+
+// Whole listing of the current directory for text output (CLI 'list', listFiles())
+// Paging through listFilesPage() costs a directory pass per FAT32_LIST_WINDOW entries (about 157
+// passes for 5000 entries), so a full enumeration takes the cheapest complete order instead:
+// - index file: sorted, read FAT32_INDEX_SCRATCH_SECTORS sectors at a time, no directory pass
+// - listing fits in the window: sorted, already in memory
+// - otherwise: directory order, one pass (sorting it would need the index file's card writes)
+// The first listing of a directory adds its counting pass (prepareListing()) in every case.
+// total = entries in the listing, sorted = order used. The callback must not list (shared scratch).
+bool FAT32::listAll(FAT32_ListCallback callback, void* context, uint32_t* total, bool* sorted) {
+    if (!sdCard || !callback) {
+        return false;
+    }
+    
+    if (listDirCluster != currentDirCluster || listMountId != mountId ||
+        (!listFromIndex && listWindowCount == 0)) {
+        if (!prepareListing()) {
+            return false;
+        }
+    }
+    if (total) {
+        *total = listTotal;
+    }
+    
+    if (listFromIndex && isFileOpen(&indexFile)) {
+        if (sorted) {
+            *sorted = true;
+        }
+        const uint32_t recordsPerSector = 512 / sizeof(FAT32_ListEntry);
+        const uint32_t chunkRecords = FAT32_INDEX_SCRATCH_SECTORS * recordsPerSector;
+        const FAT32_ListEntry* records = (const FAT32_ListEntry*)g_indexScratch;
+        
+        for (uint32_t start = 0; start < listTotal; start += chunkRecords) {
+            uint32_t n = listTotal - start;
+            if (n > chunkRecords) {
+                n = chunkRecords;
+            }
+            uint32_t bytes = n * sizeof(FAT32_ListEntry);
+            uint32_t bytesRead = 0;
+            if (!readFileAtOffset(&indexFile, (indexDataSector + start / recordsPerSector) * 512, g_indexScratch,
+                                  bytes, &bytesRead) || bytesRead != bytes) {
+                listDirCluster = 0;  // Try again from the directory next time
+                return false;
+            }
+            for (uint32_t i = 0; i < n; i++) {
+                if (!callback(&records[i], context)) {
+                    return true;
                 }
             }
-            
-            if (swap) {
-                // Swap entries
-                FileEntry temp = entries[j];
-                entries[j] = entries[j + 1];
-                entries[j + 1] = temp;
+        }
+        return true;
+    }
+    
+    if (!listFromIndex && listWindowStart == 0 && listWindowCount == listTotal) {
+        if (sorted) {
+            *sorted = true;
+        }
+        for (uint32_t i = 0; i < listWindowCount; i++) {
+            if (!callback(&listWindow[i], context)) {
+                break;
             }
         }
+        return true;
+    }
+    
+    // Directory order - same entries as the sorted listing (makeListEntry(), index file skipped)
+    if (sorted) {
+        *sorted = false;
     }
+    static FAT32_DirItem item;
+    static FAT32_ListEntry listEntry;
+    char index83[11];
+    format83Name(FAT32_INDEX_FILE_NAME, index83);
     
-    // Format sorted entries into output string
-    uint32_t listPos = 0;
-    for (uint32_t i = 0; i < entryCount && listPos < maxSize - 64; i++) {
-        const char* typeStr = entries[i].isDirectory ? " <DIR>" : "";
-        int len = snprintf(fileList + listPos, maxSize - listPos, 
-                         "%s%s\r\n", entries[i].name, typeStr);
-        if (len > 0 && listPos + len < maxSize) {
-            listPos += len;
+    listPasses++;
+    if (!openDir(currentDirCluster, &scanIter)) {
+        return false;
+    }
+    while (readDir(&scanIter, &item)) {
+        if (memcmp(item.entry.name, index83, 11) == 0 || !makeListEntry(&item, &listEntry)) {
+            continue;
+        }
+        if (!callback(&listEntry, context)) {
+            return true;
         }
     }
+    return !scanIter.error;
+}
+
+// Text output of listFiles()
+typedef struct {
+    char* fileList;
+    uint32_t maxSize;
+    uint32_t listPos;
+} FAT32_TextList;
+
+static bool appendListLine(const FAT32_ListEntry* entry, void* context) {
+    FAT32_TextList* text = (FAT32_TextList*)context;
+    const char* typeStr = entry->isDirectory ? " <DIR>" : "";
+    int len = snprintf(text->fileList + text->listPos, text->maxSize - text->listPos, "%s%s\r\n",
+                       entry->name, typeStr);
+    if (len < 0 || text->listPos + len >= text->maxSize) {
+        text->fileList[text->listPos] = 0;  // Drop the partial line
+        return false;
+    }
+    text->listPos += len;
+    return true;
+}
+
+// List files in current directory (text) - as many lines as fit, in listAll() order
+bool FAT32::listFiles(char* fileList, uint32_t maxSize, uint32_t* fileCount) {
+    if (!sdCard || !fileList || maxSize == 0) {
+        return false;
+    }
+    
+    FAT32_TextList text = { fileList, maxSize, 0 };
+    uint32_t total = 0;
+    fileList[0] = 0;
+    if (!listAll(appendListLine, &text, &total, nullptr)) {
+        return false;
+    }
     
     if (fileCount) {
-        *fileCount = entryCount;
+        *fileCount = total;
     }
-    fileList[listPos] = 0;
     return true;
 }
-
@@ -93,6 +93,133 @@ typedef struct {
 #define FAT32_CLUSTER_EOF_MIN 0x0FFFFFF8
 #define FAT32_CLUSTER_EOF_MAX 0x0FFFFFFF
 
+// FAT sector cache (readFATEntry())
+#define FAT32_FAT_CACHE_SECTORS 4   // 512-byte FAT sectors kept (LRU) - one covers 128 clusters
+
+// FAT sector cache counters
+typedef struct {
+    uint32_t hits;
+    uint32_t misses;            // Sectors read from the card
+} FAT32_CacheStats;
+
+// Open file handle (see FAT32::openFile())
+#define FAT32_MAX_EXTENTS       64  // Fragments mapped per file (a contiguous image needs one) - the rest is chain-walked
+#define FAT32_FILE_NAME_SIZE    128
+
+// Run of consecutive sectors of a file
+typedef struct {
+    uint32_t fileSector;        // First file sector (offset / 512) of the run
+    uint32_t lba;               // Absolute card sector of fileSector
+    uint32_t sectors;           // Length of the run
+} FAT32_Extent;
+
+// Open file: everything needed to read / write it without touching its directory
+typedef struct {
+    bool open;
+    char name[FAT32_FILE_NAME_SIZE];    // Name it was opened with (display)
+    FAT32_DirEntry entry;               // Directory entry at open time
+    uint32_t dirCluster;                // Directory the file was opened in
+    uint32_t entrySector;               // Absolute sector holding the directory entry
+    uint16_t entryIndex;                // Entry index within that sector (0-15)
+    uint32_t fileSize;
+    uint32_t mountId;                   // FAT32 mount the handle belongs to
+    uint32_t extentCount;
+    FAT32_Extent extents[FAT32_MAX_EXTENTS];
+    uint32_t mappedSectors;             // File sectors covered by extents (more fragments: rest follows the chain)
+    uint32_t tailCluster;               // Cluster holding the last mapped sector
+    uint32_t walkFileSector;            // Chain walk cursor: first file sector of walkCluster
+    uint32_t walkCluster;               //   (sequential access past the map continues from here)
+} FAT32File;
+
+// Streaming directory reader (see FAT32::openDir() / readDir())
+#define FAT32_DIR_BUFFER_SECTORS 4      // Directory sectors read per transfer (never past the cluster end)
+#define FAT32_LFN_NAME_SIZE     256     // Longest long file name is 255 characters
+
+typedef struct {
+    uint32_t cluster;                   // Cluster being read
+    uint32_t sectorInCluster;           // Next sector to read from it
+    uint32_t clustersLeft;              // Guard against a looped chain
+    uint32_t bufferSector;              // Absolute sector of buffer[0]
+    uint32_t bufferEntries;             // Entries in buffer (16 per sector)
+    uint32_t entryPos;                  // Next entry in buffer
+    bool done;
+    bool error;                         // Stopped by a read error or a looped chain, not the end marker
+    char lfn[FAT32_LFN_NAME_SIZE];      // Long name collected from the LFN entries so far
+    uint8_t lfnChecksum;
+    uint8_t lfnNext;                    // Sequence number expected next (0 = none)
+    bool lfnComplete;                   // Sequence 1 seen - lfn belongs to the next 8.3 entry
+    uint32_t freeSector;                // First free (deleted / end) entry slot passed (0 = none yet)
+    uint16_t freeIndex;
+    uint8_t buffer[FAT32_DIR_BUFFER_SECTORS * 512];
+} FAT32_DirIterator;
+
+// One directory entry from readDir() (LFN entries, deleted entries and the end marker are consumed)
+typedef struct {
+    FAT32_DirEntry entry;
+    char name[FAT32_LFN_NAME_SIZE];     // Long name if present, else "NAME.EXT"
+    uint32_t entrySector;               // Absolute sector holding the entry
+    uint16_t entryIndex;                // Entry index within that sector (0-15)
+} FAT32_DirItem;
+
+// Directory entry cache (findFileInDirectory()): entries of one directory by name hash
+#define FAT32_DIR_CACHE_ENTRIES 256     // Larger directories: the first entries plus recent lookups
+#define FAT32_DIR_CACHE_BUCKETS 64
+#define FAT32_DIR_CACHE_END     0xFFFF  // End of a bucket chain
+#define FAT32_DIR_CACHE_NAME_SIZE 40    // Name kept for the compare after a hash match (longer: prefix)
+
+typedef struct {
+    uint32_t hash;                      // Case-insensitive FNV-1a of the name (long name if present)
+    uint32_t hash2;                     // Independent second hash (djb2)
+    FAT32_DirEntry entry;
+    uint32_t entrySector;
+    uint16_t entryIndex;
+    uint16_t next;                      // Next entry in the bucket
+    uint16_t nameLength;                // Full length of the name
+    char name[FAT32_DIR_CACHE_NAME_SIZE];   // Name, truncated to FAT32_DIR_CACHE_NAME_SIZE - 1 characters
+} FAT32_DirCacheEntry;
+
+// Directory entry cache counters
+typedef struct {
+    uint32_t hits;                      // Lookups answered from the cache (found or known missing)
+    uint32_t scans;                     // Lookups that had to read the directory
+    uint32_t builds;                    // Directory passes that filled the cache
+} FAT32_DirCacheStats;
+
+// Sorted directory listing (see FAT32::listFilesPage())
+// Directories first, then .dsk / .nic images, both case-insensitive alphabetical
+#define FAT32_LIST_WINDOW       32      // Sorted entries kept around the requested page
+#define FAT32_LIST_NAME_SIZE    120     // Longer names are listed by their 8.3 name
+
+// Listing entry - also the record format of the directory index file (128 bytes, 4 per sector)
+typedef struct {
+    char name[FAT32_LIST_NAME_SIZE];
+    uint32_t fileSize;
+    bool isDirectory;
+    uint8_t reserved[3];
+} FAT32_ListEntry;
+
+// Entry callback of FAT32::listAll() - return false to stop the listing
+typedef bool (*FAT32_ListCallback)(const FAT32_ListEntry* entry, void* context);
+
+// Directory index: hidden file in a large directory holding its sorted listing, so a page of the
+// listing is one read (see FAT32::listFilesPage()). Valid while the directory's signature (hash
+// of every listed name, attribute and size) matches - checked once per directory visit.
+#define FAT32_INDEX_FILE_NAME   "FLOPPY.IDX"
+#define FAT32_INDEX_MAGIC       "FLPIDX1"
+#define FAT32_INDEX_MIN_ENTRIES 64      // Smaller directories are sorted on the fly
+#define FAT32_INDEX_SCRATCH_SECTORS 32  // Build buffer: sorted run length / merge fan-in
+#define FAT32_DIR_INDEX_DEFAULT false   // Building writes to the card (file, FAT, FSInfo) - opt in with 'dirindex on'
+
+// Sector 0 of the index file
+typedef struct {
+    char magic[8];
+    uint32_t dirCluster;                // Directory the index belongs to
+    uint32_t signature;                 // Directory signature at build time
+    uint32_t entryCount;
+    uint32_t dataSector;                // File sector of the first record
+    uint32_t recordSize;                // sizeof(FAT32_ListEntry)
+} FAT32_IndexHeader;
+
 // Forward declaration
 class SDCardManager;
 
@@ -119,12 +246,100 @@ private:
     // Last error code
     FAT32_Error lastError;
     
+    // FAT sectors read by readFATEntry() - following a chain reads the same sector up to
+    // 128 times in a row, and a directory walk interleaves its own chain with the file's
+    uint8_t fatCacheData[FAT32_FAT_CACHE_SECTORS][512];
+    uint32_t fatCacheSector[FAT32_FAT_CACHE_SECTORS];   // Absolute sector (0xFFFFFFFF = empty)
+    uint32_t fatCacheLastUse[FAT32_FAT_CACHE_SECTORS];  // LRU stamp
+    uint32_t fatCacheClock;
+    FAT32_CacheStats fatCacheStats;
+    
+    // Handle behind the name-based read / write calls (reopened when the name changes)
+    FAT32File nameFile;
+    uint32_t mountId;               // Changes on every init() - see FAT32File::mountId
+    
+    // Directory reader shared by lookups and listing passes (they never nest)
+    FAT32_DirIterator scanIter;
+    
+    // Directory entry cache of dirCacheCluster (0 = empty) - filled by the first lookup or listing
+    // pass in a directory, dropped on cd, re-mount and every directory write
+    FAT32_DirCacheEntry dirCache[FAT32_DIR_CACHE_ENTRIES];
+    uint16_t dirCacheBuckets[FAT32_DIR_CACHE_BUCKETS];
+    uint32_t dirCacheCount;
+    uint32_t dirCacheCluster;
+    uint32_t dirCacheMountId;
+    bool dirCacheComplete;          // Every entry of the directory is cached - a miss means not found
+    uint32_t dirCacheEvict;         // Round-robin victim for lookups of an incomplete cache
+    FAT32_DirCacheStats dirCacheStats;
+    
+    // Sorted listing window: the entries ranked listWindowStart.. of listDirCluster
+    // A page inside the window costs no card access, moving it costs one directory pass
+    FAT32_ListEntry listWindow[FAT32_LIST_WINDOW];
+    uint32_t listWindowStart;
+    uint32_t listWindowCount;
+    uint32_t listTotal;             // Entries in the listing (counted by every pass)
+    uint32_t listDirCluster;        // 0 = window empty
+    uint32_t listMountId;
+    uint32_t listPasses;            // Directory passes done for listings (see 'list' CLI command)
+    uint32_t listSignature;         // Directory signature counted by the last pass
+    
+    // Directory index of the listed directory (FAT32_INDEX_FILE_NAME)
+    bool dirIndexEnabled;
+    bool listFromIndex;             // Listing pages come from indexFile
+    bool indexRebuild;              // Rebuild on the next listing even if valid
+    FAT32File indexFile;
+    uint32_t indexDataSector;
+    uint32_t indexBuilds;
+    bool indexEntryFound;           // Found by the last scan pass (entry, location below)
+    FAT32_DirEntry indexEntry;
+    uint32_t indexEntrySector;
+    uint16_t indexEntryIndex;
+    uint32_t freeSlotSector;        // Free directory slot found by the last scan pass (0 = none)
+    uint16_t freeSlotIndex;
+    uint32_t freeClusterHint;       // Where allocateClusters() starts searching
+    uint32_t indexOrphanCluster;    // Chain of a failed build still to be freed (0 = none)
+    
+    // Write whole sectors without reading them first, consecutive ones in one CMD25 transfer
+    // (false = old per-sector read-modify-write, kept for the write benchmark)
+    bool multiBlockWrite;
+    
     // Internal methods
     bool readBootSector();
     uint32_t getClusterSector(uint32_t cluster);
     uint32_t readFATEntry(uint32_t cluster);
-    bool readCluster(uint32_t cluster, uint8_t* buffer);
-    bool findFileInDirectory(uint32_t dirCluster, const char* filename, FAT32_DirEntry* entry);
+    const uint8_t* getFATSector(uint32_t sector);   // Cached FAT sector (nullptr = read failed)
+    void invalidateFATCache();
+    void updateFATCache(uint32_t sector, const uint8_t* data, uint32_t count);  // Write-through
+    FAT32File* openByName(const char* filename);
+    bool mapOffset(FAT32File* file, uint32_t offset, uint32_t* lba, uint32_t* sectorsLeft);
+    bool loadDirSectors(FAT32_DirIterator* iter);
+    void collectLFN(FAT32_DirIterator* iter, const FAT32_LFNEntry* lfn);
+    bool scanListWindow(const FAT32_ListEntry* anchor, bool forward, uint32_t* count);
+    bool findFileInDirectory(uint32_t dirCluster, const char* filename, FAT32_DirEntry* entry,
+                             uint32_t* entrySector = nullptr, uint16_t* entryIndex = nullptr);
+    bool openEntry(const char* name, uint32_t dirCluster, FAT32File* file);  // file->entry / location set
+    void invalidateDirCache();
+    void dirCacheBegin();
+    void dirCacheInsert(const FAT32_DirItem* item, bool evict);
+    bool dirCacheLookup(const char* filename, const char* name83, const FAT32_DirCacheEntry** found);
+    bool prepareListing();
+    bool loadDirIndex();
+    bool buildDirIndex();
+    void deleteDirIndex();
+    bool mergeIndexRuns(uint32_t srcSector, uint32_t dstSector, uint32_t runLength);
+    bool readIndexPage(uint32_t startIndex, FAT32_ListEntry* page, uint32_t count);
+    
+    // Allocation (index file only - images are never created or resized)
+    uint32_t getClusterCount() const;
+    bool writeFATSector(uint32_t sector, const uint8_t* data);
+    bool writeFATEntry(uint32_t cluster, uint32_t value);
+    uint32_t findFreeRun(uint32_t count);
+    bool allocateClusters(uint32_t count, uint32_t prevCluster, uint32_t* firstCluster);
+    bool freeClusterChain(uint32_t cluster);
+    void invalidateFSInfo();
+    bool writeDirEntry(uint32_t sector, uint16_t index, const FAT32_DirEntry* entry);
+    bool growFile(FAT32File* file, uint32_t size);
+    bool truncateFile(FAT32File* file, uint32_t size);
     void format83Name(const char* filename, char* name83);
     bool compare83Name(const char* name83, const char* filename);
     
@@ -140,7 +355,44 @@ public:
     bool readFile(const char* filename, uint8_t* buffer, uint32_t maxSize, uint32_t* bytesRead);
     bool readFileAtOffset(const char* filename, uint32_t offset, uint8_t* buffer, uint32_t size, uint32_t* bytesRead);
     bool writeFileAtOffset(const char* filename, uint32_t offset, const uint8_t* buffer, uint32_t size);
+    
+    // Open file handles - no directory lookup after openFile() (name lookups above reuse one internal handle)
+    bool openFile(const char* filename, FAT32File* file);   // In the current directory
+    void closeFile(FAT32File* file);
+    bool isFileOpen(const FAT32File* file) const;
+    bool readFile(FAT32File* file, uint8_t* buffer, uint32_t maxSize, uint32_t* bytesRead);
+    bool readFileAtOffset(FAT32File* file, uint32_t offset, uint8_t* buffer, uint32_t size, uint32_t* bytesRead);
+    bool writeFileAtOffset(FAT32File* file, uint32_t offset, const uint8_t* buffer, uint32_t size);
+    // Card sector of a file offset and sectors left in its extent (for writes queued on the async engine)
+    bool mapFileOffset(FAT32File* file, uint32_t offset, uint32_t* lba, uint32_t* sectorsLeft);
+    void setMultiBlockWrite(bool enable) { multiBlockWrite = enable; }
+    
+    // Text listing of the current directory ("name\r\n" / "name <DIR>\r\n", as many as fit)
     bool listFiles(char* fileList, uint32_t maxSize, uint32_t* fileCount);
+    // Sorted listing one page at a time: entries ranked startIndex.. (at most maxEntries, up to
+    // FAT32_LIST_WINDOW). Memory stays bounded for any directory size; total = entries in the listing.
+    bool listFilesPage(uint32_t startIndex, FAT32_ListEntry* page, uint32_t maxEntries,
+                       uint32_t* count, uint32_t* total);
+    // Whole listing, one callback per entry: sorted if that needs no further pass (index file, or the
+    // listing fits in the window), otherwise in directory order - one pass, not one per window
+    bool listAll(FAT32_ListCallback callback, void* context, uint32_t* total, bool* sorted);
+    uint32_t getListPasses() const { return listPasses; }
+    // Index scratch buffer (FAT32_INDEX_SCRATCH_SECTORS * 512 bytes) lent to short blocking jobs on
+    // core1 (benchmarks) - the next listing or index call overwrites it
+    uint8_t* getScratchBuffer(uint32_t* size);
+    void invalidateListing() { listDirCluster = 0; }
+    
+    // Directory index (FAT32_INDEX_FILE_NAME) - built for directories with FAT32_INDEX_MIN_ENTRIES or more
+    // Off by default (FAT32_DIR_INDEX_DEFAULT): only enabled, a listing writes the index to the card
+    void setDirIndexEnabled(bool enable) { dirIndexEnabled = enable; listDirCluster = 0; }
+    bool isDirIndexEnabled() const { return dirIndexEnabled; }
+    void rebuildDirIndex() { indexRebuild = true; listDirCluster = 0; }
+    bool isListFromIndex() const { return listDirCluster == currentDirCluster && listFromIndex; }
+    uint32_t getIndexBuilds() const { return indexBuilds; }
+    
+    // Streaming directory iteration (cluster 0 = root) - any number of entries and clusters
+    bool openDir(uint32_t dirCluster, FAT32_DirIterator* iter);
+    bool readDir(FAT32_DirIterator* iter, FAT32_DirItem* item);   // false = end of directory / read error (iter->error)
     
     // Directory operations
     bool findFile(const char* filename, FAT32_DirEntry* entry);
@@ -149,6 +401,7 @@ public:
     bool getCurrentDirectory(char* path, uint32_t maxSize);
     void setCurrentDirectory(uint32_t cluster);
     uint32_t getCurrentDirectoryCluster() const;
+    uint32_t getMountId() const { return mountId; }    // Changes on every init()
     
     // LFN support
     bool readLFNEntries(FAT32_DirEntry* entries, int count, char* lfnBuffer, uint32_t bufferSize);
@@ -166,6 +419,15 @@ public:
     
     // Error handling
     FAT32_Error getLastError() const { return lastError; }
+    
+    // FAT sector cache counters (see 'status' CLI command)
+    void getFATCacheStats(FAT32_CacheStats* stats) const { *stats = fatCacheStats; }
+    void resetFATCacheStats() { fatCacheStats.hits = 0; fatCacheStats.misses = 0; }
+    
+    // Directory entry cache counters / state (see 'status' CLI command)
+    void getDirCacheStats(FAT32_DirCacheStats* stats) const { *stats = dirCacheStats; }
+    uint32_t getDirCacheCount() const { return dirCacheCount; }
+    bool isDirCacheComplete() const { return dirCacheComplete; }
 };
 
 #endif // FAT32_H
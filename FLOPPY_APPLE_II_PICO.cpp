@@ -24,6 +24,7 @@
 static CLIHandler* g_cli = nullptr;
 static UIHandler* g_ui = nullptr;
 static FloppyEmulator* g_floppy = nullptr;
+static SDCardManager* g_sdCard = nullptr;
 
 
 bool reserved_addr(uint8_t addr) {
@@ -75,6 +76,16 @@ void core1_process() {
                 g_ui->update();
             }
 
+            // Save written tracks queued by core0/stepper IRQ (decode + SD card write)
+            // Runs before the prefetch - a written track is only re-encoded after it is saved
+            g_floppy->processWriteBackQueue();
+            
+            // Advance queued async SD requests (bounded SPI work per call, callbacks run here)
+            g_sdCard->getAsyncEngine()->poll();
+            
+            // Pre-encode the next track in the head's direction (swap on arrival is then instant)
+            g_floppy->prefetchNeighborTrack();
+
             // Small delay to prevent CPU spinning
             // Note: core1 doesn't affect PIO/DMA on core0, so sleep_us is OK here
             sleep_us(10);
@@ -127,6 +138,7 @@ int main()
     
     // Initialize SD card with hotplug support (static to avoid large stack allocation)
     static SDCardManager sdCard(SD_SPI_INSTANCE, SD_SPI_CS, SD_SPI_MOSI, SD_SPI_MISO, SD_SPI_SCK, SD_CARD_DETECT);
+    g_sdCard = &sdCard;
     
     printf("Initializing SD card with hotplug support...\r\n");
     printf("SD Card SPI: CS=GPIO%d, MOSI=GPIO%d, MISO=GPIO%d, SCK=GPIO%d\r\n", 
@@ -281,6 +293,9 @@ int main()
     }
     printf("UI handler initialized\r\n");
     
+    // Async SD requests are advanced by core1 only - core0 (card removal) waits for it
+    sdCard.getAsyncEngine()->setPollCore(1);
+    
     // Launch core1 processing
     printf("Launching core1 processing...\r\n");
     multicore_launch_core1(core1_process);
@@ -308,15 +323,39 @@ int main()
 //    uint8_t writeENState = 0;
 
 
+    // Stepper phases are captured by PIO and processed in its IRQ (FloppyEmulator::initPhaseCapture()),
+    // polling them with a repeating timer is only the fallback without a free PIO state machine
     static repeating_timer_t motorTimer;
-    add_repeating_timer_us(-500, timer_callback, NULL, &motorTimer);
-    // Set maximum priority (0 = highest) for timer IRQ used by repeating timer
-    // Repeating timers use hardware timer IRQ 0 in Pico SDK
-    irq_set_priority(0, 0);
+    if (!g_floppy->isPhaseCaptureReady()) {
+        add_repeating_timer_us(-STEPPER_POLL_INTERVAL_US, timer_callback, NULL, &motorTimer);
+        // Set maximum priority (0 = highest) for timer IRQ used by repeating timer
+        // Repeating timers use hardware timer IRQ 0 in Pico SDK
+        irq_set_priority(0, 0);
+    }
 
     while (true) {
       
-        // CRITICAL: During write operation, use tight polling loop
+        // Write operation: PIO samples the WRITE pin and DMA fills a ring buffer,
+        // core0 only decodes captured bytes - interrupts (stepper timer) stay enabled
+        if (floppy.isWriteEnabled() && floppy.isDriveSelected() && g_floppy->isWriteCaptureReady()) {
+            
+            // Start write procedure (init_writing equivalent) - starts PIO/DMA capture
+            g_floppy->startWritingProcedure();
+            
+            // Decode while the controller keeps writing
+            do {
+                g_floppy->processWriteCapture();
+            } while (g_floppy->isWriteEnabled());
+            
+            // End write procedure (end_writing equivalent) - decodes the tail and writes back
+            // Interrupts off only for write-back so the stepper IRQ can't flush a half-updated cache
+            uint32_t flags = save_and_disable_interrupts();
+            g_floppy->stopWritingProcedure();
+            restore_interrupts(flags);
+            continue;
+        }
+        
+        // Fallback when PIO/DMA capture is unavailable: tight polling loop
         // Write timing is critical - based on AVR write loop implementation
         if (floppy.isWriteEnabled() && floppy.isDriveSelected()) {
             
@@ -1,5 +1,6 @@
 #include "FloppyEmulator.h"
 #include "SDCardManager.h"
+#include "NICCodec.h"
 #include "hardware/gpio.h"
 #include "hardware/sync.h"
 #include "hardware/irq.h"
@@ -7,6 +8,7 @@
 #include "hardware/pio.h"
 #include "hardware/pio_instructions.h"
 #include "hardware/dma.h"
+#include "hardware/clocks.h"
 #include <cstdint>
 #include <pico/time.h>
 #include <stdio.h>
@@ -15,7 +17,7 @@
 #include "PinConfig.h"
 #include "hardware/pwm.h"
 
-// Static pointer to FloppyEmulator instance for timer callback and DMA IRQ
+// Static pointer to FloppyEmulator instance for timer callbacks and IRQ handlers
 static FloppyEmulator* g_floppyEmulatorInstance = nullptr;
 
 // Static variable to track which PIO instance is being used for write IRQ timer (set during init)
@@ -25,22 +27,13 @@ static uint slice_num;
 
 
 
-// GPIO IRQ handler for WRITE_EN and WRITE pins (reacts to both rising and falling edges)
-// This allows us to detect when the write head is activated (WRITE_EN = 1)
-// and flux transitions on the WRITE pin
-void MotorIRQHandler(uint gpio, uint32_t events) {
-    if (!g_floppyEmulatorInstance) {
-        printf("ERROR: MotorIRQHandler() - g_floppyEmulatorInstance is null\r\n");
-        return;
-    }
-
-    if (!g_floppyEmulatorInstance->isDriveSelected()) {
-        return;
+// PIO RX IRQ of the stepper phase capture (registered by initPhaseCapture())
+// floppy_phase_capture pushes every new PH0-PH3 state, so a step is processed a few μs
+// after the controller switches the phase instead of at the next 500μs timer tick
+static void PhaseCaptureIRQHandler() {
+    if (g_floppyEmulatorInstance) {
+        g_floppyEmulatorInstance->handlePhaseCaptureIRQ();
     }
-    // Check which pin triggered the IRQ
-    //printf("MotorIRQHandler: gpio=%d, events=%d\r\n", gpio, events);
-    //sleep_ms(4);
-    //g_floppyEmulatorInstance->processStepperMotor();
 }
 
 
@@ -57,61 +50,23 @@ static const uint8_t GCR_ENCODE_LOOKUP[32] = {
     0x2B, 0x2E, 0x2F, 0x3A   // 28-31
 };
 
-// Apple II NIC format encoding table (6-bit GCR)
-static const uint8_t NIC_ENCODE_TABLE[64] = {
-    0x96, 0x97, 0x9A, 0x9B, 0x9D, 0x9E, 0x9F, 0xA6,
-    0xA7, 0xAB, 0xAC, 0xAD, 0xAE, 0xAF, 0xB2, 0xB3,
-    0xB4, 0xB5, 0xB6, 0xB7, 0xB9, 0xBA, 0xBB, 0xBC,
-    0xBD, 0xBE, 0xBF, 0xCB, 0xCD, 0xCE, 0xCF, 0xD3,
-    0xD6, 0xD7, 0xD9, 0xDA, 0xDB, 0xDC, 0xDD, 0xDE,
-    0xDF, 0xE5, 0xE6, 0xE7, 0xE9, 0xEA, 0xEB, 0xEC,
-    0xED, 0xEE, 0xEF, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6,
-    0xF7, 0xF9, 0xFA, 0xFB, 0xFC, 0xFD, 0xFE, 0xFF
-};
-
-// NIC decode table: maps encoded byte to 6-bit value (0-63)
-// Built from NIC_ENCODE_TABLE: decodeTable[encoded] = index
-static uint8_t NIC_DECODE_TABLE[256];
-static bool nicDecodeTableInitialized = false;
-
-// Initialize decode table (called once at startup)
-static void ensureNICDecodeTableInitialized() {
-    if (!nicDecodeTableInitialized) {
-        // Initialize all to invalid marker
-        for (int i = 0; i < 256; i++) {
-            NIC_DECODE_TABLE[i] = 0xFF;
-        }
-        // Build reverse lookup: for each encoded value, store its index
-        for (int i = 0; i < 64; i++) {
-            NIC_DECODE_TABLE[NIC_ENCODE_TABLE[i]] = i;
-        }
-        nicDecodeTableInitialized = true;
-    }
-}
-
 // Sector scramble table (Apple II sector ordering)
 static const uint8_t SECTOR_SCRAMBLE[16] = {
     0, 7, 14, 6, 13, 5, 12, 4, 11, 3, 10, 2, 9, 1, 8, 15
 };
 
-// Flip bit tables for data encoding
-static const uint8_t FLIP_BIT1[4] = { 0, 2, 1, 3 };
-static const uint8_t FLIP_BIT2[4] = { 0, 8, 4, 12 };
-static const uint8_t FLIP_BIT3[4] = { 0, 32, 16, 48 };
-
-// Reverse lookup tables for FlipBit decoding
-// FLIP_BIT1: value -> index mapping
-static const uint8_t FLIP_BIT1_REV[4] = { 0, 2, 1, 3 };  // Same as forward (symmetric)
-// FLIP_BIT2: value -> index mapping  
-static const uint8_t FLIP_BIT2_REV[16] = { 0, 0, 0, 0, 2, 0, 0, 0, 1, 0, 0, 0, 3, 0, 0, 0 };
-// FLIP_BIT3: value -> index mapping
-static const uint8_t FLIP_BIT3_REV[64] = {
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    3, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+// Reverse sector scramble: logical sector -> physical sector (SECTOR_SCRAMBLE_REV[SECTOR_SCRAMBLE[p]] = p)
+static const uint8_t SECTOR_SCRAMBLE_REV[16] = {
+    0, 13, 11, 9, 7, 5, 3, 1, 14, 12, 10, 8, 6, 4, 2, 15
 };
 
+// Scratch buffer for whole-disk mode track flushes (decoded DSK track or expanded NIC track)
+// Static to avoid 8KB on the core1 stack (used only by writeBackTrack())
+static uint8_t g_flushTrackBuffer[APPLE_II_NIC_BYTES_PER_TRACK];
+
+// Ring buffer for PIO/DMA write capture (edge intervals) - must be aligned to its size for DMA ring wrap
+static uint32_t g_writeCaptureRing[WRITE_CAPTURE_RING_ENTRIES] __attribute__((aligned(WRITE_CAPTURE_RING_SIZE)));
+
 // Stepper motor phase sequence for forward (outward) movement
 // 4-phase full step sequence
 static const uint8_t STEPPER_SEQUENCE_OUTWARD[4] = {
@@ -158,7 +113,6 @@ FloppyEmulator::FloppyEmulator(
     lastPhaseOffset = STEPPER_PHASE_0;  // Initialize last phase offset
     rotationPosition = 0;
     indexPulse = false;
-    lastBitTime = get_absolute_time();
     timerActive = false;
     
     // Initialize write buffer state
@@ -171,14 +125,17 @@ FloppyEmulator::FloppyEmulator(
     prologBuffer[1] = 0;
     prologBuffer[2] = 0;
     prologBitCount = 0;
-    writeBitsProcessed = 0;  // Count bits processed (skip 25th bit)
     
     // Initialize PIO/DMA state
     pio = nullptr;
     pioSm = 0;
     pioOffset = 0;
     dmaChannel = -1;
+    dmaControlChannel = -1;
     pioDmaActive = false;
+    readStreamBase = 0;
+    readRpm = APPLE_II_NOMINAL_RPM;
+    readClockDiv = 0;
     
     // Initialize PIO IRQ timer state
     writeIrqTimerPio = nullptr;
@@ -186,14 +143,71 @@ FloppyEmulator::FloppyEmulator(
     writeIrqTimerOffset = 0;
     writeIrqTimerActive = false;
     
-    // Initialize GCR cache state
+    // Initialize PIO/DMA write capture state
+    writeCapturePio = nullptr;
+    writeCaptureSm = 0;
+    writeCaptureOffset = 0;
+    writeCaptureDmaChannel = -1;
+    writeCaptureReady = false;
+    writeCaptureActive = false;
+    writeCaptureReadIndex = 0;
+    writeCaptureOverruns = 0;
+    
+    // Initialize stepper phase capture state
+    phaseCapturePio = nullptr;
+    phaseCaptureSm = 0;
+    phaseCaptureOffset = 0;
+    phaseCaptureReady = false;
+    stepperEventHead = 0;
+    stepperEventTail = 0;
+    lastStepTimeUs = 0;
+    memset(&stepperStats, 0, sizeof(stepperStats));
+    
+    // Initialize GCR cache state (track slots are empty - see updateGCRTrackCache())
+    for (int i = 0; i < GCR_TRACK_CACHE_SLOTS; i++) {
+        GCRTrackSlot* slot = &gcrTrackSlots[i];
+        memset(&slot->map.layout, 0xFF, sizeof(GCRTrackLayout));  // All offsets -1
+        memset(slot->map.index, GCR_INDEX_UNKNOWN, APPLE_II_GCR_BYTES_PER_TRACK);
+        slot->data = slot->buffer;
+        slot->track = -1;
+        slot->busy = false;
+        slot->prefetched = false;
+        slot->lastUse = 0;
+    }
+    gcrTrackSlotClock = 0;
+    memset(&gcrTrackCacheStats, 0, sizeof(gcrTrackCacheStats));
+    stepDirection = 0;
+    gcrTrackCache = gcrTrackSlots[0].buffer;  // Per-track buffer until a disk image is pre-encoded
     gcrTrackCacheTrack = -1;  // Cache invalid initially
+    pendingGCRTrackCache = nullptr;  // No swap pending
+    pendingGCRTrackCacheTrack = -1;
+    gcrTrackMap = &gcrTrackSlots[0].map;
+    pendingGCRTrackMap = nullptr;
     gcrTrackCacheBits = 0;
     gcrTrackCacheDirty = false;  // Cache is clean initially
+    memset(gcrTrackDirtySectors, 0, sizeof(gcrTrackDirtySectors));
+    
+    // Initialize write-back queue (empty)
+    writeBackHead = 0;
+    writeBackTail = 0;
+    memset((void*)writeBackQueuedPerTrack, 0, sizeof(writeBackQueuedPerTrack));
+    memset((void*)writeBackSavedPerTrack, 0, sizeof(writeBackSavedPerTrack));
+    writeBackQueuedCount = 0;
+    writeBackCompletedCount = 0;
+    writeBackDeferredCount = 0;
+    writeBackInFlight = false;
+    writeBackRequestsPending = 0;
+    writeBackAsyncCount = 0;
+    writeBackRetryCount = 0;
+    
+    // Initialize whole-disk GCR state
+    wholeDiskGCRMode = FLOPPY_WHOLE_DISK_GCR_DEFAULT;
+    wholeDiskGCRActive = false;
+    diskImageLoading = false;
     
     // Initialize SD card and file management
     sdCardManager = nullptr;
-    memset(currentFileName, 0, sizeof(currentFileName));
+    memset(&currentFile, 0, sizeof(currentFile));
     currentFileType = DISK_FILE_TYPE_DSK;  // Default to .dsk format
     
     // Clear disk image
@@ -201,8 +215,6 @@ FloppyEmulator::FloppyEmulator(
     
     // Initialize GCR tables
     initializeGCRTables();
-    // Initialize NIC decode table
-    ensureNICDecodeTableInitialized();
 }
 
     // Destructor
@@ -246,17 +258,6 @@ void FloppyEmulator::init() {
     gpio_set_dir(driveSelPin, GPIO_IN);
     gpio_pull_up(driveSelPin);  // Pull up - selected when low (active low signal)
     
-    // Configure GPIO IRQ for WRITE_EN and WRITE pins to react to both rising and falling edges
-    // This allows us to detect when the write head is activated (WRITE_EN = 1)
-    // and flux transitions on the WRITE pin
-//    gpio_set_irq_callback(MotorIRQHandler);
-//    gpio_set_irq_enabled(GPIO_PH0, GPIO_IRQ_EDGE_RISE, true);
-//    gpio_set_irq_enabled(GPIO_PH1, GPIO_IRQ_EDGE_RISE, true);
-//    gpio_set_irq_enabled(GPIO_PH2, GPIO_IRQ_EDGE_RISE, true);
-//    gpio_set_irq_enabled(GPIO_PH3, GPIO_IRQ_EDGE_RISE, true);
-//    irq_set_priority(IO_IRQ_BANK0, 0);
-//    irq_set_enabled(IO_IRQ_BANK0, true);
-    
     // Initialize GPIO2 for debug output (write timer toggle)
     //gpio_init(2);
     //gpio_set_dir(2, GPIO_OUT);
@@ -291,6 +292,9 @@ void FloppyEmulator::init() {
         }
     }
     
+    // Slot state is shared with core1 (prefetch) - needs a spin lock, not only disabled interrupts
+    critical_section_init(&gcrTrackSlotLock);
+    
     // Initialize GCR track cache with test pattern (0xAA) for testing
     updateGCRTrackCache();
     
@@ -300,12 +304,18 @@ void FloppyEmulator::init() {
     // Initialize PIO IRQ timer for write bit capture
     //initWriteIRQTimer();
     
-    // Initialize PWM timer for write bit capture
+    // Initialize PWM timer for write bit capture (fallback polling loop)
     initWritePWMTimer();
     
+    // Initialize PIO/DMA write capture (replaces the polling loop when available)
+    initWriteCapture();
+    
     // Start PIO/DMA immediately - it should run continuously like real hardware
     // In real Apple II floppy drive, READ pin constantly outputs data when drive is spinning
     startPIO_DMA();
+    
+    // Stepper phase capture last - its IRQ may move the head as soon as it is enabled
+    initPhaseCapture();
 }
 
 // Initialize GCR encoding/decoding tables
@@ -409,17 +419,31 @@ static const uint8_t PHASE_COUNT[16] = {
 };
 
 // Detect stepper motor phase change from controller
-// Adapted from ATMegaX code - optimized approach using gpio_get_all()
+// With PIO phase capture: replays the queued phase states in order (called by the PIO IRQ),
+// so every intermediate phase of a fast seek is seen. Without it: samples the pins once
+// (500μs polling timer) - adapted from ATMegaX code using gpio_get_all()
 // Phases are on GPIO 6-9 (PH0-PH3), so we can read them with a single operation
-// This matches the ATMegaX implementation logic exactly
 void FloppyEmulator::detectStepperPhaseChange() {
+    if (phaseCaptureReady) {
+        while (stepperEventTail != stepperEventHead) {
+            const StepperPhaseEvent* event = &stepperEvents[stepperEventTail % STEPPER_EVENT_QUEUE_DEPTH];
+            applyStepperPhaseState(event->state, event->timeUs);
+            stepperEventTail = stepperEventTail + 1;
+        }
+        return;
+    }
+    
     // Read all 4 phase pins at once (GPIO 6-9)
     // gpio_get_all() returns all GPIO states, shift right by GPIO_PH0 to get bits 6-9
     // Use volatile to ensure compiler doesn't optimize away reads
-    //printf("detectStepperPhaseChange: \r\n");
     volatile uint32_t gpio_all = gpio_get_all();
     uint8_t stp_pos = (gpio_all >> GPIO_PH0) & 0x0F;
-    
+    applyStepperPhaseState(stp_pos, time_us_32());
+}
+
+// Move the head for one phase state (bits 0-3 = PH0-PH3) seen at timeUs
+// This matches the ATMegaX implementation logic exactly
+void FloppyEmulator::applyStepperPhaseState(uint8_t stp_pos, uint32_t timeUs) {
     // NO printf() here - this runs on core1 and printf() is NOT thread-safe!
     // It will cause deadlock/blocking when called from core1
     
@@ -454,21 +478,38 @@ void FloppyEmulator::detectStepperPhaseChange() {
         // - 2 physical steps = 1 logical track
         
         // Calculate direction based on phase sequence
+        bool stepped = false;
         // Forward: PH0->PH1->PH2->PH3->PH0 (ofs == (old_ofs + 1) & 0x3)
         // Backward: PH0->PH3->PH2->PH1->PH0 (ofs == (old_ofs - 1) & 0x3)
         if (ofs == ((StepperPhase)((lastPhase + 1) & 0x3))) {
             // Moving forward (outward): PH0->PH1->PH2->PH3->PH0
             // Increase physical track (matches ATMegaX: DII_ph_track++)
             physicalTrack++;
+            stepDirection = 1;
+            stepped = true;
             lastTimeChangeTrackCheck = get_absolute_time();
         } else if (ofs == ((StepperPhase)((lastPhase - 1) & 0x3))) {
             // Moving backward (inward): PH0->PH3->PH2->PH1->PH0
             // Decrease physical track (matches ATMegaX: DII_ph_track--)
             physicalTrack--;
+            stepDirection = -1;
+            stepped = true;
             lastTimeChangeTrackCheck = get_absolute_time();
         }
         // If neither condition is true, it's an invalid transition (skipped phase) - ignore
         
+        if (stepped) {
+            stepperStats.steps++;
+            if (lastStepTimeUs != 0) {
+                uint32_t interval = timeUs - lastStepTimeUs;
+                stepperStats.lastStepIntervalUs = interval;
+                if (stepperStats.minStepIntervalUs == 0 || interval < stepperStats.minStepIntervalUs) {
+                    stepperStats.minStepIntervalUs = interval;
+                }
+            }
+            lastStepTimeUs = timeUs;
+        }
+        
         // Clamp physical track to valid range (0-69, matching ATMegaX)
         if (physicalTrack < 0) {
             physicalTrack = 0;
@@ -495,6 +536,7 @@ void FloppyEmulator::detectStepperPhaseChange() {
         // These are simple assignments - safe on core1 (core0 won't write during normal operation)
         lastPhaseOffset = ofs;
         currentPhase = ofs;
+        // Only snapshots the written track into the write-back queue - core1 decodes and saves it
         saveGCRCacheToDiskImage();
     }
 }
@@ -506,6 +548,99 @@ void FloppyEmulator::processStepperMotor() {
     detectStepperPhaseChange();
 }
 
+//-----------------------------------------------
+// Stepper phase capture
+// Runs floppy_phase_capture on pio0 next to the READ stream (pio1 if pio0 is full). Every new
+// PH0-PH3 state raises the PIO IRQ on this core, which queues it with a timestamp and runs
+// detectStepperPhaseChange() - the 500μs polling timer in main() is only started without it.
+// A GPIO bank IRQ is not used: it would also fire on every WRITE flux edge during writes.
+void FloppyEmulator::initPhaseCapture() {
+    phaseCaptureReady = false;
+    
+    PIO candidates[2] = { pio0, pio1 };
+    int sm = -1;
+    for (int i = 0; i < 2 && sm < 0; i++) {
+        if (!pio_can_add_program(candidates[i], &floppy_phase_capture_program)) {
+            continue;
+        }
+        phaseCapturePio = candidates[i];
+        sm = pio_claim_unused_sm(phaseCapturePio, false);
+    }
+    if (sm < 0) {
+        printf("WARNING: No free PIO state machine for phase capture - polling every %dus\r\n",
+               STEPPER_POLL_INTERVAL_US);
+        return;
+    }
+    phaseCaptureSm = (uint)sm;
+    phaseCaptureOffset = pio_add_program(phaseCapturePio, &floppy_phase_capture_program);
+    floppy_phase_capture_program_init(phaseCapturePio, phaseCaptureSm, phaseCaptureOffset, GPIO_PH0);
+    
+    // RX FIFO not empty -> IRQ 0 of that PIO, highest priority (like the old timer IRQ)
+    uint irqNum = pio_get_irq_num(phaseCapturePio, 0);
+    irq_set_exclusive_handler(irqNum, PhaseCaptureIRQHandler);
+    irq_set_priority(irqNum, PICO_HIGHEST_IRQ_PRIORITY);
+    pio_set_irqn_source_enabled(phaseCapturePio, 0, pio_get_rx_fifo_not_empty_interrupt_source(phaseCaptureSm), true);
+    irq_set_enabled(irqNum, true);
+    
+    stepperEventHead = 0;
+    stepperEventTail = 0;
+    phaseCapturePio->fdebug = 1u << (PIO_FDEBUG_RXSTALL_LSB + phaseCaptureSm);  // Clear overflow flag
+    phaseCaptureReady = true;
+    pio_sm_set_enabled(phaseCapturePio, phaseCaptureSm, true);
+    
+    printf("Phase capture: PIO%u SM%u, IRQ %u\r\n", pio_get_index(phaseCapturePio), phaseCaptureSm, irqNum);
+}
+
+// PIO IRQ: move the captured phase states into the event queue and process them
+// States of one burst share a timestamp (they waited in the FIFO while interrupts were off)
+void FloppyEmulator::handlePhaseCaptureIRQ() {
+    uint32_t now = time_us_32();
+    
+    while (!pio_sm_is_rx_fifo_empty(phaseCapturePio, phaseCaptureSm)) {
+        uint8_t state = (uint8_t)(pio_sm_get(phaseCapturePio, phaseCaptureSm) & 0x0F);
+        stepperStats.events++;
+        
+        uint32_t head = stepperEventHead;
+        if (head - stepperEventTail >= STEPPER_EVENT_QUEUE_DEPTH) {
+            stepperStats.dropped++;
+            continue;
+        }
+        StepperPhaseEvent* event = &stepperEvents[head % STEPPER_EVENT_QUEUE_DEPTH];
+        event->timeUs = now;
+        event->state = state;
+        stepperEventHead = head + 1;
+    }
+    
+    // push noblock drops a state when the FIFO is full - the PIO flags it
+    uint32_t stallMask = 1u << (PIO_FDEBUG_RXSTALL_LSB + phaseCaptureSm);
+    if (phaseCapturePio->fdebug & stallMask) {
+        phaseCapturePio->fdebug = stallMask;  // Write 1 to clear
+        stepperStats.dropped++;
+    }
+    
+    detectStepperPhaseChange();
+    
+    uint32_t elapsed = time_us_32() - now;
+    if (elapsed > stepperStats.maxIrqLatencyUs) {
+        stepperStats.maxIrqLatencyUs = elapsed;
+    }
+}
+
+bool FloppyEmulator::isPhaseCaptureReady() const {
+    return phaseCaptureReady;
+}
+
+void FloppyEmulator::getStepperCaptureStats(StepperCaptureStats* stats) {
+    if (stats) {
+        *stats = stepperStats;
+    }
+}
+
+void FloppyEmulator::resetStepperCaptureStats() {
+    memset(&stepperStats, 0, sizeof(stepperStats));
+    lastStepTimeUs = 0;
+}
+
 // Get current track
 int FloppyEmulator::getCurrentTrack() const {
     return currentTrack;
@@ -604,12 +739,42 @@ void FloppyEmulator::decodeSectorGCR(const uint8_t* gcr, uint8_t* data, int leng
     }
 }
 
+// Copy bytes out of / into a circular GCR track (fields may wrap past the end of the buffer)
+static void copyFromGCRTrack(const uint8_t* track, uint32_t offset, uint8_t* out, uint32_t length) {
+    for (uint32_t i = 0; i < length; i++) {
+        out[i] = track[(offset + i) % APPLE_II_GCR_BYTES_PER_TRACK];
+    }
+}
+
+static void copyToGCRTrack(uint8_t* track, uint32_t offset, const uint8_t* in, uint32_t length) {
+    for (uint32_t i = 0; i < length; i++) {
+        track[(offset + i) % APPLE_II_GCR_BYTES_PER_TRACK] = in[i];
+    }
+}
+
 // Read sector from disk image
 bool FloppyEmulator::readSector(int track, int sector, uint8_t* buffer) {
     if (track < 0 || track >= APPLE_II_TRACKS) return false;
     if (sector < 0 || sector >= APPLE_II_SECTORS_PER_TRACK) return false;
     if (buffer == nullptr) return false;
     
+    // Whole-disk mode: diskImage holds GCR tracks - decode the data field of the physical sector
+    // (found by scanning the track, so NIC images with non-standard gaps work too)
+    if (wholeDiskGCRActive) {
+        int physicalSector = SECTOR_SCRAMBLE_REV[sector];
+        const uint8_t* gcrTrack = &diskImage[track * APPLE_II_GCR_BYTES_PER_TRACK];
+        GCRTrackLayout layout;
+        buildGCRTrackLayout(gcrTrack, &layout);
+        if (layout.dataOffset[physicalSector] < 0) {
+            return false;  // No data field for this sector on the track
+        }
+        uint8_t dataField[343];
+        copyFromGCRTrack(gcrTrack, layout.dataOffset[physicalSector] + 3, dataField, sizeof(dataField));
+        uint16_t decodedLength = 0;
+        decodeNICDataField(dataField, sizeof(dataField), buffer, &decodedLength);
+        return decodedLength == APPLE_II_BYTES_PER_SECTOR;
+    }
+    
     uint32_t offset = calculateTrackOffset(track, sector);
     
     // Copy raw data from disk image
@@ -632,6 +797,22 @@ bool FloppyEmulator::writeSector(int track, int sector, const uint8_t* buffer) {
     // that should work regardless of controller state. Real writes via processWriteBit()
     // will respect the write enable signal.
     
+    // Whole-disk mode: re-encode only the data field of the physical sector in place
+    // (address field and gaps stay as they are on the track)
+    if (wholeDiskGCRActive) {
+        int physicalSector = SECTOR_SCRAMBLE_REV[sector];
+        uint8_t* gcrTrack = &diskImage[track * APPLE_II_GCR_BYTES_PER_TRACK];
+        GCRTrackLayout layout;
+        buildGCRTrackLayout(gcrTrack, &layout);
+        if (layout.dataOffset[physicalSector] < 0) {
+            return false;  // No data field for this sector on the track
+        }
+        uint8_t dataField[343];
+        encodeNICDataField(buffer, dataField);
+        copyToGCRTrack(gcrTrack, layout.dataOffset[physicalSector] + 3, dataField, sizeof(dataField));
+        return true;
+    }
+    
     uint32_t offset = calculateTrackOffset(track, sector);
     
     // Copy raw data to disk image
@@ -639,14 +820,15 @@ bool FloppyEmulator::writeSector(int track, int sector, const uint8_t* buffer) {
         diskImage[offset + i] = buffer[i];
     }
     
+    // Encoded copies of this track are stale now - re-encoded on next visit
+    invalidateGCRTrackSlots(track);
+    
     return true;
 }
 
-// GCR bytes per sector in track cache (416 = 6656/16)
-#define GCR_BYTES_PER_SECTOR_IN_CACHE  416
-
 // Get GCR cache contents for a sector
-// Uses current track from cache - each sector occupies 416 bytes in cache
+// Uses current track from cache - returns the bytes from the sector's address field
+// up to the next address field (layout scanned when the track was loaded)
 bool FloppyEmulator::getGCRSectorFromCache(int sector, uint8_t* buffer, uint32_t maxLen, uint32_t* outLen) {
     if (sector < 0 || sector >= APPLE_II_SECTORS_PER_TRACK) return false;
     if (buffer == nullptr || outLen == nullptr) return false;
@@ -656,16 +838,26 @@ bool FloppyEmulator::getGCRSectorFromCache(int sector, uint8_t* buffer, uint32_t
         return false;  // Cache not initialized
     }
     
-    // Calculate offset: each sector occupies 416 bytes in cache
-    uint32_t offset = sector * GCR_BYTES_PER_SECTOR_IN_CACHE;
-    if (offset + GCR_BYTES_PER_SECTOR_IN_CACHE > APPLE_II_GCR_BYTES_PER_TRACK) {
-        return false;
+    const GCRTrackLayout* layout = &gcrTrackMap->layout;
+    int16_t start = layout->addressOffset[sector];
+    if (start < 0) {
+        return false;  // Sector not found on this track
     }
     
-    uint32_t len = (maxLen < GCR_BYTES_PER_SECTOR_IN_CACHE) ? maxLen : GCR_BYTES_PER_SECTOR_IN_CACHE;
-    for (uint32_t i = 0; i < len; i++) {
-        buffer[i] = gcrTrackCache[offset + i];
+    // Sector length = distance to the nearest following address field (whole track if it is the only one)
+    uint32_t sectorLen = APPLE_II_GCR_BYTES_PER_TRACK;
+    for (int s = 0; s < APPLE_II_SECTORS_PER_TRACK; s++) {
+        if (s == sector || layout->addressOffset[s] < 0) {
+            continue;
+        }
+        uint32_t distance = ((uint32_t)layout->addressOffset[s] + APPLE_II_GCR_BYTES_PER_TRACK - start) % APPLE_II_GCR_BYTES_PER_TRACK;
+        if (distance > 0 && distance < sectorLen) {
+            sectorLen = distance;
+        }
     }
+    
+    uint32_t len = (maxLen < sectorLen) ? maxLen : sectorLen;
+    copyFromGCRTrack(gcrTrackCache, start, buffer, len);
     *outLen = len;
     return true;
 }
@@ -676,22 +868,82 @@ uint32_t FloppyEmulator::getCurrentBitPosition() {
     return rotationPosition;
 }
 
+// Prepare for a new disk image to be read into diskImage
+// MUST be called BEFORE SDCardManager::loadDiskImage() overwrites the buffer:
+// - pending writes of the old image are flushed while its data is still intact
+// - the read stream is parked on sync bytes in a track buffer (diskImage may hold GCR tracks)
+// - process() stays idle until loadDiskImage() finishes
+void FloppyEmulator::beginDiskImageLoad() {
+    flushWriteBackQueue();
+    
+    diskImageLoading = true;
+    
+    // Cached tracks belong to the old image
+    invalidateGCRTrackSlots(-1);
+    
+    // Fill a free slot with sync bytes and switch to it immediately
+    uint32_t save = save_and_disable_interrupts();
+    pendingGCRTrackCache = nullptr;
+    pendingGCRTrackMap = nullptr;
+    restore_interrupts(save);
+    critical_section_enter_blocking(&gcrTrackSlotLock);
+    GCRTrackSlot* parkSlot = &gcrTrackSlots[claimGCRTrackSlot()];
+    critical_section_exit(&gcrTrackSlotLock);
+    uint8_t* parkBuffer = parkSlot->buffer;
+    GCRTrackMap* parkMap = &parkSlot->map;
+    parkSlot->data = parkBuffer;
+    memset(parkBuffer, 0xFF, APPLE_II_GCR_BYTES_PER_TRACK);
+    buildGCRTrackMap(parkBuffer, parkMap);  // No fields - all unknown
+    save = save_and_disable_interrupts();
+    wholeDiskGCRActive = false;
+    pendingGCRTrackCache = nullptr;
+    pendingGCRTrackCacheTrack = -1;
+    pendingGCRTrackMap = nullptr;
+    gcrTrackCache = parkBuffer;
+    gcrTrackMap = parkMap;
+    gcrTrackCacheTrack = -1;
+    gcrTrackCacheDirty = false;
+    retargetReadStream(parkBuffer);
+    restore_interrupts(save);
+}
+
+// End a load started by beginDiskImageLoad() that failed (file missing, card error, image too large)
+// diskImage may hold part of the new file: it is blanked like at power-up, no file stays open (nothing
+// is saved back) and process() resumes stepper tracking - the drive reads as an empty disk
+void FloppyEmulator::abortDiskImageLoad() {
+    currentFile.open = false;
+    memset(diskImage, 0, sizeof(diskImage));
+    
+    gcrTrackCacheTrack = -1;
+    gcrTrackCacheDirty = false;
+    memset(gcrTrackDirtySectors, 0, sizeof(gcrTrackDirtySectors));
+    invalidateGCRTrackSlots(-1);
+    diskImageLoading = false;
+}
+
 // Load disk image from external source
+// Note: updateCurrentFileType() must be called before this so the file type (.dsk/.nic) is known
 void FloppyEmulator::loadDiskImage(const uint8_t* image, uint32_t size) {
+    diskImageLoading = true;
     
-    saveGCRCacheToDiskImage();
-
-    uint32_t copySize = size < APPLE_II_DISK_SIZE ? size : APPLE_II_DISK_SIZE;
+    uint32_t maxSize = (currentFileType == DISK_FILE_TYPE_NIC) ? APPLE_II_NIC_DISK_SIZE : APPLE_II_DISK_SIZE;
+    uint32_t copySize = size < maxSize ? size : maxSize;
     
-    for (uint32_t i = 0; i < copySize; i++) {
-        diskImage[i] = image[i];
+    // Image is normally already in diskImage (SDCardManager reads directly into it)
+    if (image != diskImage) {
+        memmove(diskImage, image, copySize);
     }
     
     // Clear remaining space if image is smaller
-    for (uint32_t i = copySize; i < APPLE_II_DISK_SIZE; i++) {
+    for (uint32_t i = copySize; i < maxSize; i++) {
         diskImage[i] = 0;
     }
     
+    // Pre-encode all tracks so track changes only repoint the DMA read address
+    if (wholeDiskGCRMode) {
+        buildWholeDiskGCRImage();
+    }
+    
     // Set initial track to 17 (0x11) for testing direction detection
     // This allows us to see if the system moves toward track 0 or track 34
     // BUT: Sync lastPhaseOffset with hardware FIRST, then set track
@@ -741,6 +993,10 @@ void FloppyEmulator::loadDiskImage(const uint8_t* image, uint32_t size) {
     // Cache will be regenerated automatically in process() when track is accessed
     gcrTrackCacheTrack = -1;
     gcrTrackCacheDirty = false;  // New disk loaded - cache is clean
+    memset(gcrTrackDirtySectors, 0, sizeof(gcrTrackDirtySectors));
+    invalidateGCRTrackSlots(-1);
+    stepDirection = 0;  // Head was moved to track 17 - no direction yet
+    diskImageLoading = false;
     
     // NO printf() here - this may be called from core1 (UI handler) and printf() can block!
 }
@@ -763,32 +1019,58 @@ uint32_t FloppyEmulator::getDiskImageSize() const {
     return APPLE_II_MAX_DISK_SIZE;
 }
 
-// Update rotation position (simulate disk rotation)
+// Update rotation position from the read stream
+// rotationPosition is the GCR bit in gcrTrackCache that is on the READ pin right now
+// (GCR cache has APPLE_II_GCR_BYTES_PER_TRACK bytes = 6656 * 8 = 53248 bits per track)
 void FloppyEmulator::updateRotationPosition() {
-    absolute_time_t now = get_absolute_time();
-    int64_t diff = absolute_time_diff_us(lastBitTime, now);
-    
-    // Update rotation position based on time
-    // rotationPosition represents GCR bit position in gcrTrackCache (for reading via PIO/DMA)
-    // GCR cache has APPLE_II_GCR_BYTES_PER_TRACK bytes = 6656 * 8 = 53248 bits per track
-    uint32_t gcrBitsPerTrack = APPLE_II_GCR_BYTES_PER_TRACK * 8;
-    
-    // Calculate how many bits have elapsed since last update
-    uint32_t bitsElapsed = diff / APPLE_II_BIT_PERIOD_US;
-    
-    // Update rotation position (wrap around at track length)
-    // rotationPosition is now in GCR bit units to match gcrTrackCache
-    rotationPosition = (rotationPosition + bitsElapsed) % gcrBitsPerTrack;
+    rotationPosition = getHeadBitPosition();
     
     // Calculate current sector from rotation position
-    // Each sector is 416 bytes = 3328 bits in GCR cache
-    // Sectors are laid out sequentially: sector 0 at bits 0-3327, sector 1 at bits 3328-6655, etc.
-    const uint32_t GCR_BITS_PER_SECTOR = 416 * 8;  // 3328 bits per sector
-    currentSector = (rotationPosition / GCR_BITS_PER_SECTOR) % APPLE_II_SECTORS_PER_TRACK;
+    // Looked up in the track's position index, so it follows the real layout of the track
+    // (keeps the previous value while the head is over bytes that belong to no sector)
+    uint8_t entry = gcrTrackMap->index[(rotationPosition / 8) % APPLE_II_GCR_BYTES_PER_TRACK];
+    if (entry != GCR_INDEX_UNKNOWN) {
+        currentSector = entry & GCR_INDEX_SECTOR_MASK;
+    }
+}
+
+// Bit on the READ pin now, as bit offset into the streamed track (bit 0 = MSB of gcrTrackCache[0])
+// Words handed to the PIO (DMA transfer count) minus the words still in the TX FIFO give the word in
+// the OSR; the bit counter the PIO publishes every bit cell gives the bit inside it (words are always
+// shifted out whole, and the counter restarts with an empty OSR). The registers are only taken while
+// the program is away from the OUT/autopull and the counter update (5 of the 8 cycles), so they agree.
+uint32_t FloppyEmulator::getHeadBitPosition() {
+    if (!pioDmaActive || dmaChannel < 0 || pio == nullptr) {
+        return rotationPosition;  // Stream not running - the head stays where it was
+    }
+    
+    uint32_t remaining = 0;
+    uint32_t queued = 0;
+    uint32_t bits = 0;
+    uint32_t pc = 0;
+    for (int tries = 0; tries < HEAD_POSITION_TRIES; tries++) {
+        pc = (pio_sm_get_pc(pio, pioSm) - pioOffset) & 0x1F;
+        remaining = dma_channel_hw_addr(dmaChannel)->transfer_count & 0x0FFFFFFFu;
+        queued = pio_sm_get_tx_fifo_level(pio, pioSm);
+        bits = pio->rxf_putget[pioSm][0];
+        uint32_t pcAfter = (pio_sm_get_pc(pio, pioSm) - pioOffset) & 0x1F;
+        if (pc == pcAfter && (pc == 2 || pc == 3 || pc == 5)) {
+            break;
+        }
+        // No stable window (state machine stalled or stopped) - the last read is as good as any
+    }
     
-    // Update lastBitTime to current time
-    // This ensures continuous timing tracking
-    lastBitTime = now;
+    // OUT of this bit cell done (PC 1-4), published count not updated yet
+    if (pc >= 1 && pc <= 4) {
+        bits++;
+    }
+    if (bits == 0) {
+        return 0;  // Nothing shifted out since the restart
+    }
+    
+    uint32_t wordsSent = GCR_STREAM_WORDS_PER_TRACK - remaining;
+    uint32_t word = (wordsSent + 2 * GCR_STREAM_WORDS_PER_TRACK - queued - 1) % GCR_STREAM_WORDS_PER_TRACK;
+    return word * 32 + (bits - 1) % 32;
 }
 
 // Update timing state
@@ -806,12 +1088,12 @@ void FloppyEmulator::updateTiming() {
 
 // Synchronize to index pulse
 void FloppyEmulator::syncToIndex() {
-    // Wait for index pulse
+    // Wait for index pulse (position comes from the read stream)
     while (!indexPulse) {
+        updateRotationPosition();
         updateTiming();
         sleep_us(10);
     }
-    rotationPosition = 0;
 }
 
 // Get bit period in microseconds
@@ -836,47 +1118,53 @@ void FloppyEmulator::setSDCardManager(SDCardManager* sdCard) {
     sdCardManager = sdCard;
 }
 
-// Set current disk image filename
-void FloppyEmulator::setCurrentFileName(const char* filename) {
-    if (filename) {
-        strncpy(currentFileName, filename, sizeof(currentFileName) - 1);
-        currentFileName[sizeof(currentFileName) - 1] = 0;
+FAT32File* FloppyEmulator::getCurrentFile() {
+    return &currentFile;
+}
+
+// Determine file type from the open file's name (.dsk or .nic, case-insensitive)
+void FloppyEmulator::updateCurrentFileType() {
+    currentFileType = DISK_FILE_TYPE_DSK;  // Default: no file, no or unknown extension
+    if (!currentFile.open) {
+        return;
+    }
+    
+    const char* ext = strrchr(currentFile.name, '.');
+    if (ext != nullptr && strlen(ext) >= 4) {
+        // Case-insensitive comparison
+        char ext_lower[5] = {0};
+        for (int i = 0; i < 4 && ext[i+1] != '\0'; i++) {
+            ext_lower[i] = tolower(ext[i+1]);
+        }
         
-        // Determine file type based on extension (.dsk or .nic, case-insensitive)
-        const char* ext = strrchr(filename, '.');
-        if (ext != nullptr && strlen(ext) >= 4) {
-            // Case-insensitive comparison
-            char ext_lower[5] = {0};
-            for (int i = 0; i < 4 && ext[i+1] != '\0'; i++) {
-                ext_lower[i] = tolower(ext[i+1]);
-            }
-            
-            if (strcmp(ext_lower, "dsk") == 0) {
-                currentFileType = DISK_FILE_TYPE_DSK;
-            } else if (strcmp(ext_lower, "nic") == 0) {
-                currentFileType = DISK_FILE_TYPE_NIC;
-            } else {
-                // Unknown extension, default to .dsk
-                currentFileType = DISK_FILE_TYPE_DSK;
-            }
-        } else {
-            // No extension or invalid extension, default to .dsk
-            currentFileType = DISK_FILE_TYPE_DSK;
+        if (strcmp(ext_lower, "nic") == 0) {
+            currentFileType = DISK_FILE_TYPE_NIC;
         }
-    } else {
-        currentFileName[0] = 0;
-        currentFileType = DISK_FILE_TYPE_DSK;  // Reset to default
     }
 }
 
 const char* FloppyEmulator::getCurrentFileName() const {
-    return currentFileName;
+    return currentFile.open ? currentFile.name : "";
 }
 
 DiskFileType FloppyEmulator::getCurrentFileType() const {
     return currentFileType;
 }
 
+// Select whole-disk GCR mode (true) or per-track encoding (false)
+// Takes effect on the next loadDiskImage() - the current image keeps its layout
+void FloppyEmulator::setWholeDiskGCRMode(bool enabled) {
+    wholeDiskGCRMode = enabled;
+}
+
+bool FloppyEmulator::getWholeDiskGCRMode() const {
+    return wholeDiskGCRMode;
+}
+
+bool FloppyEmulator::isWholeDiskGCRActive() const {
+    return wholeDiskGCRActive;
+}
+
 // Timer callback function for precise bit timing
 // This is called every 8 microseconds when timer is active
 bool bitTimerCallback(repeating_timer_t *rt) {
@@ -959,330 +1247,798 @@ static void writeAAVal(uint8_t val, uint8_t* buffer, uint32_t* index) {
     buffer[(*index)++] = 0xAA | val;
 }
 
-// Update GCR track cache for current track (Apple II NIC format)
-void FloppyEmulator::updateGCRTrackCache() {
-    // For NIC files, copy GCR data directly from diskImage buffer (already in GCR format)
-    if (currentFileType == DISK_FILE_TYPE_NIC) {
-        // NIC format: each track is 8192 bytes in file (16 sectors * 512 bytes)
-        // But we only use first 416 bytes from each sector = 6656 bytes per track
-        uint32_t trackOffsetInFile = currentTrack * APPLE_II_NIC_BYTES_PER_TRACK;  // Offset in NIC file (8192 bytes per track)
+// Encode one physical sector into 416 GCR bytes (Apple II 6-and-2 format)
+// Layout: 22 sync + 12 sync pattern + address field (D5 AA 96 ... DE AA EB) + 5 sync +
+//         data field (D5 AA AD + 343 bytes + DE AA EB) + 14 sync = 416 bytes
+void FloppyEmulator::encodeGCRSector(uint8_t track, uint8_t physicalSector, const uint8_t* sectorData, uint8_t* gcr) {
+    uint32_t gcrIndex = 0;
+    uint8_t volume = 0xFE;  // Default volume
+    
+    // 22 sync bytes (0xFF)
+    for (int i = 0; i < 22; i++) {
+        gcr[gcrIndex++] = 0xFF;
+    }
+    
+    // Sync pattern
+    gcr[gcrIndex++] = 0x03;
+    gcr[gcrIndex++] = 0xFC;
+    gcr[gcrIndex++] = 0xFF;
+    gcr[gcrIndex++] = 0x3F;
+    gcr[gcrIndex++] = 0xCF;
+    gcr[gcrIndex++] = 0xF3;
+    gcr[gcrIndex++] = 0xFC;
+    gcr[gcrIndex++] = 0xFF;
+    gcr[gcrIndex++] = 0x3F;
+    gcr[gcrIndex++] = 0xCF;
+    gcr[gcrIndex++] = 0xF3;
+    gcr[gcrIndex++] = 0xFC;
+    
+    // Address field prologue
+    gcr[gcrIndex++] = 0xD5;
+    gcr[gcrIndex++] = 0xAA;
+    gcr[gcrIndex++] = 0x96;
+    
+    // Address field: volume, track, sector, checksum (using writeAAVal format)
+    writeAAVal(volume, gcr, &gcrIndex);
+    writeAAVal(track, gcr, &gcrIndex);
+    writeAAVal(physicalSector, gcr, &gcrIndex);
+    writeAAVal(volume ^ track ^ physicalSector, gcr, &gcrIndex);
+    
+    // Address field epilogue
+    gcr[gcrIndex++] = 0xDE;
+    gcr[gcrIndex++] = 0xAA;
+    gcr[gcrIndex++] = 0xEB;
+    
+    // 5 sync bytes (0xFF)
+    for (int i = 0; i < 5; i++) {
+        gcr[gcrIndex++] = 0xFF;
+    }
+    
+    // Data field prologue
+    gcr[gcrIndex++] = 0xD5;
+    gcr[gcrIndex++] = 0xAA;
+    gcr[gcrIndex++] = 0xAD;
+    
+    // 343 bytes NIC-encoded data field (86 FlipBit + 256 + checksum)
+    encodeNICDataField(sectorData, &gcr[gcrIndex]);
+    gcrIndex += 343;
+    
+    // Data field epilogue
+    gcr[gcrIndex++] = 0xDE;
+    gcr[gcrIndex++] = 0xAA;
+    gcr[gcrIndex++] = 0xEB;
+    
+    // 14 sync bytes (0xFF) - total is exactly 416 bytes
+    for (int i = 0; i < 14; i++) {
+        gcr[gcrIndex++] = 0xFF;
+    }
+}
+
+// Bytes already queued in the PIO TX FIFO/OSR behind the DMA read position
+// (4 FIFO words + the OSR word). The swap waits until these are gap bytes too - the controller
+// sees complete old fields followed by complete new fields.
+#define GCR_SWAP_QUEUED_BYTES  20
+
+// Swap is safe where a track has a gap after a data field (or no fields at all)
+// The gap between address and data field is not safe - the data field would belong to another track.
+static inline bool isGCRSwapSafe(uint8_t entry) {
+    return entry == GCR_INDEX_UNKNOWN || (entry >> GCR_INDEX_FIELD_SHIFT) == GCR_FIELD_GAP;
+}
+
+// Slot holding track, or -1 - gcrTrackSlotLock must be held
+int FloppyEmulator::findGCRTrackSlot(int track) {
+    for (int i = 0; i < GCR_TRACK_CACHE_SLOTS; i++) {
+        if (gcrTrackSlots[i].track == track) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Least recently used slot that can be refilled - gcrTrackSlotLock must be held
+// The streamed and the pending slot are never given out (DMA reads them), neither are busy slots.
+// With GCR_TRACK_CACHE_SLOTS >= 4 and at most one busy slot per core there is always one left.
+int FloppyEmulator::claimGCRTrackSlot() {
+    // Pending first: a swap in swapPendingGCRTrackCache() on core0 moves pending -> front, never the other way
+    const GCRTrackMap* pendingMap = pendingGCRTrackMap;
+    const GCRTrackMap* frontMap = gcrTrackMap;
+    int best = -1;
+    for (int i = 0; i < GCR_TRACK_CACHE_SLOTS; i++) {
+        GCRTrackSlot* slot = &gcrTrackSlots[i];
+        if (slot->busy || &slot->map == frontMap || &slot->map == pendingMap) {
+            continue;
+        }
+        if (slot->track < 0) {
+            best = i;  // Empty slot - nothing to evict
+            break;
+        }
+        if (best < 0 || slot->lastUse < gcrTrackSlots[best].lastUse) {
+            best = i;
+        }
+    }
+    GCRTrackSlot* slot = &gcrTrackSlots[best];
+    slot->track = -1;
+    slot->prefetched = false;
+    slot->lastUse = ++gcrTrackSlotClock;
+    return best;
+}
+
+// Encode track into a claimed slot (the slot must be busy or not visible to the other core)
+void FloppyEmulator::fillGCRTrackSlot(int slotIndex, int track) {
+    GCRTrackSlot* slot = &gcrTrackSlots[slotIndex];
+    uint8_t* trackData;
+    
+    if (wholeDiskGCRActive) {
+        // Whole-disk mode: all tracks are already encoded in diskImage - nothing to encode
+        trackData = &diskImage[track * APPLE_II_GCR_BYTES_PER_TRACK];
+    } else {
+        // Per-track mode: encode into the slot's own buffer
+        trackData = slot->buffer;
         
-        // Copy 416 bytes from each of the 16 sectors directly to GCR cache
-        for (int sector = 0; sector < 16; sector++) {
-            uint32_t sectorOffsetInFile = trackOffsetInFile + (sector * 512);  // 512 bytes per sector in file
-            uint32_t sectorOffsetInCache = sector * 416;  // 416 bytes per sector in cache
+        // diskImage holds this track's writes only after core1 has saved its snapshot
+        while (isWriteBackPending(track)) {
+            tight_loop_contents();
+        }
+        
+        if (currentFileType == DISK_FILE_TYPE_NIC) {
+            // For NIC files, copy GCR data directly from diskImage buffer (already in GCR format)
+            // NIC format: each track is 8192 bytes in file (16 sectors * 512 bytes)
+            // But we only use first 416 bytes from each sector = 6656 bytes per track
+            uint32_t trackOffsetInFile = track * APPLE_II_NIC_BYTES_PER_TRACK;  // Offset in NIC file (8192 bytes per track)
+            
+            // Copy 416 bytes from each of the 16 sectors directly to GCR cache
+            for (int sector = 0; sector < 16; sector++) {
+                uint32_t sectorOffsetInFile = trackOffsetInFile + (sector * 512);  // 512 bytes per sector in file
+                uint32_t sectorOffsetInCache = sector * 416;  // 416 bytes per sector in cache
+                memcpy(trackData + sectorOffsetInCache, diskImage + sectorOffsetInFile, 416);
+            }
+        } else {
+            // For DSK files, encode from diskImage buffer
+            uint32_t trackOffset = track * APPLE_II_BYTES_PER_TRACK;
             
-            // Copy first 416 bytes from file sector to GCR cache
-            if (sectorOffsetInFile + 416 <= APPLE_II_NIC_DISK_SIZE && 
-                sectorOffsetInCache + 416 <= APPLE_II_GCR_BYTES_PER_TRACK) {
-                memcpy(gcrTrackCache + sectorOffsetInCache, diskImage + sectorOffsetInFile, 416);
+            // Process each sector in track (using scrambled sector order)
+            // Each sector is exactly 416 bytes, total track is 6656 bytes (16 * 416)
+            for (int sector = 0; sector < APPLE_II_SECTORS_PER_TRACK; sector++) {
+                int scrambledSector = SECTOR_SCRAMBLE[sector];
+                uint32_t sectorOffset = trackOffset + (scrambledSector * APPLE_II_BYTES_PER_SECTOR);
+                
+                encodeGCRSector(track, sector, &diskImage[sectorOffset],
+                                &trackData[sector * APPLE_II_GCR_BYTES_PER_SECTOR]);
             }
         }
+    }
+    
+    // Field layout and sector/field lookup table (built from the track itself, so NIC layouts work too)
+    buildGCRTrackMap(trackData, &slot->map);
+    slot->data = trackData;
+}
+
+// Drop cached copies of a track (-1 = all) after its source data changed
+// A slot being filled keeps busy, but its track is cleared so the result is never used.
+void FloppyEmulator::invalidateGCRTrackSlots(int track) {
+    critical_section_enter_blocking(&gcrTrackSlotLock);
+    for (int i = 0; i < GCR_TRACK_CACHE_SLOTS; i++) {
+        if (track < 0 || gcrTrackSlots[i].track == track) {
+            gcrTrackSlots[i].track = -1;
+            gcrTrackSlots[i].prefetched = false;
+        }
+    }
+    critical_section_exit(&gcrTrackSlotLock);
+}
+
+// Update GCR track cache for current track (Apple II NIC format)
+// The track is taken from the slot cache (hit) or encoded into a free slot (miss);
+// swapPendingGCRTrackCache() makes it the front buffer
+void FloppyEmulator::updateGCRTrackCache() {
+    int track = currentTrack;
+    
+    // Cancel a swap that is still pending - its slot may be reused below
+    uint32_t save = save_and_disable_interrupts();
+    pendingGCRTrackCache = nullptr;
+    pendingGCRTrackCacheTrack = -1;
+    pendingGCRTrackMap = nullptr;
+    restore_interrupts(save);
+    
+    critical_section_enter_blocking(&gcrTrackSlotLock);
+    int slotIndex = findGCRTrackSlot(track);
+    if (slotIndex >= 0 && gcrTrackSlots[slotIndex].busy) {
+        // core1 is prefetching exactly this track - waiting is never slower than encoding it here
+        critical_section_exit(&gcrTrackSlotLock);
+        while (gcrTrackSlots[slotIndex].busy) {
+            tight_loop_contents();
+        }
+        critical_section_enter_blocking(&gcrTrackSlotLock);
+        if (gcrTrackSlots[slotIndex].track != track) {
+            slotIndex = -1;  // Invalidated while being filled
+        }
+    }
+    
+    if (slotIndex >= 0) {
+        gcrTrackCacheStats.hits++;
+        if (gcrTrackSlots[slotIndex].prefetched) {
+            gcrTrackCacheStats.prefetchHits++;
+            gcrTrackSlots[slotIndex].prefetched = false;
+        }
+        gcrTrackSlots[slotIndex].lastUse = ++gcrTrackSlotClock;
+    } else {
+        // Miss - encode here; busy + track keep core1 from evicting or prefetching it twice
+        gcrTrackCacheStats.misses++;
+        slotIndex = claimGCRTrackSlot();
+        gcrTrackSlots[slotIndex].busy = true;
+        gcrTrackSlots[slotIndex].track = track;
+        critical_section_exit(&gcrTrackSlotLock);
+        
+        fillGCRTrackSlot(slotIndex, track);
         
-        gcrTrackCacheTrack = currentTrack;
-        gcrTrackCacheBits = APPLE_II_GCR_BYTES_PER_TRACK * 8;
-        gcrTrackCacheDirty = false;  // Cache is clean after loading from buffer
+        critical_section_enter_blocking(&gcrTrackSlotLock);
+        gcrTrackSlots[slotIndex].busy = false;
+    }
+    
+    // Arm the swap while the slot is still protected by the lock (pending slots are never evicted)
+    // Swap is done here if the stream is in a gap, otherwise by process()
+    // (the lock also disables interrupts on this core, like save_and_disable_interrupts())
+    GCRTrackSlot* slot = &gcrTrackSlots[slotIndex];
+    pendingGCRTrackCacheTrack = track;
+    pendingGCRTrackMap = &slot->map;
+    pendingGCRTrackCache = slot->data;
+    critical_section_exit(&gcrTrackSlotLock);
+    
+    swapPendingGCRTrackCache();
+}
+
+// Fill a cache slot with the track the head is most likely to step to next (runs on core1)
+// Direction of travel first, then the other neighbour; at most one track per call so the
+// CLI/UI loop stays responsive. core0 picks the slot up in updateGCRTrackCache() on arrival.
+void FloppyEmulator::prefetchNeighborTrack() {
+    if (diskImageLoading || writeCaptureActive || writeIrqTimerActive || gcrTrackCacheTrack < 0) {
         return;
     }
     
-    // For DSK files, encode from diskImage buffer
-    uint32_t gcrIndex = 0;
-    uint32_t maxGcrBytes = APPLE_II_GCR_BYTES_PER_TRACK;
-    uint8_t volume = 0xFE;  // Default volume
-    uint8_t src[256 + 2];
+    int direction = stepDirection;
+    if (direction == 0) {
+        return;  // No step seen yet
+    }
     
-    // Get track offset in disk image
-    uint32_t trackOffset = currentTrack * APPLE_II_BYTES_PER_TRACK;
+    int track = currentTrack;
+    int candidates[2] = { track + direction, track - direction };
     
-    // Process each sector in track (using scrambled sector order)
-    // Each sector is exactly 416 bytes, total track is 6656 bytes (16 * 416)
-    // Process all 16 sectors (don't use gcrIndex check - it prevents last sector from being generated)
-    for (int sector = 0; sector < APPLE_II_SECTORS_PER_TRACK; sector++) {
-        int scrambledSector = SECTOR_SCRAMBLE[sector];
-        uint32_t sectorOffset = trackOffset + (scrambledSector * APPLE_II_BYTES_PER_SECTOR);
-        
-        // 22 sync bytes (0xFF)
-        for (int i = 0; i < 22 && gcrIndex < maxGcrBytes; i++) {
-            gcrTrackCache[gcrIndex++] = 0xFF;
+    for (int i = 0; i < 2; i++) {
+        int candidate = candidates[i];
+        if (candidate < 0 || candidate >= APPLE_II_TRACKS || isWriteBackPending(candidate)) {
+            continue;  // Off the disk, or written track not saved yet (processWriteBackQueue() runs first)
         }
         
-        // Sync pattern
-        if (gcrIndex + 11 <= maxGcrBytes) {
-            gcrTrackCache[gcrIndex++] = 0x03;
-            gcrTrackCache[gcrIndex++] = 0xFC;
-            gcrTrackCache[gcrIndex++] = 0xFF;
-            gcrTrackCache[gcrIndex++] = 0x3F;
-            gcrTrackCache[gcrIndex++] = 0xCF;
-            gcrTrackCache[gcrIndex++] = 0xF3;
-            gcrTrackCache[gcrIndex++] = 0xFC;
-            gcrTrackCache[gcrIndex++] = 0xFF;
-            gcrTrackCache[gcrIndex++] = 0x3F;
-            gcrTrackCache[gcrIndex++] = 0xCF;
-            gcrTrackCache[gcrIndex++] = 0xF3;
-            gcrTrackCache[gcrIndex++] = 0xFC;
+        critical_section_enter_blocking(&gcrTrackSlotLock);
+        if (findGCRTrackSlot(candidate) >= 0) {
+            critical_section_exit(&gcrTrackSlotLock);
+            continue;  // Already cached (or being filled)
         }
+        int slotIndex = claimGCRTrackSlot();
+        GCRTrackSlot* slot = &gcrTrackSlots[slotIndex];
+        slot->busy = true;
+        slot->track = candidate;  // Visible as "being filled" - core0 waits instead of encoding twice
+        critical_section_exit(&gcrTrackSlotLock);
         
-        // Address field prologue
-        if (gcrIndex + 3 <= maxGcrBytes) {
-            gcrTrackCache[gcrIndex++] = 0xD5;
-            gcrTrackCache[gcrIndex++] = 0xAA;
-            gcrTrackCache[gcrIndex++] = 0x96;
-        }
+        fillGCRTrackSlot(slotIndex, candidate);
         
-        // Address field: volume, track, sector, checksum (using writeAAVal format)
-        if (gcrIndex + 8 <= maxGcrBytes) {
-            writeAAVal(volume, gcrTrackCache, &gcrIndex);
-            writeAAVal(currentTrack, gcrTrackCache, &gcrIndex);
-            writeAAVal(sector, gcrTrackCache, &gcrIndex);
-            writeAAVal(volume ^ currentTrack ^ sector, gcrTrackCache, &gcrIndex);
+        critical_section_enter_blocking(&gcrTrackSlotLock);
+        if (slot->track == candidate) {
+            slot->prefetched = true;
+            gcrTrackCacheStats.prefetches++;
         }
-        
-        // Address field epilogue
-        if (gcrIndex + 3 <= maxGcrBytes) {
-            gcrTrackCache[gcrIndex++] = 0xDE;
-            gcrTrackCache[gcrIndex++] = 0xAA;
-            gcrTrackCache[gcrIndex++] = 0xEB;
+        slot->busy = false;
+        critical_section_exit(&gcrTrackSlotLock);
+        return;
+    }
+}
+
+void FloppyEmulator::getTrackCacheStats(GCRTrackCacheStats* stats) {
+    critical_section_enter_blocking(&gcrTrackSlotLock);
+    *stats = gcrTrackCacheStats;
+    stats->frontSlot = -1;
+    for (int i = 0; i < GCR_TRACK_CACHE_SLOTS; i++) {
+        stats->slotTrack[i] = gcrTrackSlots[i].track;
+        if (&gcrTrackSlots[i].map == gcrTrackMap) {
+            stats->frontSlot = i;
         }
-        
-        // 5 sync bytes (0xFF)
-        for (int i = 0; i < 5 && gcrIndex < maxGcrBytes; i++) {
-            gcrTrackCache[gcrIndex++] = 0xFF;
+    }
+    stats->direction = stepDirection;
+    critical_section_exit(&gcrTrackSlotLock);
+}
+
+void FloppyEmulator::resetTrackCacheStats() {
+    critical_section_enter_blocking(&gcrTrackSlotLock);
+    gcrTrackCacheStats.hits = 0;
+    gcrTrackCacheStats.misses = 0;
+    gcrTrackCacheStats.prefetches = 0;
+    gcrTrackCacheStats.prefetchHits = 0;
+    critical_section_exit(&gcrTrackSlotLock);
+}
+
+// Make the pending back buffer the streamed front buffer
+// Only swaps while the DMA read position is inside a sync gap of both tracks (looked up in the
+// track maps), so no address or data field is ever split between two tracks. Returns true if swapped.
+bool FloppyEmulator::swapPendingGCRTrackCache() {
+    if (pendingGCRTrackCache == nullptr) {
+        return false;
+    }
+    
+    // Writes to the old track must be queued for write-back before its slot can be reused
+    // (queue full - keep streaming the old track and try again on the next process() call)
+    if (gcrTrackCacheDirty && !saveGCRCacheToDiskImage()) {
+        return false;
+    }
+    
+    uint32_t save = save_and_disable_interrupts();
+    
+    uint8_t* newBase = pendingGCRTrackCache;
+    if (newBase == nullptr) {
+        restore_interrupts(save);
+        return false;  // Swapped by the other core in the meantime
+    }
+    
+    bool streaming = pioDmaActive && dmaChannel >= 0 && gcrTrackCacheTrack >= 0;
+    if (streaming) {
+        uint32_t offset = (dma_channel_hw_addr(dmaChannel)->read_addr - (uint32_t)gcrTrackCache) % APPLE_II_GCR_BYTES_PER_TRACK;
+        uint32_t headOffset = getHeadBitPosition() / 8;  // Bytes from here to offset are already queued
+        // Gaps are longer than the queued bytes, so checking both ends covers the whole range
+        if (!isGCRSwapSafe(gcrTrackMap->index[headOffset]) || !isGCRSwapSafe(gcrTrackMap->index[offset]) ||
+            !isGCRSwapSafe(pendingGCRTrackMap->index[offset])) {
+            restore_interrupts(save);
+            return false;  // Inside a field - try again on next process() call
         }
-        
-        // Data field prologue
-        if (gcrIndex + 3 <= maxGcrBytes) {
-            gcrTrackCache[gcrIndex++] = 0xD5;
-            gcrTrackCache[gcrIndex++] = 0xAA;
-            gcrTrackCache[gcrIndex++] = 0xAD;
+    }
+    
+    gcrTrackCache = newBase;
+    gcrTrackMap = pendingGCRTrackMap;
+    gcrTrackCacheTrack = pendingGCRTrackCacheTrack;
+    gcrTrackCacheBits = APPLE_II_GCR_BYTES_PER_TRACK * 8;
+    gcrTrackCacheDirty = false;
+    pendingGCRTrackCache = nullptr;
+    pendingGCRTrackCacheTrack = -1;
+    pendingGCRTrackMap = nullptr;
+    
+    // Continue streaming from the same rotational position in the new track
+    retargetReadStream(newBase);
+    
+    restore_interrupts(save);
+    return true;
+}
+
+// Find the real field positions of one GCR track
+// Scans the track once (with wrap-around) for address fields D5 AA 96 with a valid sector number,
+// then for the D5 AA AD data prologue between each address field and the next one.
+// A sector number seen twice keeps its first address field.
+void FloppyEmulator::buildGCRTrackLayout(const uint8_t* track, GCRTrackLayout* layout) {
+    const uint32_t N = APPLE_II_GCR_BYTES_PER_TRACK;
+    uint16_t addressPos[32];
+    uint8_t addressSector[32];
+    int addressCount = 0;
+    
+    memset(layout, 0xFF, sizeof(GCRTrackLayout));  // All offsets -1
+    
+    for (uint32_t i = 0; i < N && addressCount < 32; i++) {
+        if (track[i] == 0xD5 && track[(i + 1) % N] == 0xAA && track[(i + 2) % N] == 0x96) {
+            uint8_t sector = ((track[(i + 7) % N] & 0x55) << 1) | (track[(i + 8) % N] & 0x55);
+            if (sector < APPLE_II_SECTORS_PER_TRACK) {
+                addressPos[addressCount] = (uint16_t)i;
+                addressSector[addressCount] = sector;
+                addressCount++;
+            }
         }
+    }
+    
+    for (int a = 0; a < addressCount; a++) {
+        uint8_t sector = addressSector[a];
+        if (layout->addressOffset[sector] >= 0) {
+            continue;  // Duplicate sector number - keep the first one
+        }
+        uint32_t start = addressPos[a];
+        uint32_t length = (a + 1 < addressCount) ? (uint32_t)(addressPos[a + 1] - start) : (N - start + addressPos[0]);
+        layout->addressOffset[sector] = (int16_t)start;
         
-        // Read sector data
-        for (int i = 0; i < 256; i++) {
-            if (sectorOffset + i < APPLE_II_DISK_SIZE) {
-                src[i] = diskImage[sectorOffset + i];
-            } else {
-                src[i] = 0;
+        for (uint32_t j = GCR_ADDRESS_FIELD_SIZE; j + 2 < length; j++) {
+            uint32_t pos = (start + j) % N;
+            if (track[pos] == 0xD5 && track[(pos + 1) % N] == 0xAA && track[(pos + 2) % N] == 0xAD) {
+                layout->dataOffset[sector] = (int16_t)pos;
+                break;
             }
         }
-        src[256] = src[257] = 0;
-        
-        // Encode first 86 bytes (special encoding with FlipBit tables)
-        uint8_t ox = 0;
-        for (int i = 0; i < 86 && gcrIndex < maxGcrBytes; i++) {
-            uint8_t x = (FLIP_BIT1[src[i] & 3] | FLIP_BIT2[src[i + 86] & 3] | FLIP_BIT3[src[i + 172] & 3]);
-            uint8_t encoded = NIC_ENCODE_TABLE[(x ^ ox) & 0x3F];
-            gcrTrackCache[gcrIndex++] = encoded;
-            ox = x;
+    }
+}
+
+// Build layout and position index for one GCR track (see GCR_INDEX_ENTRY)
+// - every byte from an address prologue up to the next one belongs to that sector
+//   (bytes before the first address field belong to the last sector - the track is circular)
+// - address field (14 bytes) and data field (349 bytes) are marked with their field type,
+//   the bytes between them are GCR_FIELD_ADDRESS_GAP, the rest GCR_FIELD_GAP
+void FloppyEmulator::buildGCRTrackMap(const uint8_t* track, GCRTrackMap* map) {
+    const uint32_t N = APPLE_II_GCR_BYTES_PER_TRACK;
+    uint16_t addressPos[APPLE_II_SECTORS_PER_TRACK];
+    uint8_t addressSector[APPLE_II_SECTORS_PER_TRACK];
+    int addressCount = 0;
+    
+    buildGCRTrackLayout(track, &map->layout);
+    
+    // Address fields in track order (insertion sort - at most 16)
+    for (int sector = 0; sector < APPLE_II_SECTORS_PER_TRACK; sector++) {
+        int16_t pos = map->layout.addressOffset[sector];
+        if (pos < 0) {
+            continue;
         }
-        
-        // Encode all 256 bytes (standard encoding: src[i] >> 2)
-        for (int i = 0; i < 256 && gcrIndex < maxGcrBytes; i++) {
-            uint8_t x = (src[i] >> 2);
-            uint8_t encoded = NIC_ENCODE_TABLE[(x ^ ox) & 0x3F];
-            gcrTrackCache[gcrIndex++] = encoded;
-            ox = x;
+        int k = addressCount++;
+        while (k > 0 && addressPos[k - 1] > (uint16_t)pos) {
+            addressPos[k] = addressPos[k - 1];
+            addressSector[k] = addressSector[k - 1];
+            k--;
         }
+        addressPos[k] = (uint16_t)pos;
+        addressSector[k] = (uint8_t)sector;
+    }
+    
+    if (addressCount == 0) {
+        memset(map->index, GCR_INDEX_UNKNOWN, N);
+        return;
+    }
+    
+    for (int a = 0; a < addressCount; a++) {
+        uint32_t start = addressPos[a];
+        uint32_t length = (a + 1 < addressCount) ? (uint32_t)(addressPos[a + 1] - start) : (N - start + addressPos[0]);
+        uint8_t sector = addressSector[a];
+        int16_t dataPos = map->layout.dataOffset[sector];
+        // Distance from address prologue to data prologue (whole span if there is no data field)
+        uint32_t dataStart = (dataPos >= 0) ? ((uint32_t)dataPos + N - start) % N : length;
         
-        // Last byte
-        if (gcrIndex < maxGcrBytes) {
-            gcrTrackCache[gcrIndex++] = NIC_ENCODE_TABLE[ox & 0x3F];
+        for (uint32_t j = 0; j < length; j++) {
+            GCRFieldType field;
+            if (j < GCR_ADDRESS_FIELD_SIZE) {
+                field = GCR_FIELD_ADDRESS;
+            } else if (j < dataStart) {
+                field = (dataPos >= 0) ? GCR_FIELD_ADDRESS_GAP : GCR_FIELD_GAP;
+            } else if (j < dataStart + GCR_DATA_FIELD_SIZE) {
+                field = GCR_FIELD_DATA;
+            } else {
+                field = GCR_FIELD_GAP;
+            }
+            map->index[(start + j) % N] = GCR_INDEX_ENTRY(sector, field);
         }
-        
-        // Data field epilogue
-        if (gcrIndex + 3 <= maxGcrBytes) {
-            gcrTrackCache[gcrIndex++] = 0xDE;
-            gcrTrackCache[gcrIndex++] = 0xAA;
-            gcrTrackCache[gcrIndex++] = 0xEB;
+    }
+}
+
+// Convert diskImage in place into 35 contiguous GCR tracks (6656 bytes each, 232960 bytes total)
+// NIC: compact each 512-byte sector to its 416 used bytes (forward move, never overlaps unread data)
+// DSK: move raw data (143360 bytes) to the upper half of diskImage, then encode track by track
+//      into the lower part. Track t writes [t*6656, (t+1)*6656) and reads from 143360 + t*4096,
+//      which stays ahead of the writer for all 35 tracks.
+void FloppyEmulator::buildWholeDiskGCRImage() {
+    if (currentFileType == DISK_FILE_TYPE_NIC) {
+        for (uint32_t sector = 0; sector < APPLE_II_TRACKS * APPLE_II_SECTORS_PER_TRACK; sector++) {
+            memmove(&diskImage[sector * APPLE_II_GCR_BYTES_PER_SECTOR], &diskImage[sector * 512], APPLE_II_GCR_BYTES_PER_SECTOR);
         }
+    } else {
+        const uint32_t rawOffset = APPLE_II_MAX_DISK_SIZE - APPLE_II_DISK_SIZE;  // 143360
+        memcpy(&diskImage[rawOffset], diskImage, APPLE_II_DISK_SIZE);
         
-        // 14 sync bytes (0xFF)
-        for (int i = 0; i < 14 && gcrIndex < maxGcrBytes; i++) {
-            gcrTrackCache[gcrIndex++] = 0xFF;
+        for (int track = 0; track < APPLE_II_TRACKS; track++) {
+            const uint8_t* rawTrack = &diskImage[rawOffset + track * APPLE_II_BYTES_PER_TRACK];
+            uint8_t* gcrTrack = &diskImage[track * APPLE_II_GCR_BYTES_PER_TRACK];
+            for (int sector = 0; sector < APPLE_II_SECTORS_PER_TRACK; sector++) {
+                encodeGCRSector(track, sector, &rawTrack[SECTOR_SCRAMBLE[sector] * APPLE_II_BYTES_PER_SECTOR],
+                                &gcrTrack[sector * APPLE_II_GCR_BYTES_PER_SECTOR]);
+            }
         }
-        
-        // Total per sector should be exactly 416 bytes = 6656 bytes per track (16 * 416)
-        // Add 1 padding byte to reach 416 bytes per sector
-        //if (gcrIndex < maxGcrBytes) {
-        //    gcrTrackCache[gcrIndex++] = 0x00;
-        //}
     }
     
-    // Fill remaining cache with zeros if needed
-    // NOTE: This should NOT execute if all 16 sectors are correctly written (16 * 416 = 6656 bytes)
-    // If it does execute, it might overwrite part of the last sector, so we add a safety check
-    // Only fill if we're significantly short (more than 1 byte), to avoid overwriting sector 15
-    if (gcrIndex < maxGcrBytes - 1) {
-        while (gcrIndex < maxGcrBytes) {
-            gcrTrackCache[gcrIndex++] = 0;
-        }
+    // Unused tail (raw copy for DSK, NIC padding) - clear it
+    memset(&diskImage[APPLE_II_GCR_DISK_SIZE], 0, APPLE_II_MAX_DISK_SIZE - APPLE_II_GCR_DISK_SIZE);
+    
+    wholeDiskGCRActive = true;
+}
+
+// Repoint the running read DMA to another track buffer without restarting the revolution
+// Keeps the current byte offset so the controller sees the new track from the same rotational
+// position (like a real head stepping over a spinning disk).
+void FloppyEmulator::retargetReadStream(const uint8_t* newBase) {
+    if (!pioDmaActive || dmaChannel < 0) {
+        return;  // Stream not running - startPIO_DMA() will pick up gcrTrackCache
+    }
+    
+    uint32_t save = save_and_disable_interrupts();
+    
+    haltReadStream();
+    
+    // Remaining transfers (words) tell us where in the revolution we are
+    uint32_t remaining = dma_channel_hw_addr(dmaChannel)->transfer_count & 0x0FFFFFFFu;
+    if (remaining == 0 || remaining > GCR_STREAM_WORDS_PER_TRACK) {
+        remaining = GCR_STREAM_WORDS_PER_TRACK;  // Revolution just ended - start from beginning
     }
     
-    gcrTrackCacheTrack = currentTrack;
-    gcrTrackCacheBits = gcrIndex * 8;  // Total GCR bits in cache
-    gcrTrackCacheDirty = false;  // Cache is clean after loading
+    // Finish this revolution from the new buffer; the control channel continues with it
+    resumeReadStream(newBase, (GCR_STREAM_WORDS_PER_TRACK - remaining) * 4);
+    
+    restore_interrupts(save);
 }
 
 
 bool FloppyEmulator::getGCRTrackCacheDirty() {
-    return gcrTrackCacheDirty;
+    return gcrTrackCacheDirty || writeBackHead != writeBackTail;  // Written data not on the SD card yet
 }
-// Save GCR cache back to disk image
-// Called before track change if the cache has been modified (dirty)
-// For DSK files: Decodes all 16 sectors from GCR cache and writes them to the disk image
-// For NIC files: Saves GCR cache directly to diskImage buffer (already in GCR format)
-void FloppyEmulator::saveGCRCacheToDiskImage() {
+// Queue the written sectors of the streamed track for write-back
+// Fast enough for the stepper timer IRQ: only copies the track and its layout into the
+// write-back queue - decoding and the SD card write run on core1 (processWriteBackQueue()).
+// Returns false if the queue is full: the track stays dirty and is queued on a later call.
+bool FloppyEmulator::saveGCRCacheToDiskImage() {
     // Only save if cache is valid and dirty
     if (gcrTrackCacheTrack < 0 || gcrTrackCacheTrack >= APPLE_II_TRACKS || !gcrTrackCacheDirty) {
-        return;
+        return true;
+    }
+    
+    // Same lock as the track slots - serializes producers on both cores (and disables interrupts)
+    critical_section_enter_blocking(&gcrTrackSlotLock);
+    if (!gcrTrackCacheDirty) {
+        critical_section_exit(&gcrTrackSlotLock);
+        return true;  // Queued by the other caller in the meantime
     }
     
-    //printf("saveGCRCacheToDiskImage\r\n");
-    printf("saveGCRCacheToDiskImage: Saving track %d...\r\n", gcrTrackCacheTrack);
+    uint32_t head = writeBackHead;
+    if (head - writeBackTail >= WRITE_BACK_QUEUE_DEPTH) {
+        writeBackDeferredCount++;
+        critical_section_exit(&gcrTrackSlotLock);
+        return false;
+    }
+    
+    int track = gcrTrackCacheTrack;
+    uint16_t dirtySectors = gcrTrackDirtySectors[track];  // Bit per physical sector
+    gcrTrackDirtySectors[track] = 0;
+    gcrTrackCacheDirty = false;
     
-    // For NIC files, save GCR cache directly to diskImage buffer (no decoding needed)
+    if (dirtySectors != 0) {
+        WriteBackEntry* entry = &writeBackQueue[head % WRITE_BACK_QUEUE_DEPTH];
+        entry->track = track;
+        entry->dirtySectors = dirtySectors;
+        entry->layout = gcrTrackMap->layout;
+        memcpy(entry->gcr, gcrTrackCache, APPLE_II_GCR_BYTES_PER_TRACK);
+        writeBackQueuedPerTrack[track]++;
+        writeBackQueuedCount++;
+        __dmb();  // Entry must be visible to core1 before the new head
+        writeBackHead = head + 1;
+    }
+    
+    critical_section_exit(&gcrTrackSlotLock);
+    return true;
+}
+
+// Save the oldest queued snapshot (core1 only - the single consumer)
+// Its SD card writes usually go to the async engine: the entry then stays at the tail (in flight)
+// and later calls return true without doing anything until the completion callbacks have run
+bool FloppyEmulator::processWriteBackQueue() {
+    uint32_t tail = writeBackTail;
+    const WriteBackEntry* entry = &writeBackQueue[tail % WRITE_BACK_QUEUE_DEPTH];
+    
+    if (!writeBackInFlight) {
+        if (tail == writeBackHead) {
+            return false;
+        }
+        __dmb();  // Read the entry only after seeing the head that published it
+        
+        writeBackRequestsPending = 0;
+        writeBackTrack(entry);
+        writeBackInFlight = true;
+    }
+    if (writeBackRequestsPending != 0) {
+        return true;  // Still on the async engine queue - poll() after this call advances it
+    }
+    writeBackInFlight = false;
+    
+    writeBackSavedPerTrack[entry->track]++;
+    writeBackCompletedCount++;
+    
+    __dmb();  // Entry is no longer read - producer may reuse it
+    writeBackTail = tail + 1;
+    return true;
+}
+
+// Queue the streamed track and save all snapshots (core1 only)
+// Used before diskImage is overwritten by a new image.
+void FloppyEmulator::flushWriteBackQueue() {
+    SDAsyncEngine* engine = sdCardManager ? sdCardManager->getAsyncEngine() : nullptr;
+    while (!saveGCRCacheToDiskImage()) {
+        processWriteBackQueue();  // Queue full - make room
+        if (engine) {
+            engine->poll();
+        }
+    }
+    while (processWriteBackQueue()) {
+        if (engine) {
+            engine->poll();  // Finish the async writes of the snapshot in flight
+        }
+    }
+}
+
+// Completion callback of the async engine - context is the FloppyEmulator
+static void writeBackRequestDone(const SDAsyncRequest* request, void* context) {
+    ((FloppyEmulator*)context)->handleWriteBackRequestDone(request);
+}
+
+// One async write of the snapshot in flight finished (engine poll() on core1)
+// A failed or cancelled write is repeated with the blocking API (allowed in the callback),
+// so the snapshot gets the same single retry chance as before
+void FloppyEmulator::handleWriteBackRequestDone(const SDAsyncRequest* request) {
+    if (request->status != SD_ASYNC_DONE && sdCardManager) {
+        writeBackRetryCount++;
+        if (!sdCardManager->writeBlocks(request->blockAddress, request->buffer, request->count)) {
+            printf("writeBackTrack: Write of %lu blocks at %lu failed\r\n",
+                   (unsigned long)request->count, (unsigned long)request->blockAddress);
+        }
+    }
+    if (writeBackRequestsPending > 0) {
+        writeBackRequestsPending--;
+    }
+}
+
+bool FloppyEmulator::isWriteBackPending(int track) {
+    return writeBackQueuedPerTrack[track] != writeBackSavedPerTrack[track];
+}
+
+void FloppyEmulator::getWriteBackStats(WriteBackStats* stats) {
+    stats->queued = writeBackQueuedCount;
+    stats->completed = writeBackCompletedCount;
+    stats->async = writeBackAsyncCount;
+    stats->retried = writeBackRetryCount;
+    stats->deferred = writeBackDeferredCount;
+    stats->pending = writeBackHead - writeBackTail;
+}
+
+// Save a write-back snapshot to the disk image and the SD card file (core1)
+// Only the sectors marked in entry->dirtySectors (set by writeBack()) are processed:
+// For DSK files: Decodes dirty sectors from the GCR snapshot and writes them to the disk image
+// For NIC files: Copies dirty sectors directly to diskImage buffer (already in GCR format)
+// Then only those sectors are written to the SD card file.
+void FloppyEmulator::writeBackTrack(const WriteBackEntry* entry) {
+    int track = entry->track;
+    uint16_t dirtySectors = entry->dirtySectors;
+    const uint8_t* gcrTrack = entry->gcr;
+    
+    printf("writeBackTrack: Saving track %d (sectors 0x%04X)...\r\n", track, dirtySectors);
+    
+    // For NIC files, the GCR sector is the file sector (no decoding needed)
     if (currentFileType == DISK_FILE_TYPE_NIC) {
         // NIC format: each track is 8192 bytes in file (16 sectors * 512 bytes)
         // But we only use first 416 bytes from each sector = 6656 bytes per track
-        uint32_t trackOffsetInFile = gcrTrackCacheTrack * APPLE_II_NIC_BYTES_PER_TRACK;  // Offset in NIC file (8192 bytes per track)
+        // Whole-disk mode: diskImage holds GCR tracks - build the file sectors in a scratch buffer
+        uint8_t* trackData = wholeDiskGCRActive ? g_flushTrackBuffer : &diskImage[track * APPLE_II_NIC_BYTES_PER_TRACK];
         
-        // Verify track offset is within bounds
-        if (trackOffsetInFile + APPLE_II_NIC_BYTES_PER_TRACK > APPLE_II_NIC_DISK_SIZE) {
-            printf("saveGCRCacheToDiskImage: Track %d offset out of bounds\r\n", gcrTrackCacheTrack);
-            gcrTrackCacheDirty = false;
-            return;
+        // The file sector holding a GCR sector's data field depends on the image's gap layout,
+        // so map each dirty data field (from the track layout) to the 416-byte file chunks it touches
+        uint16_t fileSectors = 0;
+        for (int sector = 0; sector < APPLE_II_SECTORS_PER_TRACK; sector++) {
+            int16_t dataOffset = entry->layout.dataOffset[sector];
+            if (!(dirtySectors & (1u << sector)) || dataOffset < 0) {
+                continue;
+            }
+            uint32_t lastByte = (dataOffset + GCR_DATA_FIELD_SIZE - 1) % APPLE_II_GCR_BYTES_PER_TRACK;
+            fileSectors |= 1u << (dataOffset / APPLE_II_GCR_BYTES_PER_SECTOR);
+            fileSectors |= 1u << (lastByte / APPLE_II_GCR_BYTES_PER_SECTOR);
         }
         
-        // Copy 416 bytes from GCR cache to each of the 16 sectors in diskImage buffer
         for (int sector = 0; sector < 16; sector++) {
-            uint32_t sectorOffsetInFile = trackOffsetInFile + (sector * 512);  // 512 bytes per sector in file
-            uint32_t sectorOffsetInCache = sector * 416;  // 416 bytes per sector in cache
-            
-            // Verify offsets are within bounds
-            if (sectorOffsetInFile + 512 > APPLE_II_NIC_DISK_SIZE) {
-                printf("saveGCRCacheToDiskImage: Sector %d offset out of bounds\r\n", sector);
-                continue;
-            }
-            if (sectorOffsetInCache + 416 > APPLE_II_GCR_BYTES_PER_TRACK) {
-                printf("saveGCRCacheToDiskImage: Sector %d cache offset out of bounds\r\n", sector);
+            if (!(fileSectors & (1u << sector))) {
                 continue;
             }
-            
-            // Copy 416 bytes from cache to file buffer (first 416 bytes of each 512-byte sector)
-            memcpy(diskImage + sectorOffsetInFile, gcrTrackCache + sectorOffsetInCache, 416);
+            // Copy 416 bytes from snapshot to file buffer (first 416 bytes of each 512-byte sector)
+            memcpy(&trackData[sector * 512], &gcrTrack[sector * APPLE_II_GCR_BYTES_PER_SECTOR], 416);
             // Zero out last 96 bytes of each 512-byte sector to ensure clean data
-            memset(diskImage + sectorOffsetInFile + 416, 0, 96);
+            memset(&trackData[sector * 512 + 416], 0, 96);
         }
         
-        //printf("saveGCRCacheToDiskImage: Saved NIC track %d to diskImage buffer (offset=%u)\r\n", 
-        //       gcrTrackCacheTrack, trackOffsetInFile);
-        
-        // Mark cache as clean
-        //uint32_t trackOffsetInFile = gcrTrackCacheTrack * APPLE_II_NIC_BYTES_PER_TRACK;
-        uint8_t* trackData = &diskImage[trackOffsetInFile];
-        uint32_t trackSize = APPLE_II_NIC_BYTES_PER_TRACK;  // 8192 bytes per track
-        
-        // Save track to file (silently fail if error occurs)
-        sdCardManager->saveTrackToFile(currentFileName, gcrTrackCacheTrack, trackData, trackSize);
-        gcrTrackCacheDirty = false;
+        // Save touched file sectors - a NIC file sector is a whole card block
+        writeBackSectors(track, trackData, APPLE_II_NIC_BYTES_PER_TRACK, fileSectors, 0);
         return;
     }
     
-    // For DSK files, decode GCR cache and save to diskImage buffer
-    // GCR cache sector structure (416 bytes per sector):
-    // - 22 sync bytes (0xFF)
-    // - 12 sync pattern bytes  
-    // - 3 bytes address prologue (D5 AA 96)
-    // - 8 bytes address data
-    // - 3 bytes address epilogue (DE AA EB)
-    // - 5 sync bytes (0xFF)
-    // - 3 bytes data prologue (D5 AA AD)  <- offset 53
-    // - 343 bytes NIC-encoded data        <- offset 56
+    // For DSK files, decode dirty sectors of the GCR snapshot
+    // Data field positions come from the track layout (scanned when the track was loaded):
+    // - 3 bytes data prologue (D5 AA AD)  <- layout.dataOffset[sector]
+    // - 343 bytes NIC-encoded data        <- layout.dataOffset[sector] + 3
     // - 3 bytes data epilogue (DE AA EB)
-    // - 14 sync bytes (0xFF)
     
-    const uint32_t SECTOR_SIZE = 416;
-    const uint32_t DATA_PROLOGUE_OFFSET = 53;  // 22 + 12 + 3 + 8 + 3 + 5 = 53
-    const uint32_t DATA_OFFSET = 56;           // DATA_PROLOGUE_OFFSET + 3
     const uint32_t DATA_FIELD_SIZE = 343;      // NIC-encoded data bytes
     
-    uint32_t trackOffset = gcrTrackCacheTrack * APPLE_II_BYTES_PER_TRACK;
-    int sectorsDecoded = 0;
-    int sectorsSkipped = 0;
+    // Whole-disk mode: decoded sectors go to a scratch track, only decoded sectors are written.
+    // Two DSK sectors share a 512-byte card block - the async engine writes whole blocks only, so
+    // in whole-disk mode the clean sectors are decoded too (per-track mode: diskImage has them)
+    uint8_t* trackData = wholeDiskGCRActive ? g_flushTrackBuffer : &diskImage[track * APPLE_II_BYTES_PER_TRACK];
+    uint16_t decodedSectors = 0;  // Bit per logical sector successfully decoded (dirty ones)
+    uint16_t validSectors = wholeDiskGCRActive ? 0 : 0xFFFF;  // Bit per logical sector current in trackData
     
     for (int physicalSector = 0; physicalSector < APPLE_II_SECTORS_PER_TRACK; physicalSector++) {
-        uint32_t sectorStart = physicalSector * SECTOR_SIZE;
-        uint32_t dataProloguePos = sectorStart + DATA_PROLOGUE_OFFSET;
-        uint32_t dataPos = sectorStart + DATA_OFFSET;
-        
-        // Verify data prologue (D5 AA AD)
-        if (dataProloguePos + 3 > APPLE_II_GCR_BYTES_PER_TRACK) {
-            printf("  Sector %d: prologue position overflow\r\n", physicalSector);
-            sectorsSkipped++;
+        bool dirty = (dirtySectors & (1u << physicalSector)) != 0;
+        if (!dirty && !wholeDiskGCRActive) {
             continue;
         }
         
-        if (gcrTrackCache[dataProloguePos] != 0xD5 ||
-            gcrTrackCache[dataProloguePos + 1] != 0xAA ||
-            gcrTrackCache[dataProloguePos + 2] != 0xAD) {
-            // Data field prologue not found at expected position - skip this sector
-            // This is normal for sectors that weren't written to
-            sectorsSkipped++;
-            continue;
+        int16_t dataOffset = entry->layout.dataOffset[physicalSector];
+        uint8_t dataField[3 + DATA_FIELD_SIZE];
+        if (dataOffset >= 0) {
+            copyFromGCRTrack(gcrTrack, dataOffset, dataField, sizeof(dataField));
         }
         
-        // Verify we have enough data
-        if (dataPos + DATA_FIELD_SIZE > APPLE_II_GCR_BYTES_PER_TRACK) {
-            printf("  Sector %d: data overflow\r\n", physicalSector);
-            sectorsSkipped++;
+        // Verify data prologue (D5 AA AD)
+        if (dataOffset < 0 || dataField[0] != 0xD5 || dataField[1] != 0xAA || dataField[2] != 0xAD) {
+            // Data field prologue not found - skip this sector
+            if (dirty) {
+                printf("  Sector %d: data prologue not found\r\n", physicalSector);
+            }
             continue;
         }
         
+        // Get logical sector from physical sector using SECTOR_SCRAMBLE
+        // Physical sector N in GCR cache contains data for logical sector SECTOR_SCRAMBLE[N]
+        int logicalSector = SECTOR_SCRAMBLE[physicalSector];
+        
         // Decode NIC data field
         uint8_t decodedData[256];
         uint16_t decodedLength = 0;
         
-        decodeNICDataField(&gcrTrackCache[dataPos], DATA_FIELD_SIZE, decodedData, &decodedLength);
+        decodeNICDataField(&dataField[3], DATA_FIELD_SIZE, decodedData, &decodedLength);
         
         if (decodedLength != 256) {
-            printf("  Sector %d: decode failed (got %u bytes, expected 256)\r\n", physicalSector, decodedLength);
-            sectorsSkipped++;
+            if (dirty) {
+                printf("  Sector %d: decode failed (got %u bytes, expected 256)\r\n", physicalSector, decodedLength);
+            }
             continue;
         }
         
-        // Get logical sector from physical sector using SECTOR_SCRAMBLE
-        // Physical sector N in GCR cache contains data for logical sector SECTOR_SCRAMBLE[N]
-        int logicalSector = SECTOR_SCRAMBLE[physicalSector];
-        
-        // Calculate position in disk image
-        uint32_t sectorOffset = trackOffset + (logicalSector * APPLE_II_BYTES_PER_SECTOR);
-        
-        // Copy decoded data to disk image
-        for (int i = 0; i < 256; i++) {
-            diskImage[sectorOffset + i] = decodedData[i];
+        // Copy decoded data to disk image (or scratch track)
+        memcpy(&trackData[logicalSector * APPLE_II_BYTES_PER_SECTOR], decodedData, 256);
+        validSectors |= (1u << logicalSector);
+        if (dirty) {
+            decodedSectors |= (1u << logicalSector);
         }
-        
-        sectorsDecoded++;
     }
     
-    // Save track to SD card file if SD card manager and filename are available
-    if (sdCardManager && currentFileName[0] != 0 && sectorsDecoded > 0) {
-        // Get track data from diskImage (already decoded and written above)
-        uint8_t* trackData = &diskImage[trackOffset];
-        uint32_t trackSize = APPLE_II_BYTES_PER_TRACK;  // 4096 bytes per track
-        
-        // Save track to file (silently fail if error occurs)
-        sdCardManager->saveTrackToFile(currentFileName, gcrTrackCacheTrack, trackData, trackSize);
+    // Blocks with a written sector: whole block to the async engine if both sectors are current,
+    // otherwise the written sector alone (read-modify-write of the blocking path)
+    uint16_t asyncSectors = 0;
+    uint16_t blockingSectors = 0;
+    for (int block = 0; block < APPLE_II_SECTORS_PER_TRACK / 2; block++) {
+        uint16_t blockSectors = 3u << (block * 2);
+        if (!(decodedSectors & blockSectors)) {
+            continue;
+        }
+        if ((validSectors & blockSectors) == blockSectors) {
+            asyncSectors |= blockSectors;
+        } else {
+            blockingSectors |= decodedSectors & blockSectors;
+        }
     }
-    
-    // Mark cache as clean
-    gcrTrackCacheDirty = false;
+    writeBackSectors(track, trackData, APPLE_II_BYTES_PER_TRACK, asyncSectors, blockingSectors);
 }
 
-// DMA IRQ handler for fast restart when transfer completes
-// Fast handler that resets read address and restarts transfer
-void dma_irq_handler() {
-    if (g_floppyEmulatorInstance) {
-        g_floppyEmulatorInstance->handleDMAIRQ();
+// Save sectors of a decoded track to the SD card file (core1, from writeBackTrack())
+// asyncSectors are queued on the async engine (whole card blocks) - writeBackRequestsPending counts
+// the requests and processWriteBackQueue() keeps the snapshot in flight until they are done.
+// blockingSectors, and asyncSectors the engine cannot take, are written here (silently fail on error)
+void FloppyEmulator::writeBackSectors(int track, const uint8_t* trackData, uint32_t trackSize,
+                                      uint16_t asyncSectors, uint16_t blockingSectors) {
+    if (!sdCardManager || !currentFile.open) {
+        return;
+    }
+    
+    if (blockingSectors != 0) {
+        sdCardManager->saveTrackSectorsToFile(&currentFile, track, trackData, trackSize, blockingSectors);
+    }
+    
+    if (asyncSectors != 0) {
+        uint32_t requests = 0;
+        bool queued = sdCardManager->submitTrackSectors(&currentFile, track, trackData, trackSize, asyncSectors,
+                                                        writeBackRequestDone, this, &requests);
+        writeBackRequestsPending += requests;
+        if (requests > 0) {
+            writeBackAsyncCount++;
+        } else if (!queued) {
+            sdCardManager->saveTrackSectorsToFile(&currentFile, track, trackData, trackSize, asyncSectors);
+        }
     }
 }
 
@@ -1304,44 +2060,26 @@ void FloppyEmulator::initPIO_DMA() {
     // Load PIO program
     pioOffset = pio_add_program(pio, &floppy_bit_output_program);
     
-    // Initialize PIO state machine (but DON'T start it yet - wait for DMA)
-    pio_sm_config c = floppy_bit_output_program_get_default_config(pioOffset);
-    sm_config_set_out_pins(&c, readPin, 1);
-    sm_config_set_set_pins(&c, readPin, 1);
-    sm_config_set_out_shift(&c, false, true, 8);  // Shift right, autopull after 8 bits
-    
-    pio_gpio_init(pio, readPin);
-    pio_sm_set_consecutive_pindirs(pio, pioSm, readPin, 1, true);
-    
-    // Clock divider: system clock / 2MHz = 200MHz / 2MHz = 100
-    // At 2MHz: 1 instruction = 0.5μs
-    // PIO program timing per bit:
-    //   - out pins, 1 = 0.5μs (sets bit value)
-    //   - nop = 0.5μs (HIGH total = 1μs for bit "1")
-    //   - set pins, 0 = 0.5μs (sets LOW)
-    //   - nop [4] = 5 cycles = 2.5μs (LOW total = 3μs)
-    //   - Total = 4μs per bit ✓
-    float div = (float)clock_get_hz(clk_sys) / 2200000.0f;  // 2MHz clock
-    sm_config_set_clkdiv(&c, div);
-    
-    pio_sm_init(pio, pioSm, pioOffset, &c);
-    // DON'T start PIO SM yet - it will be started when DMA is ready
-    pio_sm_set_enabled(pio, pioSm, false);
-    
-    // Claim DMA channel
+    // Clock divider: system clock / 2MHz at 300 RPM (see applyReadClockDivider())
+    // PIO program timing per bit (8 cycles = 4μs):
+    //   - out pins, 1 = 1 cycle (sets bit value, autopull every 32 bits)
+    //   - jmp x-- = 1 cycle (HIGH total = 2 cycles = 1μs for bit "1")
+    //   - set pins, 0 = 1 cycle (sets LOW)
+    //   - mov, mov, nop [2] = 5 cycles (LOW total = 6 cycles = 3μs)
+    applyReadClockDivider();
+    
+    // Initialize PIO state machine (but DON'T start it yet - it will be started when DMA is ready)
+    floppy_bit_output_program_init(pio, pioSm, pioOffset, readPin, readClockDiv);
+    resetReadPIO();
+    
+    // Claim DMA channels: the data channel feeds the PIO, the control channel restarts it
     dmaChannel = dma_claim_unused_channel(true);
-    if (dmaChannel < 0) {
+    dmaControlChannel = dma_claim_unused_channel(true);
+    if (dmaChannel < 0 || dmaControlChannel < 0) {
         // No available DMA channel - this should not happen
         return;
     }
     
-    // Set up DMA IRQ handler for automatic restart
-    // Use IRQ0 for channels 0-3, IRQ1 for channels 4-11
-    // For now, assume channel < 4 (most likely)
-    if (g_floppyEmulatorInstance == nullptr) {
-        g_floppyEmulatorInstance = this;  // Set instance for IRQ handler
-    }
-    
     // PIO/DMA will be started in init() after cache is ready
     pioDmaActive = false;
 }
@@ -1352,53 +2090,50 @@ void FloppyEmulator::startPIO_DMA() {
         return;  // Already active
     }
     
-    if (dmaChannel < 0 || pio == nullptr) {
+    if (dmaChannel < 0 || dmaControlChannel < 0 || pio == nullptr) {
         return;  // PIO/DMA not initialized
     }
     
-    // Configure DMA channel for circular transfer from cache to PIO TX FIFO
-    // Use self-chaining for automatic restart without IRQ - seamless continuous transfer
+    // Endless stream without CPU involvement - two chained channels:
+    // - data channel: one revolution of track bytes into the PIO TX FIFO, then triggers the control channel
+    // - control channel: copies readStreamBase into the data channel's READ_ADDR trigger register, which
+    //   restarts it at the track start with the full transfer count (writing TRANS_COUNT only sets the
+    //   value reloaded on every trigger). The seam costs a few bus cycles - the TX FIFO never runs dry.
     dmaConfig = dma_channel_get_default_config(dmaChannel);
-    channel_config_set_transfer_data_size(&dmaConfig, DMA_SIZE_8);  // Transfer bytes
+    // 32-bit words: a quarter of the bus transactions and FIFO refills of byte transfers. The DMA
+    // byte swap puts the first track byte in the MSB (shifted out first), so the cache keeps its
+    // byte order for the track maps, write decoding and sector saves.
+    channel_config_set_transfer_data_size(&dmaConfig, DMA_SIZE_32);  // Transfer words (4 GCR bytes)
+    channel_config_set_bswap(&dmaConfig, true);
     channel_config_set_dreq(&dmaConfig, pio_get_dreq(pio, pioSm, true));  // DREQ from PIO TX FIFO
     channel_config_set_read_increment(&dmaConfig, true);   // Increment read address (cache buffer)
     channel_config_set_write_increment(&dmaConfig, false); // Don't increment write address (PIO FIFO)
+    channel_config_set_chain_to(&dmaConfig, dmaControlChannel);
     
-    // KEY: Self-chaining - channel restarts itself automatically when transfer completes
-    // IMPORTANT: When self-chaining, we need to also reset the read address
-    // The chain will restart the transfer count, but we need to reset read address manually
-    // OR use a second channel to reset it. For now, let's use IRQ but make it faster.
-    // Actually, let's try: configure chain, but also set up to reset read address via chain trigger
-    // Better: Use ring buffer mode if possible, or go back to IRQ with fast restart
+    dma_channel_config controlConfig = dma_channel_get_default_config(dmaControlChannel);
+    channel_config_set_transfer_data_size(&controlConfig, DMA_SIZE_32);
+    channel_config_set_read_increment(&controlConfig, false);
+    channel_config_set_write_increment(&controlConfig, false);
     
-    // For now, let's use a simpler approach: IRQ handler that just resets read address
-    // and restarts - this is still fast and reliable
-    // channel_config_set_chain_to(&dmaConfig, dmaChannel);  // Commented out - needs read address reset
+    dma_channel_configure(
+        dmaControlChannel,
+        &controlConfig,
+        &dma_hw->ch[dmaChannel].al3_read_addr_trig,  // Data channel read address + trigger
+        &readStreamBase,                              // Track start (updated on track swaps)
+        1,                                            // One word per revolution
+        false                                         // Started by the data channel chain
+    );
     
-    // Set up circular transfer: transfer count = cache size
+    readStreamBase = (uint32_t)gcrTrackCache;
     dma_channel_configure(
         dmaChannel,
         &dmaConfig,
         &pio->txf[pioSm],              // Write to PIO TX FIFO
         gcrTrackCache,                  // Read from cache buffer
-        APPLE_II_GCR_BYTES_PER_TRACK,  // Transfer count
+        GCR_STREAM_WORDS_PER_TRACK,    // Transfer count (one revolution)
         false                           // Don't start yet - configure first
     );
     
-    // Enable DMA IRQ for automatic restart when transfer completes
-    // We'll use a fast IRQ handler that just resets read address and restarts
-    if (dmaChannel < 4) {
-        // Channels 0-3 use IRQ0
-        irq_set_exclusive_handler(DMA_IRQ_0, dma_irq_handler);
-        irq_set_enabled(DMA_IRQ_0, true);
-        dma_channel_set_irq0_enabled(dmaChannel, true);
-    } else {
-        // Channels 4-11 use IRQ1
-        irq_set_exclusive_handler(DMA_IRQ_1, dma_irq_handler);
-        irq_set_enabled(DMA_IRQ_1, true);
-        dma_channel_set_irq1_enabled(dmaChannel, true);
-    }
-    
     // Start PIO state machine first (it will wait for data from DMA via pull)
     pio_sm_set_enabled(pio, pioSm, true);
     
@@ -1414,17 +2149,7 @@ void FloppyEmulator::stopPIO_DMA() {
         return;  // Already stopped
     }
     
-    if (dmaChannel >= 0) {
-        // Disable DMA IRQ before aborting
-        if (dmaChannel < 4) {
-            dma_channel_set_irq0_enabled(dmaChannel, false);
-        } else {
-            dma_channel_set_irq1_enabled(dmaChannel, false);
-        }
-        
-        // Abort DMA transfer
-        dma_channel_abort(dmaChannel);
-    }
+    haltReadStream();
     
     if (pio != nullptr) {
         // Disable PIO state machine
@@ -1437,28 +2162,154 @@ void FloppyEmulator::stopPIO_DMA() {
     pioDmaActive = false;
 }
 
-// Handle DMA IRQ - fast restart by resetting read address and restarting transfer
-void FloppyEmulator::handleDMAIRQ() {
-    // This is called from IRQ handler, so keep it fast!
-    // CRITICAL: Don't process DMA IRQ during write operation - it can interfere with write timing
-    if (writeIrqTimerActive) {
-        return;  // Write in progress - skip DMA restart to avoid interference
+// Stop the read DMA loop
+// The data channel is chained to itself first (= no chain), so neither the end of a revolution
+// nor a reload already in flight can start it again behind the aborts.
+void FloppyEmulator::haltReadStream() {
+    if (dmaChannel < 0 || dmaControlChannel < 0) {
+        return;
+    }
+    dma_channel_config noChain = dmaConfig;
+    channel_config_set_chain_to(&noChain, dmaChannel);
+    dma_channel_set_config(dmaChannel, &noChain, false);
+    dma_channel_abort(dmaControlChannel);
+    dma_channel_abort(dmaChannel);
+}
+
+// Read PIO clock divider for readRpm: clk_sys / (FLOPPY_READ_CYCLES_PER_BIT cycles per cell * cells per
+// second), 16.8 fixed point, rounded. 200MHz at 300 RPM gives exactly 100 (2MHz, 4.000μs cell); other
+// clocks get the nearest 1/256 step (the PIO spreads the fraction evenly, the average cell is exact).
+void FloppyEmulator::applyReadClockDivider() {
+    uint64_t num = (uint64_t)clock_get_hz(clk_sys) * 256 * APPLE_II_BIT_PERIOD_US * APPLE_II_NOMINAL_RPM;
+    uint64_t den = (uint64_t)FLOPPY_READ_CYCLES_PER_BIT * 1000000 * readRpm;
+    readClockDiv = (uint32_t)((num + den / 2) / den);
+    if (readClockDiv < 256) {
+        readClockDiv = 256;  // Divider 1.0 minimum
     }
     
-    if (!pioDmaActive || dmaChannel < 0) {
-        return;  // Not active
+    if (pio != nullptr && pioDmaActive) {
+        pio_sm_set_clkdiv_int_frac8(pio, pioSm, readClockDiv >> 8, readClockDiv & 0xFF);
+    }
+}
+
+// Set the drive speed of the read stream (takes effect immediately)
+bool FloppyEmulator::setReadRPM(uint32_t rpm) {
+    if (rpm < FLOPPY_RPM_MIN || rpm > FLOPPY_RPM_MAX) {
+        return false;
+    }
+    readRpm = rpm;
+    applyReadClockDivider();
+    return true;
+}
+
+// Bit cell the current divider gives: divider * cycles per cell / clk_sys
+uint32_t FloppyEmulator::getReadCellPs() const {
+    return (uint32_t)((uint64_t)readClockDiv * FLOPPY_READ_CYCLES_PER_BIT * 1000000000ull / 256 * 1000 /
+                      clock_get_hz(clk_sys));
+}
+
+// Measure the bit cell on the READ pin
+// Runs floppy_bit_input (already loaded for write capture) on a spare pio1 SM with the READ pin as
+// JMP pin and sums the edge intervals it pushes. The program's loop is exact to the cycle: an interval
+// of n ticks took 2n + 4 cycles (ending at a rising edge) or 2n + 5 cycles (ending at a falling edge),
+// so the span between two detected falling edges is exact - and falling edges are a whole number of
+// bit cells apart. Only the ends carry the 2-cycle sampling error, spread over thousands of cells.
+bool FloppyEmulator::measureReadBitCell(ReadCellMeasurement* result) {
+    if (!result || !pioDmaActive || !writeCaptureReady) {
+        return false;  // No stream to measure, or floppy_bit_input not loaded
     }
+    memset(result, 0, sizeof(ReadCellMeasurement));
+    result->expectedPs = getReadCellPs();
     
-    // Clear IRQ flag FIRST to avoid multiple triggers
-    if (dmaChannel < 4) {
-        dma_hw->ints0 = 1u << dmaChannel;
-    } else {
-        dma_hw->ints1 = 1u << dmaChannel;
+    int sm = pio_claim_unused_sm(writeCapturePio, false);
+    if (sm < 0) {
+        return false;
+    }
+    floppy_bit_input_program_init(writeCapturePio, (uint)sm, writeCaptureOffset, readPin);
+    writeCapturePio->fdebug = 1u << (PIO_FDEBUG_RXSTALL_LSB + sm);
+    
+    // HIGH intervals are a quarter cell, LOW intervals at least three quarters
+    uint32_t sysHz = clock_get_hz(clk_sys);
+    uint32_t halfCellTicks = (uint32_t)((uint64_t)result->expectedPs * (sysHz / 2) / 1000000000000ull / 2);
+    
+    uint64_t spanCycles = 0;     // First to last timed falling edge
+    uint64_t pendingCycles = 0;  // Since the last falling edge
+    uint64_t pulseCycles = 0;
+    uint32_t pulses = 0;
+    bool started = false;
+    
+    pio_sm_set_enabled(writeCapturePio, (uint)sm, true);
+    uint32_t start = time_us_32();
+    while (result->edges < FLOPPY_CELL_MEASURE_EDGES &&
+           time_us_32() - start < FLOPPY_CELL_MEASURE_TIMEOUT_US) {
+        if (pio_sm_is_rx_fifo_empty(writeCapturePio, (uint)sm)) {
+            continue;
+        }
+        uint32_t ticks = pio_sm_get(writeCapturePio, (uint)sm);
+        bool high = ticks < halfCellTicks;
+        if (!started) {
+            started = high;  // Interval in progress when the SM started is partial - begin at a falling edge
+            continue;
+        }
+        uint32_t cycles = 2 * ticks + (high ? 5 : 4);
+        pendingCycles += cycles;
+        result->edges++;
+        if (high) {
+            pulseCycles += cycles;
+            pulses++;
+            spanCycles += pendingCycles;
+            pendingCycles = 0;
+        }
     }
+    pio_sm_set_enabled(writeCapturePio, (uint)sm, false);
+    result->overrun = (writeCapturePio->fdebug & (1u << (PIO_FDEBUG_RXSTALL_LSB + sm))) != 0;
+    pio_sm_unclaim(writeCapturePio, (uint)sm);
     
-    // Fast restart: Just reset read address and restart transfer
-    // This is faster than full dma_channel_configure - single register write
-    dma_channel_set_read_addr(dmaChannel, gcrTrackCache, true);
+    if (pulses < 2 || spanCycles == 0 || readClockDiv == 0) {
+        return false;  // Track without "1" bits (or no pulses at all)
+    }
+    
+    // Whole cells in the span (nominal cell = divider * cycles per cell / 256 system cycles)
+    uint64_t cellCycles256 = (uint64_t)readClockDiv * FLOPPY_READ_CYCLES_PER_BIT;
+    result->cells = (uint32_t)((spanCycles * 256 + cellCycles256 / 2) / cellCycles256);
+    if (result->cells == 0) {
+        return false;
+    }
+    result->cellPs = (uint32_t)(spanCycles * 1000000000ull / result->cells * 1000 / sysHz);
+    result->pulsePs = (uint32_t)(pulseCycles * 1000000000ull / pulses * 1000 / sysHz);
+    return true;
+}
+
+// Empty the read PIO and restart its bit counter (state machine stopped, DMA halted)
+// Afterwards the first bit out is bit 0 of the first word the DMA delivers - what
+// getHeadBitPosition() relies on.
+void FloppyEmulator::resetReadPIO() {
+    if (pio == nullptr) {
+        return;
+    }
+    pio_sm_clear_fifos(pio, pioSm);
+    pio_sm_restart(pio, pioSm);  // OSR empty - next OUT autopulls
+    pio_sm_exec(pio, pioSm, pio_encode_jmp(pioOffset));
+    pio_sm_exec(pio, pioSm, pio_encode_mov_not(pio_x, pio_null));  // Bit counter: ~X = 0 bits
+}
+
+// Restart the read DMA loop at offset of track buffer base (after haltReadStream(), interrupts disabled)
+// The trigger loads the shortened count, the reload value goes straight back to a full revolution
+// for the control channel. A revolution ending within the FIFO depth starts over at the track start
+// instead - the data channel could finish before the reload value is restored.
+void FloppyEmulator::resumeReadStream(const uint8_t* base, uint32_t offset) {
+    if (dmaChannel < 0 || dmaControlChannel < 0) {
+        return;
+    }
+    offset &= ~3u;  // Word transfers
+    if (offset + GCR_SWAP_QUEUED_BYTES >= APPLE_II_GCR_BYTES_PER_TRACK) {
+        offset = 0;
+    }
+    readStreamBase = (uint32_t)base;
+    dma_channel_set_config(dmaChannel, &dmaConfig, false);  // Chain to the control channel again
+    dma_channel_set_trans_count(dmaChannel, (APPLE_II_GCR_BYTES_PER_TRACK - offset) / 4, false);
+    dma_channel_set_read_addr(dmaChannel, base + offset, true);
+    dma_channel_set_trans_count(dmaChannel, GCR_STREAM_WORDS_PER_TRACK, false);
 }
 
 // Main processing loop - react to controller signals
@@ -1477,6 +2328,11 @@ void FloppyEmulator::process() {
         return;
     }
     
+    // New disk image is being read/converted on core1 - don't touch diskImage or the cache
+    if (diskImageLoading) {
+        return;
+    }
+    
     // CRITICAL: Monitor stepper motor phase changes FIRST - HIGHEST PRIORITY
     // This MUST run even when drive is not selected - we need to track position always
     // This is the highest priority - must catch all phase changes
@@ -1486,7 +2342,17 @@ void FloppyEmulator::process() {
     // PIO/DMA should run continuously - don't stop it based on drive selection
     // In real Apple II floppy drive, READ pin constantly outputs data when drive is spinning
     // Update cache if track changed (don't abort DMA - let it finish current cycle first)
-    if (gcrTrackCacheTrack != currentTrack) {
+    int wantedTrack = currentTrack;
+    if (wantedTrack == gcrTrackCacheTrack) {
+        // Head came back to the streamed track before the swap - drop the pending buffer
+        if (pendingGCRTrackCache != nullptr) {
+            uint32_t save = save_and_disable_interrupts();
+            pendingGCRTrackCache = nullptr;
+            pendingGCRTrackCacheTrack = -1;
+            pendingGCRTrackMap = nullptr;
+            restore_interrupts(save);
+        }
+    } else if (pendingGCRTrackCache == nullptr || pendingGCRTrackCacheTrack != wantedTrack) {
 /*
         int diff = absolute_time_diff_us(lastTimeChangeTrackCheck, get_absolute_time());
         //printf("Diff: %d\r\n", diff);
@@ -1496,16 +2362,17 @@ void FloppyEmulator::process() {
             updateGCRTrackCache();
         }        
 */        
-        // Don't abort DMA here - it will restart with new cache when current cycle completes
+        // Don't abort DMA here - new track goes to the back buffer and is swapped in at a sync gap
         // This avoids interruptions in the continuous stream
-        //gpio_put(14, 1);
-        //sdCardManager->readTrackFromFile(currentFileName, currentTrack, gcrTrackCache_tmp, APPLE_II_GCR_BYTES_PER_TRACK);
-        //gpio_put(14, 0);
         updateGCRTrackCache();
     }
+    
+    // Swap in the back buffer as soon as the stream reaches a sync gap
+    if (pendingGCRTrackCache != nullptr) {
+        swapPendingGCRTrackCache();
+    }
    
-    // DMA restart is now handled by IRQ handler for faster response
-    // No need to poll here - IRQ handler will restart DMA immediately when it completes
+    // The read DMA restarts itself at the end of every revolution (control channel) - nothing to poll
     
     // Update rotation position
     updateRotationPosition();
@@ -1595,6 +2462,134 @@ bool FloppyEmulator::checkPWMOverflow() {
     return false;
 }
 //-----------------------------------------------
+// Initialize PIO/DMA write capture
+// Runs floppy_bit_input on pio1 (pio0 holds the READ stream program). PIO measures
+// the time between flux transitions (10ns ticks), DMA copies every interval from
+// the RX FIFO into g_writeCaptureRing and writePLL turns intervals into bit cells.
+void FloppyEmulator::initWriteCapture() {
+    writeCaptureReady = false;
+    
+    writeCapturePio = pio1;
+    int sm = pio_claim_unused_sm(writeCapturePio, false);
+    if (sm < 0) {
+        printf("WARNING: No free PIO state machine for write capture - using polling loop\r\n");
+        return;
+    }
+    writeCaptureSm = (uint)sm;
+    
+    if (!pio_can_add_program(writeCapturePio, &floppy_bit_input_program)) {
+        printf("WARNING: No PIO instruction memory for write capture - using polling loop\r\n");
+        pio_sm_unclaim(writeCapturePio, writeCaptureSm);
+        return;
+    }
+    writeCaptureOffset = pio_add_program(writeCapturePio, &floppy_bit_input_program);
+    floppy_bit_input_program_init(writeCapturePio, writeCaptureSm, writeCaptureOffset, writePin);
+    
+    writeCaptureDmaChannel = dma_claim_unused_channel(false);
+    if (writeCaptureDmaChannel < 0) {
+        printf("WARNING: No free DMA channel for write capture - using polling loop\r\n");
+        pio_remove_program(writeCapturePio, &floppy_bit_input_program, writeCaptureOffset);
+        pio_sm_unclaim(writeCapturePio, writeCaptureSm);
+        return;
+    }
+    
+    // PIO counter runs at clk_sys / 2 - nominal 4μs cell = 400 ticks at 200MHz
+    uint32_t ticksPerUs = clock_get_hz(clk_sys) / 2 / 1000000;
+    writePLL.configure(ticksPerUs * APPLE_II_BIT_PERIOD_US);
+    
+    writeCaptureReady = true;
+    printf("Write capture: PIO1 SM%u, DMA channel %d, ring %u intervals, cell %u ticks\r\n",
+           writeCaptureSm, writeCaptureDmaChannel, WRITE_CAPTURE_RING_ENTRIES, writePLL.getNominalCellTicks());
+}
+//-----------------------------------------------
+// Start capturing (called from startWritingProcedure() when WRITE_EN goes active)
+void FloppyEmulator::startWriteCapture() {
+    // Restart program from the top so it picks up the current WRITE level
+    pio_sm_set_enabled(writeCapturePio, writeCaptureSm, false);
+    pio_sm_clear_fifos(writeCapturePio, writeCaptureSm);
+    pio_sm_restart(writeCapturePio, writeCaptureSm);
+    pio_sm_exec(writeCapturePio, writeCaptureSm, pio_encode_jmp(writeCaptureOffset));
+    
+    // RX FIFO -> ring buffer, write address wraps every WRITE_CAPTURE_RING_SIZE bytes
+    dma_channel_config c = dma_channel_get_default_config(writeCaptureDmaChannel);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, true);
+    channel_config_set_ring(&c, true, WRITE_CAPTURE_RING_BITS);
+    channel_config_set_dreq(&c, pio_get_dreq(writeCapturePio, writeCaptureSm, false));
+    dma_channel_configure(
+        writeCaptureDmaChannel,
+        &c,
+        g_writeCaptureRing,                      // Write to ring buffer
+        &writeCapturePio->rxf[writeCaptureSm],   // Read from PIO RX FIFO
+        WRITE_CAPTURE_DMA_COUNT,                 // Effectively endless for one write
+        true                                     // Start now - waits for DREQ
+    );
+    
+    writeCaptureReadIndex = 0;
+    writePLL.reset();  // Start every write at nominal cell period
+    writeCaptureActive = true;
+    pio_sm_set_enabled(writeCapturePio, writeCaptureSm, true);
+}
+//-----------------------------------------------
+// Stop capturing (called from stopWritingProcedure() when WRITE_EN goes inactive)
+// "0" cells after the last transition are not emitted - they are past the data field epilogue
+void FloppyEmulator::stopWriteCapture() {
+    pio_sm_set_enabled(writeCapturePio, writeCaptureSm, false);
+    
+    // Let DMA move the intervals still in RX FIFO, then decode everything that arrived
+    while (!pio_sm_is_rx_fifo_empty(writeCapturePio, writeCaptureSm) &&
+           dma_channel_is_busy(writeCaptureDmaChannel)) {
+        tight_loop_contents();
+    }
+    processWriteCapture();
+    
+    dma_channel_abort(writeCaptureDmaChannel);
+    pio_sm_clear_fifos(writeCapturePio, writeCaptureSm);
+    writeCaptureActive = false;
+}
+//-----------------------------------------------
+bool FloppyEmulator::isWriteCaptureReady() const {
+    return writeCaptureReady;
+}
+//-----------------------------------------------
+FluxPLL* FloppyEmulator::getWritePLL() {
+    return &writePLL;
+}
+//-----------------------------------------------
+// Decode edge intervals captured by PIO/DMA so far
+// writePLL converts each interval to N "0" cells + one "1" cell; bits are fed to the
+// same writePinChange()/writeIdle() decoder the polling loop used.
+void FloppyEmulator::processWriteCapture() {
+    if (!writeCaptureActive) {
+        return;
+    }
+    
+    // Intervals written by DMA = start count - remaining count (low 28 bits, top bits are RP2350 mode)
+    uint32_t remaining = dma_channel_hw_addr(writeCaptureDmaChannel)->transfer_count & 0x0FFFFFFFu;
+    uint32_t produced = WRITE_CAPTURE_DMA_COUNT - remaining;
+    
+    // Decoder fell a whole ring behind - oldest intervals were overwritten, skip to the oldest valid one
+    if (produced - writeCaptureReadIndex > WRITE_CAPTURE_RING_ENTRIES) {
+        writeCaptureOverruns++;
+        writeCaptureReadIndex = produced - WRITE_CAPTURE_RING_ENTRIES;
+    }
+    
+    while (writeCaptureReadIndex != produced) {
+        uint32_t ticks = g_writeCaptureRing[writeCaptureReadIndex & (WRITE_CAPTURE_RING_ENTRIES - 1)];
+        writeCaptureReadIndex++;
+        
+        uint16_t zeros = writePLL.feedInterval(ticks + FLUX_CAPTURE_EDGE_OVERHEAD_TICKS);
+        if (zeros == 0xFFFF) {
+            continue;  // Glitch - folded into next interval
+        }
+        for (uint16_t i = 0; i < zeros; i++) {
+            writeIdle();       // No transition - bit "0"
+        }
+        writePinChange();      // Flux transition - bit "1"
+    }
+}
+//-----------------------------------------------
 //-----------------------------------------------
 bool FloppyEmulator::floppy_write_in() {
     return gpio_get(writePin) ? 1 : 0;
@@ -1636,52 +2631,28 @@ void FloppyEmulator::startWritingProcedure() {
             //}
             
             // Save DMA position at write start - this is when the controller has just read the address field
-            // and is about to write the data field. We search backwards from this position to find the sector.
+            // and is about to write the data field. The sector is looked up in the track position index.
             currentSectortoWrite = -1;  // Logical sector (unknown until we find address field)
             physicalSectorToWrite = -1; // Physical sector (for GCR cache position)
             dmaPositionAtWriteStart = 0;
             
             if (dmaChannel >= 0 && pioDmaActive) {
-                uint32_t dmaReadAddr = dma_channel_hw_addr(dmaChannel)->read_addr;
-                uint32_t cacheOffset = dmaReadAddr - (uint32_t)gcrTrackCache;
-                cacheOffset = cacheOffset % APPLE_II_GCR_BYTES_PER_TRACK;  // Wrap around
+                // Byte under the head (not the DMA read position - that runs a FIFO ahead)
+                uint32_t cacheOffset = getHeadBitPosition() / 8;
                 dmaPositionAtWriteStart = cacheOffset;
                 
-                // Search backwards for address field prologue (D5 AA 96) - controller just read it
-                // The controller reads address field, then enables write for data field
-                // So we should find D5 AA 96 within a few hundred bytes backwards
-                for (int searchBack = 0; searchBack < 450; searchBack++) {
-                    int pos = (int)cacheOffset - searchBack;
-                    if (pos < 0) pos += APPLE_II_GCR_BYTES_PER_TRACK;
+                // Sector owning this position - the controller just read its address field and
+                // enables write for the data field (index built when the track was swapped in)
+                uint8_t entry = gcrTrackMap->index[cacheOffset];
+                if (entry != GCR_INDEX_UNKNOWN) {
+                    uint8_t physicalSector = entry & GCR_INDEX_SECTOR_MASK;
                     
-                    // Check for D5 AA 96 (address field prologue)
-                    int pos1 = (pos + 1) % APPLE_II_GCR_BYTES_PER_TRACK;
-                    int pos2 = (pos + 2) % APPLE_II_GCR_BYTES_PER_TRACK;
+                    // Save physical sector (for GCR cache position)
+                    physicalSectorToWrite = physicalSector;
                     
-                    if (gcrTrackCache[pos] == 0xD5 && 
-                        gcrTrackCache[pos1] == 0xAA &&
-                        gcrTrackCache[pos2] == 0x96) {
-                        
-                        // Found address field! Decode sector from positions +7 and +8
-                        int sectorPos1 = (pos + 7) % APPLE_II_GCR_BYTES_PER_TRACK;
-                        int sectorPos2 = (pos + 8) % APPLE_II_GCR_BYTES_PER_TRACK;
-                        uint8_t sectorEncoded1 = gcrTrackCache[sectorPos1];
-                        uint8_t sectorEncoded2 = gcrTrackCache[sectorPos2];
-                        uint8_t physicalSector = ((sectorEncoded1 & 0x55) << 1) | (sectorEncoded2 & 0x55);
-                        
-                        // Save physical sector (for GCR cache position)
-                        physicalSectorToWrite = physicalSector;
-                        
-                        // Convert physical sector to logical sector using SECTOR_SCRAMBLE
-                        // In GCR cache: physical sector N contains data from logical sector SECTOR_SCRAMBLE[N]
-                        // So when we find physical sector N, the logical sector is SECTOR_SCRAMBLE[N]
-                        if (physicalSector < 16) {
-                            currentSectortoWrite = SECTOR_SCRAMBLE[physicalSector];
-                        } else {
-                            currentSectortoWrite = physicalSector;  // Invalid, keep as-is
-                        }
-                        break;
-                    }
+                    // Convert physical sector to logical sector using SECTOR_SCRAMBLE
+                    // In GCR cache: physical sector N contains data from logical sector SECTOR_SCRAMBLE[N]
+                    currentSectortoWrite = SECTOR_SCRAMBLE[physicalSector];
                 }
             }
             
@@ -1690,7 +2661,6 @@ void FloppyEmulator::startWritingProcedure() {
             writeBitCount = 0;
             writeData = 0;
             writeBufferIndex = 0;
-            writeBitsProcessed = 0;  // Count bits processed (skip 25th bit)
             lastWritePinState = gpio_get(writePin) ? 1 : 0;
             
             // Initialize raw bit buffer state
@@ -1702,16 +2672,10 @@ void FloppyEmulator::startWritingProcedure() {
             // CRITICAL: Stop ALL potentially interfering processes
             // ============================================================
             
-            // 1. STOP PIO/DMA read completely (not just disable IRQ)
+            // 1. STOP PIO/DMA read completely
             if (dmaChannel >= 0 && pioDmaActive) {
-                // Disable DMA IRQ first
-                if (dmaChannel < 4) {
-                    dma_channel_set_irq0_enabled(dmaChannel, false);
-                } else {
-                    dma_channel_set_irq1_enabled(dmaChannel, false);
-                }
-                // Abort DMA transfer
-                dma_channel_abort(dmaChannel);
+                // Stop both DMA channels
+                haltReadStream();
                 // Stop PIO state machine
                 if (pio != nullptr) {
                     pio_sm_set_enabled(pio, pioSm, false);
@@ -1725,12 +2689,13 @@ void FloppyEmulator::startWritingProcedure() {
             // 3. Disable PWM IRQ (we poll manually)
             irq_set_enabled(PWM_IRQ_WRAP, false);
             
-            // 4. Disable DMA IRQ completely
-            irq_set_enabled(DMA_IRQ_0, false);
-            irq_set_enabled(DMA_IRQ_1, false);
-            
-            // Reset and start PWM timer for 4μs period timing
-            resetWritePWMTimer();
+            // Start PIO/DMA capture (bits are decoded later by processWriteCapture())
+            // Without it, reset and start PWM timer for 4μs period timing (polling loop)
+            if (writeCaptureReady) {
+                startWriteCapture();
+            } else {
+                resetWritePWMTimer();
+            }
 }
 //-----------------------------------------------
 void FloppyEmulator::stopWritingProcedure() {
@@ -1741,6 +2706,11 @@ void FloppyEmulator::stopWritingProcedure() {
         // Stop PWM timer
         stopWritePWMTimer();
         
+        // Stop PIO/DMA capture and decode the bytes still in the ring buffer
+        if (writeCaptureActive) {
+            stopWriteCapture();
+        }
+        
         // Process captured data FIRST (before re-enabling interrupts)
         endWriting();
         
@@ -1748,33 +2718,25 @@ void FloppyEmulator::stopWritingProcedure() {
         // Re-enable everything that was disabled
         // ============================================================
         
-        // 1. Re-enable DMA IRQs
-        irq_set_enabled(DMA_IRQ_0, true);
-        irq_set_enabled(DMA_IRQ_1, true);
-        
-        // 2. Re-enable PWM IRQ
+        // 1. Re-enable PWM IRQ
         irq_set_enabled(PWM_IRQ_WRAP, true);
         
-        // 3. Re-enable GPIO IRQs
+        // 2. Re-enable GPIO IRQs
         gpio_set_irq_enabled(writeEnablePin, GPIO_IRQ_EDGE_RISE | GPIO_IRQ_EDGE_FALL, true);
         gpio_set_irq_enabled(writePin, GPIO_IRQ_EDGE_RISE | GPIO_IRQ_EDGE_FALL, true);
         
-        // 4. RESTART PIO/DMA read
+        // 3. RESTART PIO/DMA read
         if (dmaChannel >= 0 && pioDmaActive) {
-            // Re-enable DMA channel IRQ
-            if (dmaChannel < 4) {
-                dma_channel_set_irq0_enabled(dmaChannel, true);
-            } else {
-                dma_channel_set_irq1_enabled(dmaChannel, true);
-            }
-            
-            // Restart PIO state machine
+            // Restart PIO state machine (old words in the FIFO/OSR are dropped)
             if (pio != nullptr) {
+                resetReadPIO();
                 pio_sm_set_enabled(pio, pioSm, true);
             }
             
-            // Restart DMA transfer from current position
-            dma_channel_set_read_addr(dmaChannel, gcrTrackCache, true);
+            // Restart the DMA loop from the track start
+            uint32_t save = save_and_disable_interrupts();
+            resumeReadStream(gcrTrackCache, 0);
+            restore_interrupts(save);
         }
 }
 //-----------------------------------------------
@@ -1838,16 +2800,7 @@ void FloppyEmulator::handleWriteIRQ(uint32_t events) {
 // Handle flux transition (pin change) - bit "1"
 // Based on AVR code write_pinchange()
 void FloppyEmulator::writePinChange() {
-    // Increment bit counter
     gpio_put(3, 1);
-    writeBitsProcessed++;
-    
-    // Skip the 25th bit (bits are 1-indexed: 1st, 2nd, ..., 25th)
-    if (writeBitsProcessed == 17) {
-        // This is the 25th bit - skip it, don't process it
-        gpio_put(3, 0);
-        return;
-    }
     
     // Shift left and add 1 (bit "1") - exactly like AVR code
     writeData = (writeData << 1) | 1;
@@ -1859,15 +2812,6 @@ void FloppyEmulator::writePinChange() {
 // Based on AVR code write_idle()
 void FloppyEmulator::writeIdle() {
     gpio_put(2, 1);
-    // Increment bit counter
-    writeBitsProcessed++;
-    
-    // Skip the 25th bit (bits are 1-indexed: 1st, 2nd, ..., 25th)
-    if (writeBitsProcessed == 17) {
-        // This is the 25th bit - skip it, don't process it
-        gpio_put(2, 0);
-        return;
-    }
     
     // Shift left (bit "0") - exactly like AVR code
     writeData = (writeData << 1);
@@ -1895,7 +2839,13 @@ void FloppyEmulator::checkWriteData() {
         }
         writeBitCount = 0;  // Reset bit count
         writeData = 0;      // Reset for next byte
-        writeBitsProcessed=0;
+        return;
+    }
+    
+    // Leading "0" bits before a byte are not data - like the Disk II read latch, a byte
+    // only starts with a "1" bit (GCR disk bytes always have MSB set). This absorbs the
+    // extra bit cell controllers insert between some bytes (e.g. 36-cycle byte after AD).
+    if (writeSynced && writeBitCount == 0 && writeData == 0) {
         return;
     }
 
@@ -1923,45 +2873,32 @@ void FloppyEmulator::writeBack() {
     // =========================================================================
     // writeBuffer contains: D5 AA AD (prologue) + 343 bytes data + DE AA EB (epilogue)
     // We need to write this to the correct position in gcrTrackCache
-    // 
-    // GCR cache sector structure (416 bytes per sector):
-    // - 22 sync bytes (0xFF)
-    // - 12 sync pattern bytes  
-    // - 3 bytes address prologue (D5 AA 96)
-    // - 8 bytes address data
-    // - 3 bytes address epilogue (DE AA EB)
-    // - 5 sync bytes (0xFF)
-    // - 3 bytes data prologue (D5 AA AD)  <- offset 53
-    // - 343 bytes data
-    // - 3 bytes data epilogue (DE AA EB)
-    // - 14 sync bytes (0xFF)
+    // The data field position of each sector comes from the track layout (gcrTrackMap->layout),
+    // scanned when the track was loaded - NIC images with any gap lengths work the same way.
+    // The field may wrap around the end of the track buffer.
     
     if (physicalSectorToWrite >= 0 && physicalSectorToWrite < 16 && writeBufferIndex >= 3) {
         // Check if this is a data field (D5 AA AD)
         if (writeBuffer[0] == 0xD5 && writeBuffer[1] == 0xAA && writeBuffer[2] == 0xAD) {
-            // Calculate position in GCR cache
-            // Each sector is 416 bytes, data field starts at offset 53
-            const uint32_t SECTOR_SIZE = 416;
-            const uint32_t DATA_FIELD_OFFSET = 53;  // 22 + 12 + 3 + 8 + 3 + 5 = 53
-            
-            uint32_t sectorStart = physicalSectorToWrite * SECTOR_SIZE;
-            uint32_t dataFieldPos = sectorStart + DATA_FIELD_OFFSET;
+            // Position of this sector's data field in the GCR cache
+            int16_t dataFieldPos = gcrTrackMap->layout.dataOffset[physicalSectorToWrite];
             
             // Copy writeBuffer to GCR cache (data field: prologue + data + epilogue)
             // writeBuffer contains: D5 AA AD + 343 bytes + DE AA EB = up to 349 bytes
             uint32_t bytesToCopy = writeBufferIndex;
-            if (bytesToCopy > 349) bytesToCopy = 349;  // Limit to data field size
+            if (bytesToCopy > GCR_DATA_FIELD_SIZE) bytesToCopy = GCR_DATA_FIELD_SIZE;  // Limit to data field size
             
-            // Make sure we don't overflow the cache
-            if (dataFieldPos + bytesToCopy <= APPLE_II_GCR_BYTES_PER_TRACK) {
-                for (uint32_t i = 0; i < bytesToCopy; i++) {
-                    gcrTrackCache[dataFieldPos + i] = writeBuffer[i];
-                }
+            // Sector must have a data field on this track (never grow a field into the gap)
+            if (dataFieldPos >= 0) {
+                copyToGCRTrack(gcrTrackCache, dataFieldPos, writeBuffer, bytesToCopy);
                 gcrTrackCacheDirty = true;  // Mark cache as dirty - needs to be saved before track change
+                if (gcrTrackCacheTrack >= 0 && gcrTrackCacheTrack < APPLE_II_TRACKS) {
+                    gcrTrackDirtySectors[gcrTrackCacheTrack] |= (1u << physicalSectorToWrite);  // Only this sector is flushed
+                }
                 //printf("GCR CACHE UPDATED: Physical sector %d, logical sector %d, %u bytes at offset %u\r\n",
                 //       physicalSectorToWrite, currentSectortoWrite, bytesToCopy, dataFieldPos);
             } else {
-                printf("ERROR: GCR cache write would overflow! pos=%u, bytes=%u\r\n", dataFieldPos, bytesToCopy);
+                printf("ERROR: No data field for physical sector %d on track %d\r\n", physicalSectorToWrite, gcrTrackCacheTrack);
             }
         }
     }
@@ -2150,101 +3087,3 @@ void FloppyEmulator::writeBack() {
     printf("=== WRITE ENDED - Buffer cleared ===\r\n\r\n");
 }
 
-// Decode NIC-encoded data field to raw sector data
-// Based on reverse of encoding logic in updateGCRTrackCache()
-// Encoding process:
-//   1. First 86 bytes: x = FLIP_BIT1[src[i] & 3] | FLIP_BIT2[src[i + 86] & 3] | FLIP_BIT3[src[i + 172] & 3]
-//      encoded = NIC_ENCODE_TABLE[(x ^ ox) & 0x3F], ox = x
-//   2. All 256 bytes: x = (src[i] >> 2)
-//      encoded = NIC_ENCODE_TABLE[(x ^ ox) & 0x3F], ox = x
-//   3. Last byte: encoded = NIC_ENCODE_TABLE[ox & 0x3F]
-void FloppyEmulator::decodeNICDataField(const uint8_t* gcrData, uint16_t gcrLength, uint8_t* decodedData, uint16_t* decodedLength) {
-    ensureNICDecodeTableInitialized();
-    
-    // Need at least: 86 (first encoding) + 256 (standard encoding) + 1 (last byte) = 343 bytes
-    if (gcrLength < 343) {
-        *decodedLength = 0;
-        return;
-    }
-    
-    uint8_t ox = 0;  // Previous XOR state (starts at 0)
-    uint8_t decoded6bit[343];  // Decoded 6-bit values
-    
-    // Step 1: Decode all GCR bytes to 6-bit values (XOR decode)
-    // Encoding: encoded = NIC_ENCODE_TABLE[(x ^ ox) & 0x3F], then ox = x
-    // Decoding: raw = NIC_DECODE_TABLE[encoded] = (x ^ prev_ox), then x = raw ^ prev_ox
-    //           ox must be updated to DECODED value (x), not raw value!
-    for (uint16_t i = 0; i < 343 && i < gcrLength; i++) {
-        uint8_t encoded = gcrData[i];
-        uint8_t raw = NIC_DECODE_TABLE[encoded];  // raw = (original_x ^ previous_ox)
-        if (raw == 0xFF) {
-            // Invalid GCR code - print diagnostic info
-            printf("ERROR: Invalid GCR code 0x%02X at position %u (gcrData[%u])\r\n", encoded, i, i);
-            *decodedLength = 0;
-            return;
-        }
-        decoded6bit[i] = raw ^ ox;  // XOR decode: x = (x ^ prev_ox) ^ prev_ox = x
-        ox = decoded6bit[i];  // CRITICAL: ox must be the DECODED value for next iteration!
-    }
-    
-    // Step 2: Decode the 256 bytes from standard encoding (positions 86 to 86+256)
-    // Each decoded6bit[i] (for i=86 to 86+256) represents (src[i-86] >> 2)
-    // So: src[i-86] = (decoded6bit[i] << 2) | lower_2_bits
-    // The lower 2 bits come from the first 86 bytes (FlipBit encoding)
-    
-    // Initialize decoded data with upper 6 bits
-    *decodedLength = 256;
-    for (uint16_t i = 0; i < 256; i++) {
-        if (86 + i < 343) {
-            uint8_t x = decoded6bit[86 + i];  // This is (src[i] >> 2)
-            decodedData[i] = (x << 2);  // Upper 6 bits (lower 2 bits = 0 for now)
-        } else {
-            decodedData[i] = 0;
-        }
-    }
-    
-    // Step 3: Decode lower 2 bits from first 86 bytes using reverse FlipBit mapping
-    // decoded6bit[0..85] contains: FLIP_BIT1[src[i] & 3] | FLIP_BIT2[src[i + 86] & 3] | FLIP_BIT3[src[i + 172] & 3]
-    // We need to extract src[i] & 3, src[i+86] & 3, src[i+172] & 3 from this
-    
-    // Decode lower 2 bits for bytes 0-85, 86-171, 172-257
-    for (uint16_t i = 0; i < 86 && i < 343; i++) {
-        uint8_t x = decoded6bit[i];  // FLIP_BIT1[a] | FLIP_BIT2[b] | FLIP_BIT3[c]
-        
-        // Extract individual components using reverse lookup
-        // FLIP_BIT1: {0,2,1,3} -> reverse: 0->0, 2->1, 1->2, 3->3
-        uint8_t a = 0;
-        uint8_t x_low = x & 0x03;
-        if (x_low == 0) a = 0;
-        else if (x_low == 2) a = 1;
-        else if (x_low == 1) a = 2;
-        else if (x_low == 3) a = 3;
-        
-        // FLIP_BIT2: {0,8,4,12} -> reverse: 0->0, 8->1, 4->2, 12->3
-        uint8_t b = 0;
-        uint8_t x_mid = x & 0x0C;
-        if (x_mid == 0) b = 0;
-        else if (x_mid == 8) b = 1;
-        else if (x_mid == 4) b = 2;
-        else if (x_mid == 12) b = 3;
-        
-        // FLIP_BIT3: {0,32,16,48} -> reverse: 0->0, 32->1, 16->2, 48->3
-        uint8_t c = 0;
-        uint8_t x_high = x & 0x30;
-        if (x_high == 0) c = 0;
-        else if (x_high == 32) c = 1;
-        else if (x_high == 16) c = 2;
-        else if (x_high == 48) c = 3;
-        
-        // Apply lower 2 bits to decoded data
-        if (i < 256) {
-            decodedData[i] = (decodedData[i] & 0xFC) | a;
-        }
-        if (i + 86 < 256) {
-            decodedData[i + 86] = (decodedData[i + 86] & 0xFC) | b;
-        }
-        if (i + 172 < 256) {
-            decodedData[i + 172] = (decodedData[i + 172] & 0xFC) | c;
-        }
-    }
-}
\ No newline at end of file
@@ -9,8 +9,14 @@
 #include "hardware/timer.h"
 #include "hardware/pio.h"
 #include "hardware/dma.h"
+#include "pico/critical_section.h"
 #include "floppy_bit_output.pio.h"
 #include "floppy_irq_timer.pio.h"
+#include "floppy_bit_input.pio.h"
+#include "floppy_phase_capture.pio.h"
+#include "FluxPLL.h"
+#include "FAT32.h"
+#include "SDAsyncEngine.h"
 
 // Apple II Floppy Disk Constants
 #define APPLE_II_TRACKS           35      // 0-34 tracks
@@ -22,6 +28,7 @@
 #define APPLE_II_ROTATION_TIME_MS  200     // One full rotation = 200ms (300 RPM)
 #define APPLE_II_ROTATION_TIME_US  (APPLE_II_ROTATION_TIME_MS * 1000)  // 200,000 microseconds
 #define APPLE_II_BITS_PER_ROTATION (APPLE_II_ROTATION_TIME_US / APPLE_II_BIT_PERIOD_US)  // 50,000 bits per rotation
+#define APPLE_II_NOMINAL_RPM       300     // Drive speed the 4μs bit cell belongs to
 #define APPLE_II_DISK_SIZE         (APPLE_II_TRACKS * APPLE_II_SECTORS_PER_TRACK * APPLE_II_BYTES_PER_SECTOR)  // 143360 bytes (DSK format)
 #define APPLE_II_NIC_DISK_SIZE     (APPLE_II_TRACKS * APPLE_II_SECTORS_PER_TRACK * 512)  // 286720 bytes (NIC format: 512 bytes per sector)
 #define APPLE_II_MAX_DISK_SIZE     APPLE_II_NIC_DISK_SIZE  // Maximum size to support both DSK and NIC formats
@@ -39,6 +46,43 @@
 // After GCR encoding: 6656 bytes (already GCR encoded in NIC format)
 #define APPLE_II_RAW_TRACK_BYTES   6656    // Raw bytes per track (416 bytes per sector * 16 sectors)
 #define APPLE_II_GCR_BYTES_PER_TRACK  APPLE_II_RAW_TRACK_BYTES  // Already GCR encoded in NIC format
+#define APPLE_II_GCR_BYTES_PER_SECTOR 416     // GCR bytes per sector in track cache (6656 / 16)
+#define APPLE_II_GCR_DISK_SIZE     (APPLE_II_TRACKS * APPLE_II_GCR_BYTES_PER_TRACK)  // 232960 bytes (whole disk pre-encoded)
+#define GCR_STREAM_WORDS_PER_TRACK (APPLE_II_GCR_BYTES_PER_TRACK / 4)  // 32-bit DMA transfers per revolution (track buffers are word aligned)
+#define HEAD_POSITION_TRIES        16      // Register snapshots getHeadBitPosition() tries for a consistent one
+
+// Track position index: one entry per GCR cache byte = physical sector owning that byte
+// (the sector whose address field was passed last) and the field type at that byte
+#define GCR_INDEX_SECTOR_MASK      0x0F    // Bits 0-3: physical sector (0-15)
+#define GCR_INDEX_FIELD_SHIFT      4       // Bits 4-5: GCRFieldType
+#define GCR_INDEX_UNKNOWN          0xFF    // No address field found on track
+#define GCR_INDEX_ENTRY(sector, field) ((uint8_t)(((field) << GCR_INDEX_FIELD_SHIFT) | ((sector) & GCR_INDEX_SECTOR_MASK)))
+
+// Whole-disk GCR mode: encode all 35 tracks once at load time (inside diskImage buffer)
+// so a track change only repoints the DMA read address. Set to false to start in per-track mode.
+#define FLOPPY_WHOLE_DISK_GCR_DEFAULT  true
+
+// Write capture: PIO timestamps WRITE pin flux transitions, DMA stores the 32-bit
+// edge intervals in a ring buffer, FluxPLL recovers the bit cells
+// 8192 bytes = 2048 intervals (>= 8ms of writing at one transition per 4μs) between two decode passes
+#define WRITE_CAPTURE_RING_BITS    13      // Ring size in bytes as power of 2 (DMA ring wrap)
+#define WRITE_CAPTURE_RING_SIZE    (1u << WRITE_CAPTURE_RING_BITS)
+#define WRITE_CAPTURE_RING_ENTRIES (WRITE_CAPTURE_RING_SIZE / 4)  // 32-bit intervals
+#define WRITE_CAPTURE_DMA_COUNT    0x0FFFFFFFu  // Transfer count for one write (effectively endless)
+#define FLUX_CAPTURE_EDGE_OVERHEAD_TICKS 2  // Ticks lost per edge in floppy_bit_input (mov/push/mov)
+
+// Read bit cell timing: floppy_bit_output takes FLOPPY_READ_CYCLES_PER_BIT PIO cycles per cell and
+// its clock divider is computed from clk_sys - exactly 4μs at 300 RPM, shorter cells for a faster drive
+#define FLOPPY_READ_CYCLES_PER_BIT 8
+#define FLOPPY_RPM_MIN             270     // Drive speed range for stress tests (+/-10%)
+#define FLOPPY_RPM_MAX             330
+#define FLOPPY_CELL_MEASURE_EDGES  4000    // READ pin edges timed by measureReadBitCell() (~15-30ms of track)
+#define FLOPPY_CELL_MEASURE_TIMEOUT_US 500000  // Gives up on a track without "1" bits
+
+// Stepper phase capture: floppy_phase_capture pushes every new PH0-PH3 state, the PIO IRQ
+// timestamps the states into a queue and detectStepperPhaseChange() consumes them
+#define STEPPER_EVENT_QUEUE_DEPTH  32      // Phase changes between the IRQ and detectStepperPhaseChange()
+#define STEPPER_POLL_INTERVAL_US   500     // Fallback polling period (no free PIO state machine)
 
 // GCR Encoding constants
 #define GCR_DATA_BITS              5       // 5 data bits
@@ -65,6 +109,103 @@ typedef enum {
     DISK_FILE_TYPE_NIC = 1     // .nic file format
 } DiskFileType;
 
+// Field type at a GCR track byte (see GCR_INDEX_ENTRY)
+typedef enum {
+    GCR_FIELD_GAP = 0,         // Gap between a data field and the next address field (safe swap point)
+    GCR_FIELD_ADDRESS = 1,     // Address field D5 AA 96 ... DE AA EB (14 bytes)
+    GCR_FIELD_DATA = 2,        // Data field D5 AA AD ... DE AA EB (349 bytes)
+    GCR_FIELD_ADDRESS_GAP = 3  // Gap between an address field and its data field
+} GCRFieldType;
+
+#define GCR_ADDRESS_FIELD_SIZE     14      // D5 AA 96 + 8 bytes (4-and-4) + DE AA EB
+#define GCR_DATA_FIELD_SIZE        349     // D5 AA AD + 343 bytes + DE AA EB
+
+// Real field positions of one GCR track, found by scanning for prologues
+// (tracks from non-standard INIT routines or NIC files need not use 416-byte sectors)
+// Offsets are positions in the circular track - a field may wrap past the end of the buffer
+typedef struct {
+    int16_t addressOffset[APPLE_II_SECTORS_PER_TRACK];  // Offset of D5 AA 96 per physical sector (-1 = missing)
+    int16_t dataOffset[APPLE_II_SECTORS_PER_TRACK];     // Offset of D5 AA AD per physical sector (-1 = missing)
+} GCRTrackLayout;
+
+// Layout + per-byte position index of one track buffer (swapped together with the track)
+typedef struct {
+    GCRTrackLayout layout;
+    uint8_t index[APPLE_II_GCR_BYTES_PER_TRACK];  // See GCR_INDEX_ENTRY
+} GCRTrackMap;
+
+// Track cache: encoded tracks (+ maps) kept in RAM, least recently used slot is reused
+// Holds the streamed track, the pending track and neighbours prefetched by core1
+#define GCR_TRACK_CACHE_SLOTS      4
+
+typedef struct {
+    uint8_t buffer[APPLE_II_GCR_BYTES_PER_TRACK] __attribute__((aligned(4)));  // Encoded track (per-track mode, word DMA)
+    GCRTrackMap map;
+    uint8_t* data;              // Track data of this slot (buffer, or diskImage in whole-disk mode)
+    volatile int track;         // Track held in this slot (-1 = empty/invalid)
+    volatile bool busy;         // Being filled - not usable or evictable yet
+    bool prefetched;            // Filled by prefetchNeighborTrack() (not yet used)
+    uint32_t lastUse;           // LRU stamp
+} GCRTrackSlot;
+
+// Read bit cell self-measurement (see 'rpm measure' CLI command)
+typedef struct {
+    uint32_t edges;             // READ pin edges timed
+    uint32_t cells;             // Bit cells between the first and the last timed falling edge
+    uint32_t cellPs;            // Measured bit cell (picoseconds)
+    uint32_t pulsePs;           // Measured pulse width of a "1" bit (picoseconds)
+    uint32_t expectedPs;        // Bit cell the divider was set for (picoseconds)
+    bool overrun;               // Edges were dropped (RX FIFO full) - result not valid
+} ReadCellMeasurement;
+
+// One captured phase change
+typedef struct {
+    uint32_t timeUs;            // time_us_32() when the IRQ took the state from the FIFO
+    uint8_t state;              // PH0-PH3 in bits 0-3
+} StepperPhaseEvent;
+
+// Phase capture counters (see 'gpio' CLI command)
+typedef struct {
+    uint32_t events;            // Phase states taken from the PIO
+    uint32_t steps;             // Head steps (physical track changes)
+    uint32_t dropped;           // States lost: PIO FIFO or event queue full
+    uint32_t lastStepIntervalUs; // Time between the last two steps
+    uint32_t minStepIntervalUs;  // Fastest step seen (0 = fewer than two steps)
+    uint32_t maxIrqLatencyUs;    // Longest run of an IRQ (drain + head update)
+} StepperCaptureStats;
+
+// Track cache counters (see 'tcache' CLI command)
+typedef struct {
+    uint32_t hits;              // Track change found the track in a slot
+    uint32_t misses;            // Track change had to encode the track on core0
+    uint32_t prefetches;        // Tracks filled by core1
+    uint32_t prefetchHits;      // Hits on slots filled by core1
+    int slotTrack[GCR_TRACK_CACHE_SLOTS];  // Track per slot (-1 = empty)
+    int frontSlot;              // Slot streamed by DMA
+    int direction;              // Last head direction (+1 = towards track 34, -1 = towards track 0, 0 = unknown)
+} GCRTrackCacheStats;
+
+// Write-back queue: snapshots of written tracks, decoded and saved to SD card by core1
+// (the stepper IRQ and core0 only copy the track - no decoding or SPI traffic)
+#define WRITE_BACK_QUEUE_DEPTH     4
+
+typedef struct {
+    int track;                  // Track of the snapshot
+    uint16_t dirtySectors;      // Physical sectors written (bit per sector)
+    GCRTrackLayout layout;      // Field positions of the snapshot
+    uint8_t gcr[APPLE_II_GCR_BYTES_PER_TRACK];  // Track contents when it was queued
+} WriteBackEntry;
+
+// Write-back counters (see 'status' CLI command)
+typedef struct {
+    uint32_t queued;            // Track snapshots queued
+    uint32_t completed;         // Snapshots decoded and written by core1
+    uint32_t async;             // Of those, written through the async SD engine
+    uint32_t retried;           // Async writes that failed and were written again blocking
+    uint32_t deferred;          // Queue was full - track stayed dirty and was queued later
+    uint32_t pending;           // Snapshots waiting in the queue now
+} WriteBackStats;
+
 // Forward declaration
 class SDCardManager;
 
@@ -73,7 +214,7 @@ private:
     // RAW disk image storage (linear array)
     // For DSK files: stores raw sector data (143360 bytes)
     // For NIC files: stores GCR-encoded track data (286720 bytes, but only first 416 bytes per sector are used)
-    uint8_t diskImage[APPLE_II_MAX_DISK_SIZE];
+    uint8_t diskImage[APPLE_II_MAX_DISK_SIZE] __attribute__((aligned(4)));  // Streamed by word DMA in whole-disk mode
     
     // Stepper motor control
     uint8_t stepperPhasePins[4];  // GPIO pins for PH0, PH1, PH2, PH3
@@ -81,7 +222,7 @@ private:
     int currentSector;              // Current sector position (0-15)
     int currentSectortoWrite;              // Logical sector to write (0-15) - for disk image
     int physicalSectorToWrite;             // Physical sector (0-15) - for GCR cache position
-    uint32_t dmaPositionAtWriteStart;       // DMA position when write started (for sector detection)
+    uint32_t dmaPositionAtWriteStart;       // Track byte under the head when write started (for sector detection)
 
     //int LastTrackLoaded;            // Last track loaded from disk image
     int currentStep;                // Current step position (0-3 per track)
@@ -89,6 +230,17 @@ private:
     StepperPhase currentPhase;      // Current stepper phase
     StepperPhase lastPhaseOffset;   // Last phase offset for change detection (matches ATMegaX old_ofs)
     
+    // Stepper phase capture (PIO + IRQ, replaces the 500μs polling timer when available)
+    PIO phaseCapturePio;            // PIO instance for phase capture
+    uint phaseCaptureSm;            // PIO state machine for phase capture
+    uint phaseCaptureOffset;        // PIO program offset
+    bool phaseCaptureReady;         // Capture running (else processStepperMotor() polls the pins)
+    StepperPhaseEvent stepperEvents[STEPPER_EVENT_QUEUE_DEPTH];
+    volatile uint32_t stepperEventHead;  // Next free slot (free running)
+    volatile uint32_t stepperEventTail;  // Oldest unprocessed event (free running)
+    uint32_t lastStepTimeUs;        // Time of the last head step (0 = none yet)
+    StepperCaptureStats stepperStats;
+    
     // Read/Write control
     uint8_t readPin;                // GPIO pin for READ data output (to controller)
     uint8_t writePin;               // GPIO pin for WRITE data input (from controller)
@@ -96,8 +248,7 @@ private:
     uint8_t driveSelPin;            // GPIO pin for DRIVE_SEL (from controller - selects this drive)
     
     // Timing and synchronization
-    absolute_time_t lastBitTime;    // Last bit time for timing
-    uint32_t rotationPosition;      // Current rotation position (0-65535)
+    uint32_t rotationPosition;      // Bit under the head (offset into the streamed track, see getHeadBitPosition())
     bool indexPulse;                // Index pulse state
     repeating_timer_t bitTimer;     // Hardware timer for precise bit timing
     bool timerActive;                // Timer active flag
@@ -114,7 +265,6 @@ private:
     uint8_t lastWritePinState;                      // Last state of WRITE pin (for flux transition detection)
     uint8_t prologBuffer[3];                        // 3-byte buffer for prolog detection (shifted on each bit)
     uint8_t prologBitCount;                         // Number of bits collected in prolog buffer (0-24)
-    uint16_t writeBitsProcessed;                    // Number of bits processed so far (for skipping 25th bit)
     
     // Temporary buffer for collecting all bits byte-by-byte (for debugging)
     static const uint32_t RAW_BIT_BUFFER_SIZE = 500;  // Temporary buffer size for raw bits
@@ -128,12 +278,56 @@ private:
     
     // GCR track cache - pre-encoded GCR data for current track
     // This allows fast bit access in interrupt handler without expensive GCR encoding
-    uint8_t gcrTrackCache_tmp[APPLE_II_GCR_BYTES_PER_TRACK];
-
-    uint8_t gcrTrackCache[APPLE_II_GCR_BYTES_PER_TRACK];
-    int gcrTrackCacheTrack;         // Track number for which cache is valid (-1 = invalid)
+    // Slots (see GCRTrackSlot): the new track is taken from / encoded into a slot that is NOT being
+    // streamed, then swapped in at a sync gap so the controller never sees a torn track.
+    // core1 fills the next slot with the neighbour track in the head's direction of travel.
+    GCRTrackSlot gcrTrackSlots[GCR_TRACK_CACHE_SLOTS];
+    critical_section_t gcrTrackSlotLock;  // Slot track/busy/LRU state (shared by core0 and core1)
+    uint32_t gcrTrackSlotClock;           // LRU clock
+    GCRTrackCacheStats gcrTrackCacheStats;
+    volatile int stepDirection;           // +1 / -1 from last head step (0 = unknown)
+    
+    // Pointer to GCR data of the current track (front buffer, streamed by DMA)
+    // Per-track mode: points to the buffer of a slot
+    // Whole-disk mode: points into diskImage (diskImage + track * 6656, encoded once at load)
+    uint8_t* volatile gcrTrackCache;
+    volatile int gcrTrackCacheTrack; // Track number for which cache is valid (-1 = invalid)
+    
+    // Back buffer waiting to be swapped in (nullptr = no swap pending)
+    uint8_t* volatile pendingGCRTrackCache;
+    volatile int pendingGCRTrackCacheTrack;  // Track encoded in pendingGCRTrackCache
+    
+    // Layout and position index for front/back track (map of its slot) - swapped together with the track
+    // Write start looks up the sector at the DMA read position instead of scanning backwards,
+    // read/write/flush paths use the real field offsets instead of fixed 416-byte geometry
+    GCRTrackMap* volatile gcrTrackMap;         // Map of gcrTrackCache
+    GCRTrackMap* volatile pendingGCRTrackMap;  // Map of pendingGCRTrackCache
     uint32_t gcrTrackCacheBits;     // Number of GCR bits in cache (48 bits per 5-byte group)
     bool gcrTrackCacheDirty;        // True if GCR cache has been modified (needs to be saved before track change)
+    uint16_t gcrTrackDirtySectors[APPLE_II_TRACKS];  // Per-track bitmap of physical sectors written since last flush
+    
+    // Write-back queue (single consumer on core1, producers serialized by gcrTrackSlotLock)
+    // head/tail only grow - entry = writeBackQueue[index % WRITE_BACK_QUEUE_DEPTH]
+    WriteBackEntry writeBackQueue[WRITE_BACK_QUEUE_DEPTH];
+    volatile uint32_t writeBackHead;   // Next entry to fill (producer)
+    volatile uint32_t writeBackTail;   // Next entry to save (consumer, core1)
+    // Snapshots queued/saved per track - a track with queued != saved must not be re-encoded from diskImage
+    volatile uint8_t writeBackQueuedPerTrack[APPLE_II_TRACKS];
+    volatile uint8_t writeBackSavedPerTrack[APPLE_II_TRACKS];
+    uint32_t writeBackQueuedCount;
+    volatile uint32_t writeBackCompletedCount;
+    uint32_t writeBackDeferredCount;
+    // Tail snapshot whose SD card writes are queued on the async engine - it stays at the tail
+    // until the completion callbacks (poll() on core1) have counted writeBackRequestsPending down
+    bool writeBackInFlight;
+    uint32_t writeBackRequestsPending;
+    uint32_t writeBackAsyncCount;
+    uint32_t writeBackRetryCount;
+    
+    // Whole-disk GCR image state
+    bool wholeDiskGCRMode;          // Requested mode (applied on next loadDiskImage())
+    bool wholeDiskGCRActive;        // True if diskImage currently holds 35 pre-encoded GCR tracks
+    volatile bool diskImageLoading; // True while diskImage is being overwritten/converted (process() stays idle)
     
     // Track change detection for delayed cache loading
     int pendingTrack;                // Track that needs to be loaded (when stable)
@@ -142,16 +336,20 @@ private:
     
     // SD card and file management
     SDCardManager* sdCardManager;    // Pointer to SD card manager (for saving tracks to file)
-    char currentFileName[64];        // Current disk image filename (for saving tracks)
+    FAT32File currentFile;           // Open disk image (track saves go straight to its sectors)
     DiskFileType currentFileType;     // Type of loaded disk image file (.dsk or .nic)
     
     // PIO/DMA for continuous bit output
     PIO pio;                        // PIO instance (pio0 or pio1)
     uint pioSm;                     // PIO state machine index
     uint pioOffset;                 // PIO program offset
-    int dmaChannel;                 // DMA channel for transferring data to PIO FIFO
+    int dmaChannel;                 // DMA data channel: track bytes -> PIO TX FIFO (chains to the control channel)
+    int dmaControlChannel;          // DMA control channel: reloads the data channel at the end of every revolution
     bool pioDmaActive;              // PIO/DMA active flag
-    dma_channel_config dmaConfig;   // Cached DMA config for fast IRQ restart
+    dma_channel_config dmaConfig;   // Cached data channel config (chain to the control channel)
+    volatile uint32_t readStreamBase;  // Start of the streamed track - copied by the control channel to the data channel
+    uint32_t readRpm;               // Drive speed of the read stream (FLOPPY_RPM_MIN..FLOPPY_RPM_MAX)
+    uint32_t readClockDiv;          // Read PIO clock divider (16.8 fixed point) for readRpm at the current clk_sys
     
     // PIO IRQ timer for write bit capture (4μs period)
     PIO writeIrqTimerPio;           // PIO instance for IRQ timer
@@ -159,6 +357,17 @@ private:
     uint writeIrqTimerOffset;       // PIO program offset
     bool writeIrqTimerActive;       // IRQ timer active flag
     
+    // PIO/DMA write capture (flux transitions detected by PIO, bytes stored in ring buffer)
+    PIO writeCapturePio;            // PIO instance for write capture (pio1 - pio0 streams READ)
+    uint writeCaptureSm;            // PIO state machine for write capture
+    uint writeCaptureOffset;        // PIO program offset
+    int writeCaptureDmaChannel;     // DMA channel RX FIFO -> ring buffer
+    bool writeCaptureReady;         // PIO/DMA capture initialized (else fall back to polling loop)
+    bool writeCaptureActive;        // Capture running (WRITE_EN active)
+    uint32_t writeCaptureReadIndex; // Intervals decoded so far in current write
+    uint32_t writeCaptureOverruns;  // Writes where decoding fell a full ring behind
+    FluxPLL writePLL;               // Software data separator for captured edge intervals
+    
     int lastTimeWriteCheck = get_absolute_time(); // Last time GCR cache was saved to disk image
     int lastTimeChangeTrackCheck = get_absolute_time(); // Last time GCR cache was saved to disk image
     // Internal methods
@@ -166,20 +375,46 @@ private:
     uint8_t encodeGCR(uint8_t data);
     uint8_t decodeGCR(uint8_t gcr);
     void detectStepperPhaseChange();  // Detect phase changes from controller
+    void applyStepperPhaseState(uint8_t stp_pos, uint32_t timeUs);  // Move the head for one phase state
+    void initPhaseCapture();          // Claim a PIO SM + IRQ for phase capture
     void updateStepperPosition();     // Update position based on phase changes
     void updateStepperPositionWithPhases(StepperPhase oldPhase, StepperPhase newPhase);  // Update position with explicit phases
     uint32_t calculateTrackOffset(int track, int sector);
     void updateRotationPosition();
     uint32_t getCurrentBitPosition(); // Get current bit position on track
 //    uint8_t getGCRBitAtPosition(uint32_t rawBitPosition); // Get GCR-encoded bit at raw bit position
-    void updateGCRTrackCache();  // Update GCR cache for current track (called when track changes)
+    void updateGCRTrackCache();  // Encode current track into back buffer and arm the swap (called when track changes)
+    bool swapPendingGCRTrackCache();  // Swap back buffer in if the stream is inside a sync gap
+    void encodeGCRSector(uint8_t track, uint8_t physicalSector, const uint8_t* sectorData, uint8_t* gcr);  // Encode one 416-byte GCR sector
+    void buildWholeDiskGCRImage();  // Convert diskImage in place to 35 contiguous GCR tracks
+    void buildGCRTrackLayout(const uint8_t* track, GCRTrackLayout* layout);  // Find address/data fields of a track
+    void buildGCRTrackMap(const uint8_t* track, GCRTrackMap* map);  // Layout + map every track byte to sector/field
+    int findGCRTrackSlot(int track);   // Slot holding track (-1 = none) - gcrTrackSlotLock held
+    int claimGCRTrackSlot();           // LRU slot that is not streamed/pending/busy - gcrTrackSlotLock held
+    void fillGCRTrackSlot(int slot, int track);  // Encode track into slot and build its map
+    void invalidateGCRTrackSlots(int track);     // Drop cached copies of track (-1 = all tracks)
+    bool isWriteBackPending(int track);          // Snapshot of track still waiting in the write-back queue
+    void writeBackTrack(const WriteBackEntry* entry);  // Decode a snapshot and save it to the SD card file
+    void writeBackSectors(int track, const uint8_t* trackData, uint32_t trackSize,
+                          uint16_t asyncSectors, uint16_t blockingSectors);  // Queue / write sectors of a track
+    void retargetReadStream(const uint8_t* newBase);  // Repoint running DMA to another track, keeping rotational offset
     void initPIO_DMA();          // Initialize PIO and DMA for continuous bit output
     void startPIO_DMA();         // Start PIO/DMA streaming from cache buffer
     void stopPIO_DMA();          // Stop PIO/DMA streaming
+    void haltReadStream();       // Stop both read DMA channels (chain broken first - nothing restarts them)
+    void resumeReadStream(const uint8_t* base, uint32_t offset);  // Restart the read DMA loop at offset of base
+    void resetReadPIO();         // Empty the read PIO (FIFO, OSR) and restart its bit counter - stream halted
+    void applyReadClockDivider(); // Compute readClockDiv from clk_sys and readRpm, set it on the running SM
+    void initWriteCapture();     // Initialize PIO/DMA write capture (pio1)
+    void startWriteCapture();    // Start capturing WRITE pin bits into ring buffer
+    void stopWriteCapture();     // Stop capture and decode the remaining bytes
     
 public:
-    void saveGCRCacheToDiskImage();  // Save GCR cache back to disk image (called before track change if dirty)
-    void handleDMAIRQ();         // Handle DMA IRQ for fast restart (called from IRQ handler)
+    bool saveGCRCacheToDiskImage();  // Queue written sectors of the streamed track for write-back (false = queue full)
+    bool processWriteBackQueue();    // Save one queued snapshot (core1) - false if queue was empty
+    void handleWriteBackRequestDone(const SDAsyncRequest* request);  // Async write of a snapshot finished (core1)
+    void flushWriteBackQueue();      // Queue the streamed track and save everything (core1, before a new image)
+    void getWriteBackStats(WriteBackStats* stats);
     // GPIO IRQ handler (public for IRQ handler access)
     //void handleWriteEnableIRQ(uint32_t events);  // Handle WRITE_EN GPIO IRQ (called from IRQ handler)
     //void handleWriteIRQ(uint32_t events);  // Handle WRITE pin GPIO IRQ (called from IRQ handler)
@@ -207,10 +442,15 @@ public:
     void writeBack();            // Write captured data back to disk image
     void startWritingProcedure(); // Start writing procedure (called when write starts)
     void stopWritingProcedure(); // Stop writing procedure (called when write ends)
+    bool isWriteCaptureReady() const;  // True if PIO/DMA write capture is available
+    void processWriteCapture();  // Decode intervals captured so far (call repeatedly while WRITE_EN active)
+    FluxPLL* getWritePLL();      // Write data separator (tolerance setting, lock state)
+    void prefetchNeighborTrack(); // Fill a cache slot with the next track in the head's direction (core1)
+    void getTrackCacheStats(GCRTrackCacheStats* stats);
+    void resetTrackCacheStats();
     //void addBitToRAWBuffer(uint8_t bit); // Add bit to RAW buffer
     
     bool floppy_write_in();
-    void decodeNICDataField(const uint8_t* gcrData, uint16_t gcrLength, uint8_t* decodedData, uint16_t* decodedLength);  // Decode NIC-encoded data field
     // Constructor
     FloppyEmulator(
         uint8_t ph0, uint8_t ph1, uint8_t ph2, uint8_t ph3,
@@ -225,6 +465,10 @@ public:
     
     // Stepper motor monitoring (reactive to controller signals)
     void processStepperMotor();     // Process stepper motor phase changes from controller
+    void handlePhaseCaptureIRQ();   // PIO RX IRQ: queue captured phase states and process them
+    bool isPhaseCaptureReady() const;  // True if PIO phase capture runs (no polling timer needed)
+    void getStepperCaptureStats(StepperCaptureStats* stats);
+    void resetStepperCaptureStats();
     int getCurrentTrack() const;
     int getCurrentSector() const;
     bool isAtTrack0() const;
@@ -243,6 +487,8 @@ public:
     bool getGCRSectorFromCache(int sector, uint8_t* buffer, uint32_t maxLen, uint32_t* outLen);
     
     // Disk image management
+    void beginDiskImageLoad();  // Flush pending writes and park the read stream before diskImage is overwritten
+    void abortDiskImageLoad();  // Failed load after beginDiskImageLoad(): blank image, resume process()
     void loadDiskImage(const uint8_t* image, uint32_t size);
     void clearDiskImage();
     uint8_t* getDiskImage();
@@ -251,6 +497,14 @@ public:
     // Timing and synchronization
     void updateTiming();            // Update timing state (call periodically in main loop)
     void syncToIndex();             // Synchronize to index pulse
+    uint32_t getHeadBitPosition();  // Bit on the READ pin now (offset into the streamed track, bit-accurate)
+    
+    // Drive speed of the read stream (call setReadRPM(getReadRPM()) after changing clk_sys)
+    bool setReadRPM(uint32_t rpm);
+    uint32_t getReadRPM() const { return readRpm; }
+    uint32_t getReadClockDivider() const { return readClockDiv; }  // 16.8 fixed point
+    uint32_t getReadCellPs() const;  // Bit cell the divider gives (picoseconds)
+    bool measureReadBitCell(ReadCellMeasurement* result);  // Time the READ pin with a spare pio1 SM
     uint32_t getBitPeriodUs() const;
     
     // Main processing loop (call this in main loop to react to controller)
@@ -262,9 +516,15 @@ public:
     
     // SD card and file management
     void setSDCardManager(SDCardManager* sdCard);  // Set SD card manager for saving tracks
-    void setCurrentFileName(const char* filename);  // Set current disk image filename
-    const char* getCurrentFileName() const;  // Get current disk image filename
+    FAT32File* getCurrentFile();  // Handle filled by SDCardManager::loadDiskImage()
+    void updateCurrentFileType();  // File type (.dsk/.nic) from the open file's name
+    const char* getCurrentFileName() const;  // Get current disk image filename ("" = none)
     DiskFileType getCurrentFileType() const;  // Get current disk image file type
+    
+    // Whole-disk GCR mode (takes effect on next disk image load)
+    void setWholeDiskGCRMode(bool enabled);
+    bool getWholeDiskGCRMode() const;
+    bool isWholeDiskGCRActive() const;
 };
 
 #endif // FLOPPY_EMULATOR_H
@@ -0,0 +1,185 @@
+#include "FluxPLL.h"
+#include <string.h>
+
+FluxPLL::FluxPLL() {
+    tolerancePct = FLUX_PLL_DEFAULT_TOLERANCE_PCT;
+    periodAdjPct = FLUX_PLL_DEFAULT_PERIOD_ADJ_PCT;
+    phaseAdjPct = FLUX_PLL_DEFAULT_PHASE_ADJ_PCT;
+    nominalCell = 0;
+    cell = 0;
+    cellMin = 0;
+    cellMax = 0;
+    phase = 0;
+}
+
+void FluxPLL::configure(uint32_t nominalCellTicks, uint8_t tolerance, uint8_t periodAdj, uint8_t phaseAdj) {
+    nominalCell = (int32_t)(nominalCellTicks << 8);
+    periodAdjPct = periodAdj;
+    phaseAdjPct = phaseAdj > 100 ? 100 : phaseAdj;
+    setTolerance(tolerance);
+    reset();
+}
+
+void FluxPLL::setTolerance(uint8_t tolerance) {
+    if (tolerance > 50) {
+        tolerance = 50;  // More than +/-50% would overlap neighbouring cell counts
+    }
+    tolerancePct = tolerance;
+    cellMin = nominalCell - (nominalCell / 100) * tolerancePct;
+    cellMax = nominalCell + (nominalCell / 100) * tolerancePct;
+}
+
+uint8_t FluxPLL::getTolerance() const {
+    return tolerancePct;
+}
+
+void FluxPLL::reset() {
+    cell = nominalCell;
+    phase = 0;
+}
+
+// Same algorithm as a classic floppy data separator:
+// 1. Count whole cells in the interval (edge belongs to the cell whose centre is nearest)
+// 2. Remaining phase error nudges the cell period (frequency) and is partly kept (phase)
+// 3. After a long zero run the PLL is out of sync - period drifts back towards nominal
+uint16_t FluxPLL::feedInterval(uint32_t ticks) {
+    if (ticks > 0x7FFFFF) {
+        ticks = 0x7FFFFF;  // Keep ticks << 8 inside int32 (80ms at 100MHz - far beyond any valid gap)
+    }
+
+    int32_t t = phase + (int32_t)(ticks << 8);
+    if (t < cell / 2) {
+        // Glitch - shorter than half a cell, fold into the next interval
+        phase = t;
+        return 0xFFFF;
+    }
+
+    // Number of cells this transition spans (>= 1), phase error in [-cell/2, cell/2)
+    int32_t cells = (t + cell / 2) / cell;
+    t -= cells * cell;
+    uint32_t zeros = (uint32_t)(cells - 1);
+
+    // Frequency: follow phase error while in sync, otherwise relax towards nominal
+    if (zeros <= FLUX_PLL_MAX_ZEROS_IN_SYNC) {
+        cell += (t / 100) * periodAdjPct;
+    } else {
+        cell += ((nominalCell - cell) / 100) * periodAdjPct;
+    }
+    if (cell < cellMin) {
+        cell = cellMin;
+    } else if (cell > cellMax) {
+        cell = cellMax;
+    }
+
+    // Phase: keep only part of the error for the next interval
+    phase = (t / 100) * (100 - phaseAdjPct);
+
+    return zeros > 0xFFFE ? 0xFFFE : (uint16_t)zeros;
+}
+
+uint32_t FluxPLL::getCellTicks() const {
+    return (uint32_t)((cell + 128) >> 8);
+}
+
+uint32_t FluxPLL::getNominalCellTicks() const {
+    return (uint32_t)(nominalCell >> 8);
+}
+
+// Valid Disk II byte: MSB set and no more than two consecutive "0" bits
+static bool isValidDiskByte(uint8_t b) {
+    if (!(b & 0x80)) {
+        return false;
+    }
+    for (int i = 0; i < 6; i++) {
+        if (((b >> i) & 0x07) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void FluxPLL::runSyntheticTest(uint32_t nominalCellTicks, uint8_t tolerancePct, int32_t speedPermille,
+                               uint32_t jitterPct, uint32_t byteCount, FluxPLLTestResult* result) {
+    static const uint32_t MAX_TEST_BYTES = 1024;
+    static uint8_t stream[MAX_TEST_BYTES];
+    uint32_t seed = 0x1F2E3D4Cu;
+
+    if (byteCount > MAX_TEST_BYTES) {
+        byteCount = MAX_TEST_BYTES;
+    }
+    if (byteCount < 16) {
+        byteCount = 16;
+    }
+
+    // 8 sync bytes, then random valid disk bytes (like a data field)
+    for (uint32_t i = 0; i < byteCount; i++) {
+        if (i < 8) {
+            stream[i] = 0xFF;
+            continue;
+        }
+        uint8_t b;
+        do {
+            seed = seed * 1103515245u + 12345u;
+            b = (uint8_t)(seed >> 16);
+        } while (!isValidDiskByte(b));
+        stream[i] = b;
+    }
+
+    FluxPLL pll;
+    pll.configure(nominalCellTicks, tolerancePct);
+
+    // Controller cell period at this speed (faster drive clock = shorter cells)
+    uint64_t cellScaleNum = (uint64_t)nominalCellTicks * 1000;
+    uint64_t cellScaleDen = (uint64_t)(1000 + speedPermille);
+    int32_t jitterMax = (int32_t)((nominalCellTicks * jitterPct) / 100);
+
+    uint32_t totalBits = byteCount * 8;
+    uint32_t bitsDecoded = 0;
+    uint32_t bitErrors = 0;
+    uint32_t lastBitSent = 0;   // Index of last "1" bit (stream after it is not observable)
+    int64_t lastEdge = 0;       // First bit of stream is "1" (0xFF) - it is the reference edge
+
+    for (uint32_t k = 1; k < totalBits; k++) {
+        if (!((stream[k >> 3] >> (7 - (k & 7))) & 1)) {
+            continue;
+        }
+        lastBitSent = k;
+
+        // Edge time with random jitter
+        int64_t edge = (int64_t)((k * cellScaleNum) / cellScaleDen);
+        if (jitterMax > 0) {
+            seed = seed * 1103515245u + 12345u;
+            edge += (int32_t)((seed >> 8) % (uint32_t)(2 * jitterMax + 1)) - jitterMax;
+        }
+        uint32_t interval = (uint32_t)(edge - lastEdge);
+        lastEdge = edge;
+
+        uint16_t zeros = pll.feedInterval(interval);
+        if (zeros == 0xFFFF) {
+            continue;
+        }
+
+        // Compare recovered bits (zeros x "0", then "1") with stream, position by position
+        for (uint32_t z = 0; z <= zeros; z++) {
+            uint32_t pos = 1 + bitsDecoded;
+            uint8_t bit = (z == zeros) ? 1 : 0;
+            if (pos >= totalBits || ((stream[pos >> 3] >> (7 - (pos & 7))) & 1) != bit) {
+                bitErrors++;
+            }
+            bitsDecoded++;
+        }
+    }
+
+    // Missing bits count as errors too
+    uint32_t bitsSent = lastBitSent;  // Bits 1..lastBitSent
+    if (bitsDecoded < bitsSent) {
+        bitErrors += bitsSent - bitsDecoded;
+    }
+
+    result->speedPermille = speedPermille;
+    result->jitterPct = jitterPct;
+    result->bitsSent = bitsSent;
+    result->bitsDecoded = bitsDecoded;
+    result->bitErrors = bitErrors;
+    result->finalCellTicks = pll.getCellTicks();
+}
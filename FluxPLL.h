@@ -0,0 +1,67 @@
+#ifndef FLUX_PLL_H
+#define FLUX_PLL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Software data separator (digital PLL) for Apple II write data
+// Input:  time between two flux transitions (edge intervals) in capture ticks
+// Output: recovered bit cells - N "0" bits followed by one "1" bit per interval
+//
+// The cell period follows the controller clock within +/- tolerance of nominal,
+// so writes from drifting controllers or accelerator cards (faster 4μs cells)
+// still decode. All math is 24.8 fixed point (no floating point in the write path).
+
+#define FLUX_PLL_DEFAULT_TOLERANCE_PCT   10   // Cell period may drift +/-10% from nominal
+#define FLUX_PLL_DEFAULT_PERIOD_ADJ_PCT  5    // Frequency correction: 5% of phase error per transition
+#define FLUX_PLL_DEFAULT_PHASE_ADJ_PCT   60   // Phase correction: 60% of phase error per transition
+#define FLUX_PLL_MAX_ZEROS_IN_SYNC       3    // Longer zero runs = out of sync (valid GCR has at most 2)
+
+// Result of a synthetic decode test (see FluxPLL::runSyntheticTest())
+typedef struct {
+    int32_t speedPermille;      // Simulated speed offset (+50 = 5% faster, -50 = 5% slower)
+    uint32_t jitterPct;         // Max random edge jitter (% of bit cell)
+    uint32_t bitsSent;          // Bits in synthetic stream
+    uint32_t bitsDecoded;       // Bits recovered by the PLL
+    uint32_t bitErrors;         // Mismatched bits (compared position by position)
+    uint32_t finalCellTicks;    // Cell period the PLL settled at (ticks)
+} FluxPLLTestResult;
+
+class FluxPLL {
+private:
+    int32_t nominalCell;        // Nominal cell period (ticks << 8)
+    int32_t cell;               // Current cell period estimate (ticks << 8)
+    int32_t cellMin;            // Lower clamp (ticks << 8)
+    int32_t cellMax;            // Upper clamp (ticks << 8)
+    int32_t phase;              // Residual phase error after last transition (ticks << 8)
+    uint8_t tolerancePct;
+    uint8_t periodAdjPct;
+    uint8_t phaseAdjPct;
+
+public:
+    FluxPLL();
+
+    // Configure for a nominal cell period (e.g. 400 ticks = 4μs at 100MHz tick rate)
+    void configure(uint32_t nominalCellTicks, uint8_t tolerancePct = FLUX_PLL_DEFAULT_TOLERANCE_PCT,
+                   uint8_t periodAdjPct = FLUX_PLL_DEFAULT_PERIOD_ADJ_PCT,
+                   uint8_t phaseAdjPct = FLUX_PLL_DEFAULT_PHASE_ADJ_PCT);
+    void setTolerance(uint8_t tolerancePct);
+    uint8_t getTolerance() const;
+
+    // Reset to nominal cell period and zero phase (call at start of every write)
+    void reset();
+
+    // Feed one edge interval; returns number of "0" bits before the "1" bit of this transition
+    // Returns 0xFFFF for a glitch (interval shorter than half a cell - ignored, no bits)
+    uint16_t feedInterval(uint32_t ticks);
+
+    uint32_t getCellTicks() const;      // Current cell period (ticks, rounded)
+    uint32_t getNominalCellTicks() const;
+
+    // Decode a synthetic edge stream (random GCR disk bytes) at a given speed offset and jitter
+    // Used by the 'plltest' CLI command and the flux_pll host test (tests/)
+    static void runSyntheticTest(uint32_t nominalCellTicks, uint8_t tolerancePct, int32_t speedPermille,
+                                 uint32_t jitterPct, uint32_t byteCount, FluxPLLTestResult* result);
+};
+
+#endif // FLUX_PLL_H
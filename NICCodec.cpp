@@ -0,0 +1,158 @@
+#include "NICCodec.h"
+#include <stdio.h>
+
+// Apple II NIC format encoding table (6-bit GCR)
+static constexpr uint8_t NIC_ENCODE_TABLE[64] = {
+    0x96, 0x97, 0x9A, 0x9B, 0x9D, 0x9E, 0x9F, 0xA6,
+    0xA7, 0xAB, 0xAC, 0xAD, 0xAE, 0xAF, 0xB2, 0xB3,
+    0xB4, 0xB5, 0xB6, 0xB7, 0xB9, 0xBA, 0xBB, 0xBC,
+    0xBD, 0xBE, 0xBF, 0xCB, 0xCD, 0xCE, 0xCF, 0xD3,
+    0xD6, 0xD7, 0xD9, 0xDA, 0xDB, 0xDC, 0xDD, 0xDE,
+    0xDF, 0xE5, 0xE6, 0xE7, 0xE9, 0xEA, 0xEB, 0xEC,
+    0xED, 0xEE, 0xEF, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6,
+    0xF7, 0xF9, 0xFA, 0xFB, 0xFC, 0xFD, 0xFE, 0xFF
+};
+
+// Flip bit tables for data encoding
+// FLIP_BIT2/FLIP_BIT3 are FLIP_BIT1 shifted left by 2/4 (low 2 bits swapped: 1 <-> 2)
+static constexpr uint8_t FLIP_BIT1[4] = { 0, 2, 1, 3 };
+static constexpr uint8_t FLIP_BIT2[4] = { 0, 8, 4, 12 };
+static constexpr uint8_t FLIP_BIT3[4] = { 0, 32, 16, 48 };
+
+// Lookup tables generated at compile time (no runtime initialization, stored in flash/RAM image)
+struct NICByteTable {
+    uint8_t v[256];
+};
+
+// Aux nibble unpack entry: low 2 bits of the three bytes packed into one 6-bit aux value
+struct NICAuxUnpack {
+    uint8_t a;  // Low 2 bits of byte i
+    uint8_t b;  // Low 2 bits of byte i + 86
+    uint8_t c;  // Low 2 bits of byte i + 172
+};
+
+struct NICAuxUnpackTable {
+    NICAuxUnpack v[64];
+};
+
+// NIC decode table: maps encoded byte to 6-bit value (0-63), 0xFF = invalid code
+// Built from NIC_ENCODE_TABLE: decodeTable[encoded] = index
+static constexpr NICByteTable buildNICDecodeTable() {
+    NICByteTable table = {};
+    for (int i = 0; i < 256; i++) {
+        table.v[i] = 0xFF;
+    }
+    for (int i = 0; i < 64; i++) {
+        table.v[NIC_ENCODE_TABLE[i]] = i;
+    }
+    return table;
+}
+
+// Byte -> FlipBit-encoded low 2 bits (FLIP_BIT1[byte & 3]) for all 256 byte values
+static constexpr NICByteTable buildNICLow2Table() {
+    NICByteTable table = {};
+    for (int i = 0; i < 256; i++) {
+        table.v[i] = FLIP_BIT1[i & 3];
+    }
+    return table;
+}
+
+// Aux value (FLIP_BIT1[a] | FLIP_BIT2[b] | FLIP_BIT3[c]) -> (a, b, c)
+// FLIP_BIT1 is its own inverse, so each 2-bit group is just swapped back
+static constexpr NICAuxUnpackTable buildNICAuxUnpackTable() {
+    NICAuxUnpackTable table = {};
+    for (int x = 0; x < 64; x++) {
+        table.v[x].a = FLIP_BIT1[x & 3];
+        table.v[x].b = FLIP_BIT1[(x >> 2) & 3];
+        table.v[x].c = FLIP_BIT1[(x >> 4) & 3];
+    }
+    return table;
+}
+
+static constexpr NICByteTable NIC_DECODE = buildNICDecodeTable();
+static constexpr NICByteTable NIC_LOW2 = buildNICLow2Table();
+static constexpr NICAuxUnpackTable NIC_AUX_UNPACK = buildNICAuxUnpackTable();
+
+static constexpr const uint8_t* NIC_DECODE_TABLE = NIC_DECODE.v;
+static_assert(NIC_DECODE.v[0x96] == 0 && NIC_DECODE.v[0xFF] == 63 && NIC_DECODE.v[0xAA] == 0xFF, "NIC decode table");
+static_assert(NIC_AUX_UNPACK.v[FLIP_BIT1[1] | FLIP_BIT2[2] | FLIP_BIT3[3]].a == 1 &&
+              NIC_AUX_UNPACK.v[FLIP_BIT1[1] | FLIP_BIT2[2] | FLIP_BIT3[3]].b == 2 &&
+              NIC_AUX_UNPACK.v[FLIP_BIT1[1] | FLIP_BIT2[2] | FLIP_BIT3[3]].c == 3, "NIC aux unpack table");
+
+// Encode 256 data bytes into a 343-byte NIC data field (86 aux + 256 + checksum)
+void encodeNICDataField(const uint8_t* src, uint8_t* gcr) {
+    uint8_t ox = 0;
+    
+    // First 86 bytes: low 2 bits of src[i], src[i + 86], src[i + 172] (bytes 256/257 are zero)
+    for (int i = 0; i < 84; i++) {
+        uint8_t x = NIC_LOW2.v[src[i]] | (NIC_LOW2.v[src[i + 86]] << 2) | (NIC_LOW2.v[src[i + 172]] << 4);
+        *gcr++ = NIC_ENCODE_TABLE[x ^ ox];
+        ox = x;
+    }
+    for (int i = 84; i < 86; i++) {
+        uint8_t x = NIC_LOW2.v[src[i]] | (NIC_LOW2.v[src[i + 86]] << 2);
+        *gcr++ = NIC_ENCODE_TABLE[x ^ ox];
+        ox = x;
+    }
+    
+    // All 256 bytes (standard encoding: src[i] >> 2)
+    for (int i = 0; i < 256; i++) {
+        uint8_t x = src[i] >> 2;
+        *gcr++ = NIC_ENCODE_TABLE[x ^ ox];
+        ox = x;
+    }
+    
+    // Last byte (checksum)
+    *gcr = NIC_ENCODE_TABLE[ox];
+}
+
+// Decode NIC-encoded data field to raw sector data
+// The 86 aux values are unpacked through the compile-time NIC_AUX_UNPACK table and the upper 6 bits
+// are written directly (no 343-byte temp buffer) - tests/NICCodecTest.cpp compares it with the
+// original branch-based decoder
+void decodeNICDataField(const uint8_t* gcrData, uint16_t gcrLength, uint8_t* decodedData, uint16_t* decodedLength) {
+    // Need at least: 86 (first encoding) + 256 (standard encoding) + 1 (last byte) = 343 bytes
+    if (gcrLength < 343) {
+        *decodedLength = 0;
+        return;
+    }
+    
+    uint8_t ox = 0;  // Previous XOR state (starts at 0)
+    uint8_t aux[86];  // FlipBit values: FLIP_BIT1[src[i] & 3] | FLIP_BIT2[src[i + 86] & 3] | FLIP_BIT3[src[i + 172] & 3]
+    
+    // Step 1: XOR decode all GCR bytes to 6-bit values
+    // raw = NIC_DECODE_TABLE[encoded] = (x ^ prev_ox), x = raw ^ prev_ox, ox = x
+    for (uint16_t i = 0; i < 343; i++) {
+        uint8_t encoded = gcrData[i];
+        uint8_t raw = NIC_DECODE_TABLE[encoded];
+        if (raw == 0xFF) {
+            // Invalid GCR code - print diagnostic info
+            printf("ERROR: Invalid GCR code 0x%02X at position %u (gcrData[%u])\r\n", encoded, i, i);
+            *decodedLength = 0;
+            return;
+        }
+        ox ^= raw;
+        
+        if (i < 86) {
+            aux[i] = ox;
+        } else if (i < 86 + 256) {
+            decodedData[i - 86] = ox << 2;  // Upper 6 bits (src[i] >> 2)
+        }
+    }
+    
+    // Step 2: Lower 2 bits of bytes 0-85, 86-171, 172-255 from the 86 aux values
+    // (aux 84/85 would carry bytes 256/257 in the third group - always zero)
+    for (uint16_t i = 0; i < 84; i++) {
+        const NICAuxUnpack& unpack = NIC_AUX_UNPACK.v[aux[i]];
+        decodedData[i] |= unpack.a;
+        decodedData[i + 86] |= unpack.b;
+        decodedData[i + 172] |= unpack.c;
+    }
+    for (uint16_t i = 84; i < 86; i++) {
+        const NICAuxUnpack& unpack = NIC_AUX_UNPACK.v[aux[i]];
+        decodedData[i] |= unpack.a;
+        decodedData[i + 86] |= unpack.b;
+    }
+    
+    *decodedLength = 256;
+}
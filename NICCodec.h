@@ -0,0 +1,20 @@
+#ifndef NIC_CODEC_H
+#define NIC_CODEC_H
+
+#include <stdint.h>
+
+// Apple II 6-and-2 data field codec (.nic / GCR track data)
+// A 256-byte sector becomes a 343-byte data field: 86 aux bytes (low 2 bits of three source
+// bytes each, FlipBit order), 256 bytes of upper 6 bits and a checksum byte - every value
+// XORed with the previous one and mapped through the 64-entry disk byte table.
+// Table-driven (compile-time tables) - no hardware dependency, also built by the host tests.
+
+#define NIC_DATA_FIELD_SIZE 343     // 86 aux + 256 + checksum
+
+// Encode 256 data bytes into a NIC_DATA_FIELD_SIZE-byte data field
+void encodeNICDataField(const uint8_t* src, uint8_t* gcr);
+
+// Decode a data field back to 256 bytes (*decodedLength = 256, 0 for a short field or an invalid disk byte)
+void decodeNICDataField(const uint8_t* gcrData, uint16_t gcrLength, uint8_t* decodedData, uint16_t* decodedLength);
+
+#endif // NIC_CODEC_H
@@ -0,0 +1,390 @@
+#include "SDAsyncEngine.h"
+#include "SDProtocol.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+#include <stdio.h>
+#include <string.h>
+
+SDAsyncEngine::SDAsyncEngine(SDAsyncBus* sdBus) {
+    bus = sdBus;
+    critical_section_init(&lock);
+    memset(queue, 0, sizeof(queue));
+    head = 0;
+    tail = 0;
+    nextId = 1;
+    state = STATE_IDLE;
+    pollCore = -1;
+    waitBytes = 0;
+    multiBlock = false;
+    failed = false;
+    inPoll = false;
+    memset(&stats, 0, sizeof(stats));
+}
+
+void SDAsyncEngine::resetStats() {
+    memset(&stats, 0, sizeof(stats));
+}
+
+// Queue one request (shared by the three submit functions)
+uint32_t SDAsyncEngine::submit(SDAsyncOp op, uint32_t blockAddress, uint8_t* buffer, uint32_t count,
+                               SDAsyncCallback callback, void* context) {
+    critical_section_enter_blocking(&lock);
+    if (head - tail >= SD_ASYNC_QUEUE_DEPTH) {
+        stats.rejected++;
+        critical_section_exit(&lock);
+        return 0;
+    }
+
+    SDAsyncRequest* request = &queue[head % SD_ASYNC_QUEUE_DEPTH];
+    uint32_t id = nextId++;
+    if (nextId == 0) {
+        nextId = 1;  // 0 = invalid id
+    }
+    request->id = id;
+    request->op = op;
+    request->status = SD_ASYNC_QUEUED;
+    request->blockAddress = blockAddress;
+    request->buffer = buffer;
+    request->count = count;
+    request->blocksDone = 0;
+    request->callback = callback;
+    request->context = context;
+    request->cancelRequested = false;
+
+    head = head + 1;  // Publish (poll() only looks at slots below head)
+    stats.submitted++;
+    critical_section_exit(&lock);
+    return id;
+}
+
+uint32_t SDAsyncEngine::submitRead(uint32_t blockAddress, uint8_t* buffer, uint32_t count,
+                                   SDAsyncCallback callback, void* context) {
+    if (buffer == nullptr || count == 0) {
+        return 0;
+    }
+    return submit(SD_ASYNC_OP_READ, blockAddress, buffer, count, callback, context);
+}
+
+uint32_t SDAsyncEngine::submitWrite(uint32_t blockAddress, const uint8_t* buffer, uint32_t count,
+                                    SDAsyncCallback callback, void* context) {
+    if (buffer == nullptr || count == 0) {
+        return 0;
+    }
+    // Buffer is only read - stored non-const in the shared request structure
+    return submit(SD_ASYNC_OP_WRITE, blockAddress, (uint8_t*)buffer, count, callback, context);
+}
+
+uint32_t SDAsyncEngine::submitFlush(SDAsyncCallback callback, void* context) {
+    return submit(SD_ASYNC_OP_FLUSH, 0, nullptr, 0, callback, context);
+}
+
+bool SDAsyncEngine::cancel(uint32_t id) {
+    bool found = false;
+    critical_section_enter_blocking(&lock);
+    for (uint32_t i = tail; i != head; i++) {
+        SDAsyncRequest* request = &queue[i % SD_ASYNC_QUEUE_DEPTH];
+        if (request->id == id) {
+            request->cancelRequested = true;
+            found = true;
+            break;
+        }
+    }
+    critical_section_exit(&lock);
+    return found;
+}
+
+uint32_t SDAsyncEngine::getBlocksDone(uint32_t id) {
+    uint32_t blocksDone = 0;
+    critical_section_enter_blocking(&lock);
+    for (uint32_t i = tail; i != head; i++) {
+        SDAsyncRequest* request = &queue[i % SD_ASYNC_QUEUE_DEPTH];
+        if (request->id == id) {
+            blocksDone = request->blocksDone;
+            break;
+        }
+    }
+    critical_section_exit(&lock);
+    return blocksDone;
+}
+
+void SDAsyncEngine::cancelAll() {
+    critical_section_enter_blocking(&lock);
+    for (uint32_t i = tail; i != head; i++) {
+        queue[i % SD_ASYNC_QUEUE_DEPTH].cancelRequested = true;
+    }
+    critical_section_exit(&lock);
+}
+
+// Report the request and free its slot
+void SDAsyncEngine::finishRequest(SDAsyncRequest* request, SDAsyncStatus status) {
+    if (request->status == SD_ASYNC_ACTIVE) {
+        bus->busSelect(false);  // Only started requests selected the card
+    }
+    state = STATE_IDLE;
+
+    request->status = status;
+    stats.completed++;
+    if (status == SD_ASYNC_ERROR) {
+        stats.errors++;
+    } else if (status == SD_ASYNC_CANCELLED) {
+        stats.cancelled++;
+    }
+
+    if (request->callback) {
+        request->callback(request, request->context);
+    }
+
+    critical_section_enter_blocking(&lock);
+    tail = tail + 1;  // Slot may be reused by submit()
+    critical_section_exit(&lock);
+}
+
+// Select the card and send the command(s) for a new request
+bool SDAsyncEngine::startRequest(SDAsyncRequest* request) {
+    if (!bus->busReady()) {
+        finishRequest(request, SD_ASYNC_ERROR);
+        return false;
+    }
+
+    request->status = SD_ASYNC_ACTIVE;
+    failed = false;
+    waitBytes = 0;
+    multiBlock = request->count > 1;
+    bus->busSelect(true);
+
+    if (request->op == SD_ASYNC_OP_FLUSH) {
+        state = STATE_FLUSH_BUSY;
+        return true;
+    }
+
+    uint8_t response;
+    if (request->op == SD_ASYNC_OP_READ) {
+        response = bus->busCommand(multiBlock ? SD_CMD18 : SD_CMD17, request->blockAddress);
+        state = STATE_READ_TOKEN;
+    } else {
+        if (multiBlock) {
+            // Pre-erase hint - a rejected ACMD23 is ignored (same as writeBlocks())
+            bus->busCommand(SD_CMD55, 0);
+            bus->busCommand(SD_ACMD23, request->count & 0x7FFFFF);
+        }
+        response = bus->busCommand(multiBlock ? SD_CMD25 : SD_CMD24, request->blockAddress);
+        state = STATE_WRITE_TOKEN;
+    }
+
+    if (response != 0) {
+        finishRequest(request, SD_ASYNC_ERROR);
+        return false;
+    }
+    return true;
+}
+
+// End the transfer on the bus: CMD12 for a read stream, stop token for a write stream
+// Single-block transfers have nothing to stop - the request finishes right away.
+void SDAsyncEngine::stopTransfer(SDAsyncRequest* request) {
+    waitBytes = 0;
+    if (multiBlock && request->op == SD_ASYNC_OP_READ) {
+        // busCommand() discards the stuff byte after CMD12 - the R1 is real, so the
+        // R1b busy starts right after it and STATE_STOP_BUSY sees it
+        if (bus->busCommand(SD_CMD12, 0) & 0x80) {
+            failed = true;  // No R1 - card state unknown
+        }
+        state = STATE_STOP_BUSY;
+        return;
+    }
+    if (multiBlock && request->op == SD_ASYNC_OP_WRITE) {
+        bus->busExchange(SD_TOKEN_STOP_TRAN);
+        bus->busExchange(0xFF);  // One byte before busy starts
+        state = STATE_STOP_BUSY;
+        return;
+    }
+
+    SDAsyncStatus status = SD_ASYNC_DONE;
+    if (failed) {
+        status = SD_ASYNC_ERROR;
+    } else if (request->blocksDone < request->count) {
+        status = SD_ASYNC_CANCELLED;
+    }
+    finishRequest(request, status);
+}
+
+// Poll a few bytes for the end of busy; true = released (or timed out - failed is set)
+bool SDAsyncEngine::pollBusy() {
+    for (int i = 0; i < SD_ASYNC_POLL_BYTES; i++) {
+        if (bus->busExchange(0xFF) == 0xFF) {
+            return true;
+        }
+        if (++waitBytes >= SD_ASYNC_BUSY_TIMEOUT) {
+            failed = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SDAsyncEngine::isPollCore() const {
+    return pollCore < 0 || (int)get_core_num() == pollCore;
+}
+
+bool SDAsyncEngine::poll() {
+    if (!isPollCore()) {
+        return head != tail;  // Bus state belongs to the poll core
+    }
+    if (inPoll || head == tail) {
+        return head != tail;
+    }
+    inPoll = true;
+    stats.polls++;
+
+    SDAsyncRequest* request = &queue[tail % SD_ASYNC_QUEUE_DEPTH];
+
+    switch (state) {
+        case STATE_IDLE:
+            if (request->cancelRequested) {
+                finishRequest(request, SD_ASYNC_CANCELLED);
+            } else {
+                startRequest(request);
+            }
+            break;
+
+        case STATE_READ_TOKEN:
+            for (int i = 0; i < SD_ASYNC_POLL_BYTES; i++) {
+                uint8_t token = bus->busExchange(0xFF);
+                if (token == SD_TOKEN_START_BLOCK) {
+                    bus->busStartRead(request->buffer + request->blocksDone * SD_BLOCK_SIZE, SD_BLOCK_SIZE);
+                    state = STATE_READ_DATA;
+                    break;
+                }
+                if ((token != 0xFF && token != 0x00) || ++waitBytes >= SD_ASYNC_TOKEN_TIMEOUT) {
+                    failed = true;  // Error token or no token
+                    stopTransfer(request);
+                    break;
+                }
+            }
+            break;
+
+        case STATE_READ_DATA:
+            if (!bus->busTransferDone()) {
+                break;
+            }
+            bus->busExchange(0xFF);  // CRC (2 bytes) - ignore
+            bus->busExchange(0xFF);
+            request->blocksDone++;
+            waitBytes = 0;
+            if (request->blocksDone == request->count || request->cancelRequested) {
+                stopTransfer(request);
+            } else {
+                state = STATE_READ_TOKEN;
+            }
+            break;
+
+        case STATE_WRITE_TOKEN:
+            bus->busExchange(multiBlock ? SD_TOKEN_MULTI_WRITE : SD_TOKEN_SINGLE_WRITE);
+            bus->busStartWrite(request->buffer + request->blocksDone * SD_BLOCK_SIZE, SD_BLOCK_SIZE);
+            state = STATE_WRITE_DATA;
+            break;
+
+        case STATE_WRITE_DATA:
+            if (!bus->busTransferDone()) {
+                break;
+            }
+            bus->busExchange(0xFF);  // Dummy CRC
+            bus->busExchange(0xFF);
+            waitBytes = 0;
+            state = STATE_WRITE_RESPONSE;
+            break;
+
+        case STATE_WRITE_RESPONSE:
+            for (int i = 0; i < SD_ASYNC_POLL_BYTES; i++) {
+                uint8_t response = bus->busExchange(0xFF);
+                if ((response & 0x1F) == 0x05) {  // Data accepted
+                    waitBytes = 0;
+                    state = STATE_WRITE_BUSY;
+                    break;
+                }
+                // Data response token xxx0sss1 other than "accepted" = CRC / write error
+                if ((response != 0xFF && (response & 0x11) == 0x01) || ++waitBytes >= SD_ASYNC_RESPONSE_TIMEOUT) {
+                    failed = true;
+                    stopTransfer(request);
+                    break;
+                }
+            }
+            break;
+
+        case STATE_WRITE_BUSY:
+            if (!pollBusy()) {
+                break;
+            }
+            if (!failed) {
+                request->blocksDone++;
+            }
+            if (failed || request->blocksDone == request->count || request->cancelRequested) {
+                stopTransfer(request);
+            } else {
+                state = STATE_WRITE_TOKEN;
+            }
+            break;
+
+        case STATE_STOP_BUSY:
+            if (pollBusy()) {
+                SDAsyncStatus status = SD_ASYNC_DONE;
+                if (failed) {
+                    status = SD_ASYNC_ERROR;
+                } else if (request->blocksDone < request->count) {
+                    status = SD_ASYNC_CANCELLED;
+                }
+                finishRequest(request, status);
+            }
+            break;
+
+        case STATE_FLUSH_BUSY:
+            if (pollBusy()) {
+                finishRequest(request, failed ? SD_ASYNC_ERROR : SD_ASYNC_DONE);
+            }
+            break;
+    }
+
+    inPoll = false;
+    return head != tail;
+}
+
+bool SDAsyncEngine::finishBusRequest() {
+    if (!isPollCore()) {
+        // The poll core finishes the request - only wait for the bus to be released
+        uint32_t start = time_us_32();
+        while (state != STATE_IDLE) {
+            if (time_us_32() - start >= SD_ASYNC_WAIT_TIMEOUT_US) {
+                return false;
+            }
+            tight_loop_contents();
+        }
+        return true;
+    }
+    if (inPoll) {
+        return true;  // Called from a completion callback - the bus is already free
+    }
+    while (state != STATE_IDLE) {
+        poll();
+    }
+    return true;
+}
+
+bool SDAsyncEngine::drain() {
+    cancelAll();
+    if (!isPollCore()) {
+        // Cancelled requests complete on the poll core (the one on the bus stops cleanly there)
+        uint32_t start = time_us_32();
+        while (head != tail) {
+            if (time_us_32() - start >= SD_ASYNC_WAIT_TIMEOUT_US) {
+                return false;
+            }
+            tight_loop_contents();
+        }
+        return true;
+    }
+    if (inPoll) {
+        return false;  // Completion callback - the request on the bus is still in the queue
+    }
+    while (poll()) {
+    }
+    return true;
+}
@@ -0,0 +1,163 @@
+#ifndef SD_ASYNC_ENGINE_H
+#define SD_ASYNC_ENGINE_H
+
+#include "pico/critical_section.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+// Non-blocking SD block engine
+// Read / write / flush requests are queued and advanced by poll() - every call does a
+// bounded amount of SPI work (a command, a few polled bytes, or checking a DMA transfer)
+// and returns, instead of spinning in the token / busy wait loops of the blocking API.
+// A finished request reports through its completion callback (called from poll()).
+//
+// submit() and cancel() may be called from either core; poll() runs on one core only
+// (core1 - see setPollCore()). poll() on any other core does nothing, finishBusRequest()
+// and drain() there wait for the poll core instead of driving the bus themselves.
+
+#define SD_ASYNC_QUEUE_DEPTH        8       // Requests waiting or in flight
+#define SD_ASYNC_POLL_BYTES         16      // Max bytes polled per poll() call while waiting on the card
+#define SD_ASYNC_TOKEN_TIMEOUT      5000    // Bytes to wait for a read data token (same as readBlock())
+#define SD_ASYNC_RESPONSE_TIMEOUT   100     // Bytes to wait for a write data response
+#define SD_ASYNC_BUSY_TIMEOUT       50000   // Bytes to wait while the card programs (SD_WRITE_BUSY_TIMEOUT)
+#define SD_ASYNC_WAIT_TIMEOUT_US    500000  // Max wait of another core for the poll core (finishBusRequest() / drain())
+
+// Request type
+typedef enum {
+    SD_ASYNC_OP_READ = 0,      // Read count blocks (CMD17 / CMD18)
+    SD_ASYNC_OP_WRITE = 1,     // Write count blocks (CMD24 / ACMD23 + CMD25)
+    SD_ASYNC_OP_FLUSH = 2      // Barrier: completes once all earlier requests are done and the card is idle
+} SDAsyncOp;
+
+// Request status (reported to the callback)
+typedef enum {
+    SD_ASYNC_QUEUED = 0,
+    SD_ASYNC_ACTIVE = 1,
+    SD_ASYNC_DONE = 2,
+    SD_ASYNC_ERROR = 3,
+    SD_ASYNC_CANCELLED = 4
+} SDAsyncStatus;
+
+struct SDAsyncRequest;
+
+// Completion callback - called once per request from poll() (card is deselected at that point,
+// so the callback may submit new requests or use the blocking API)
+typedef void (*SDAsyncCallback)(const SDAsyncRequest* request, void* context);
+
+typedef struct SDAsyncRequest {
+    uint32_t id;                // Returned by submit() (0 = invalid)
+    SDAsyncOp op;
+    volatile SDAsyncStatus status;
+    uint32_t blockAddress;
+    uint8_t* buffer;            // Read: destination, write: source (count * 512 bytes)
+    uint32_t count;
+    uint32_t blocksDone;        // Blocks transferred (also valid for ERROR / CANCELLED)
+    SDAsyncCallback callback;
+    void* context;
+    volatile bool cancelRequested;
+} SDAsyncRequest;
+
+// Engine counters (see 'sdasync' CLI command)
+typedef struct {
+    uint32_t submitted;
+    uint32_t completed;
+    uint32_t errors;
+    uint32_t cancelled;
+    uint32_t rejected;          // submit() with a full queue
+    uint32_t polls;             // poll() calls that did bus work
+} SDAsyncStats;
+
+// Bus the engine drives: every call must return after a bounded amount of work
+// Implemented by SDCardManager (real card) and SDMockCard (in-memory card, tests/)
+class SDAsyncBus {
+public:
+    virtual ~SDAsyncBus() {}
+    virtual bool busReady() = 0;                                   // Card initialized
+    virtual void busSelect(bool select) = 0;                       // CS low / high
+    virtual uint8_t busCommand(uint8_t cmd, uint32_t arg) = 0;     // Send command, return R1 (0xFF = none, CMD12: after the stuff byte)
+    virtual uint8_t busExchange(uint8_t out) = 0;                  // Clock one byte
+    virtual void busStartRead(uint8_t* buffer, uint32_t length) = 0;
+    virtual void busStartWrite(const uint8_t* buffer, uint32_t length) = 0;
+    virtual bool busTransferDone() = 0;
+};
+
+class SDAsyncEngine {
+private:
+    // Per-request bus state (only the request at the queue tail is on the bus)
+    typedef enum {
+        STATE_IDLE = 0,
+        STATE_READ_TOKEN,          // Waiting for 0xFE in front of the next block
+        STATE_READ_DATA,           // DMA transfer of the block running
+        STATE_WRITE_TOKEN,         // Send data token and start DMA for the next block
+        STATE_WRITE_DATA,          // DMA transfer of the block running
+        STATE_WRITE_RESPONSE,      // Waiting for the data response token
+        STATE_WRITE_BUSY,          // Card programming the block
+        STATE_STOP_BUSY,           // Card busy after CMD12 / stop token
+        STATE_FLUSH_BUSY           // Flush: waiting for the card to release MISO
+    } BusState;
+
+    SDAsyncBus* bus;
+    critical_section_t lock;       // Guards queue indices and request status against the other core
+
+    SDAsyncRequest queue[SD_ASYNC_QUEUE_DEPTH];
+    volatile uint32_t head;        // Next free slot (free running)
+    volatile uint32_t tail;        // Oldest request (free running) - the one on the bus
+    uint32_t nextId;
+
+    volatile BusState state;       // Read by the other core in finishBusRequest()
+    int pollCore;                  // Core allowed to run poll() (-1 = any, single core use)
+    uint32_t waitBytes;            // Bytes polled in the current wait
+    bool multiBlock;               // CMD18 / CMD25 transfer (needs CMD12 / stop token)
+    bool failed;                   // Current request hit an error (finish after stop)
+    bool inPoll;                   // Re-entrance guard (callbacks may call blocking API -> drain)
+
+    SDAsyncStats stats;
+
+    uint32_t submit(SDAsyncOp op, uint32_t blockAddress, uint8_t* buffer, uint32_t count,
+                    SDAsyncCallback callback, void* context);
+    bool startRequest(SDAsyncRequest* request);
+    void stopTransfer(SDAsyncRequest* request);
+    void finishRequest(SDAsyncRequest* request, SDAsyncStatus status);
+    bool pollBusy();               // true = card released MISO (or timeout -> failed)
+    bool isPollCore() const;
+
+public:
+    SDAsyncEngine(SDAsyncBus* bus);
+
+    // Queue a request - returns its id, 0 if the queue is full or the arguments are invalid
+    uint32_t submitRead(uint32_t blockAddress, uint8_t* buffer, uint32_t count,
+                        SDAsyncCallback callback = nullptr, void* context = nullptr);
+    uint32_t submitWrite(uint32_t blockAddress, const uint8_t* buffer, uint32_t count,
+                         SDAsyncCallback callback = nullptr, void* context = nullptr);
+    uint32_t submitFlush(SDAsyncCallback callback = nullptr, void* context = nullptr);
+
+    // Cancel a request: a queued one completes as CANCELLED without touching the card,
+    // the one on the bus stops at the next block boundary (CMD12 / stop token)
+    bool cancel(uint32_t id);
+    void cancelAll();
+
+    // Blocks transferred so far by a queued or active request (0 once it completed)
+    uint32_t getBlocksDone(uint32_t id);
+
+    // Core that runs poll() - set once by that core before its first poll()
+    void setPollCore(int core) { pollCore = core; }
+
+    // Advance the request on the bus; returns true while requests are pending
+    bool poll();
+
+    // Run poll() until the request on the bus is finished (blocking API calls this first)
+    // On another core: wait until the poll core has finished it. false = timed out
+    bool finishBusRequest();
+
+    // Cancel everything and wait until the queue is empty (card removed / deinit)
+    // Safe from either core. false = timed out (poll core not polling)
+    bool drain();
+
+    bool isIdle() const { return head == tail; }
+    bool isBusActive() const { return state != STATE_IDLE; }
+    uint32_t getPending() const { return head - tail; }
+    void getStats(SDAsyncStats* out) const { *out = stats; }
+    void resetStats();
+};
+
+#endif // SD_ASYNC_ENGINE_H
@@ -5,7 +5,8 @@
 #include <string.h>
 
 // Constructor
-SDCardManager::SDCardManager(spi_inst_t* spi, uint8_t cs, uint8_t mosi, uint8_t miso, uint8_t sck, uint8_t detect) {
+SDCardManager::SDCardManager(spi_inst_t* spi, uint8_t cs, uint8_t mosi, uint8_t miso, uint8_t sck, uint8_t detect)
+    : asyncEngine(this) {
     spiInstance = spi;
     csPin = cs;
     mosiPin = mosi;
@@ -17,6 +18,8 @@ SDCardManager::SDCardManager(spi_inst_t* spi, uint8_t cs, uint8_t mosi, uint8_t
     fat32 = nullptr;
     currentBaudrate = 0;
     lastFAT32Error = FAT32_OK;
+    spiDmaTx = -1;
+    spiDmaRx = -1;
     
     // Initialize card detect pin if provided
     if (detectPin != 0xFF) {
@@ -55,6 +58,9 @@ bool SDCardManager::init(uint32_t maxBaudrate, bool verbose) {
     gpio_set_function(misoPin, GPIO_FUNC_SPI);
     gpio_set_function(sckPin, GPIO_FUNC_SPI);
     
+    // Block data is moved by DMA (channels are kept across re-init)
+    initSpiDma();
+    
     // Initialize CS pin
     gpio_init(csPin);
     gpio_set_dir(csPin, GPIO_OUT);
@@ -396,6 +402,12 @@ bool SDCardManager::isInitialized() const {
 
 void SDCardManager::deinit() {
     if (initialized) {
+        // Queued requests complete as CANCELLED, the one on the bus is stopped cleanly
+        // (by core1 when called from the main loop on core0 - the engine's poll core)
+        if (!asyncEngine.drain()) {
+            printf("SD: async requests not drained - poll core busy\r\n");
+        }
+        
         // Clean up FAT32
         if (fat32) {
             delete fat32;
@@ -485,6 +497,13 @@ uint8_t SDCardManager::sendCommand(uint8_t cmd, uint32_t arg) {
     // Send command
     spi_write_blocking(spiInstance, command, 6);
     
+    // CMD12: the byte clocked right after the command is the stuff byte - usually a data byte
+    // of the aborted block that can look like R1 (MSB 0), so it is discarded before polling
+    if (cmd == SD_CMD12) {
+        uint8_t stuff;
+        spi_read_blocking(spiInstance, 0xFF, &stuff, 1);
+    }
+    
     // Wait for response (R1 format)
     // Response starts with 0 bit, so we wait until MSB is 0
     uint8_t response = 0xFF;
@@ -510,6 +529,7 @@ bool SDCardManager::readBlock(uint32_t blockAddress, uint8_t* buffer) {
         return false;
     }
     
+    asyncEngine.finishBusRequest();  // Card may be mid-transfer for a queued request
     selectCard();
     
     // Send CMD17 (read single block)
@@ -523,7 +543,7 @@ bool SDCardManager::readBlock(uint32_t blockAddress, uint8_t* buffer) {
     uint8_t token = 0xFF;
     for (int i = 0; i < 5000; i++) {
         spi_read_blocking(spiInstance, 0xFF, &token, 1);
-        if (token == 0xFE) {
+        if (token == SD_TOKEN_START_BLOCK) {
             break;
         }
         if (token != 0xFF && token != 0x00) {
@@ -531,13 +551,13 @@ bool SDCardManager::readBlock(uint32_t blockAddress, uint8_t* buffer) {
         }
     }
     
-    if (token != 0xFE) {
+    if (token != SD_TOKEN_START_BLOCK) {
         deselectCard();
         return false;
     }
     
     // Read 512 bytes
-    spi_read_blocking(spiInstance, 0xFF, buffer, SD_BLOCK_SIZE);
+    readData(buffer, SD_BLOCK_SIZE);
     
     // Read CRC (2 bytes) - ignore
     uint8_t crc[2];
@@ -547,12 +567,74 @@ bool SDCardManager::readBlock(uint32_t blockAddress, uint8_t* buffer) {
     return true;
 }
 
+// Read consecutive blocks in one CMD18 transfer
+// One command round trip for the whole run instead of one CMD17 per block;
+// the card streams the blocks back to back, each behind its own data token.
+bool SDCardManager::readBlocks(uint32_t blockAddress, uint8_t* buffer, uint32_t count) {
+    if (!initialized || buffer == nullptr || count == 0) {
+        return false;
+    }
+    if (count == 1) {
+        return readBlock(blockAddress, buffer);
+    }
+    
+    asyncEngine.finishBusRequest();
+    selectCard();
+    
+    // Send CMD18 (read multiple blocks)
+    uint8_t response = sendCommand(SD_CMD18, blockAddress);
+    if (response != 0) {
+        deselectCard();
+        return false;
+    }
+    
+    bool success = true;
+    for (uint32_t block = 0; block < count; block++) {
+        // Wait for data token (0xFE)
+        uint8_t token = 0xFF;
+        for (int i = 0; i < 5000; i++) {
+            spi_read_blocking(spiInstance, 0xFF, &token, 1);
+            if (token == SD_TOKEN_START_BLOCK) {
+                break;
+            }
+            if (token != 0xFF && token != 0x00) {
+                break;
+            }
+        }
+        
+        if (token != SD_TOKEN_START_BLOCK) {
+            success = false;
+            break;
+        }
+        
+        // Read 512 bytes
+        readData(buffer + block * SD_BLOCK_SIZE, SD_BLOCK_SIZE);
+        
+        // Read CRC (2 bytes) - ignore
+        uint8_t crc[2];
+        spi_read_blocking(spiInstance, 0xFF, crc, 2);
+    }
+    
+    // CMD12 ends the stream: sendCommand() discards the stuff byte and returns the real R1,
+    // then the card holds MISO low (R1b busy) until it is ready - CS stays low until then
+    if (sendCommand(SD_CMD12, 0) & 0x80) {
+        success = false;  // No R1 - card state unknown
+    }
+    if (!waitWhileBusy(SD_WRITE_BUSY_TIMEOUT)) {
+        success = false;
+    }
+    
+    deselectCard();
+    return success;
+}
+
 // Write a single block (512 bytes)
 bool SDCardManager::writeBlock(uint32_t blockAddress, const uint8_t* buffer) {
     if (!initialized || buffer == nullptr) {
         return false;
     }
     
+    asyncEngine.finishBusRequest();
     selectCard();
     
     // Send CMD24 (write single block)
@@ -563,11 +645,11 @@ bool SDCardManager::writeBlock(uint32_t blockAddress, const uint8_t* buffer) {
     }
     
     // Send data token
-    uint8_t token = 0xFE;
+    uint8_t token = SD_TOKEN_SINGLE_WRITE;
     spi_write_blocking(spiInstance, &token, 1);
     
     // Write 512 bytes
-    spi_write_blocking(spiInstance, buffer, SD_BLOCK_SIZE);
+    writeData(buffer, SD_BLOCK_SIZE);
     
     // Send dummy CRC
     uint8_t crc[2] = {0xFF, 0xFF};
@@ -595,6 +677,225 @@ bool SDCardManager::writeBlock(uint32_t blockAddress, const uint8_t* buffer) {
     return ((writeResponse & 0x1F) == 0x05);
 }
 
+// Claim two DMA channels for block data (once - kept for the lifetime of the manager)
+// If none are free, block data keeps using spi_read/write_blocking()
+void SDCardManager::initSpiDma() {
+    if (spiDmaTx >= 0) {
+        return;
+    }
+    
+    int tx = dma_claim_unused_channel(false);
+    int rx = dma_claim_unused_channel(false);
+    if (tx < 0 || rx < 0) {
+        if (tx >= 0) dma_channel_unclaim(tx);
+        if (rx >= 0) dma_channel_unclaim(rx);
+        printf("SD: no free DMA channels - using blocking SPI\r\n");
+        return;
+    }
+    spiDmaTx = tx;
+    spiDmaRx = rx;
+}
+
+// Source of the 0xFF bytes clocked out while reading / sink for bytes received while writing
+static const uint8_t g_spiFillByte = 0xFF;
+static uint8_t g_spiDiscardByte;
+
+// Start a DMA read: TX channel repeats 0xFF, RX channel stores the received bytes
+// Both channels are paced by the SPI DREQs, so the bus runs back to back at the SPI clock
+void SDCardManager::startReadTransfer(uint8_t* buffer, uint32_t length) {
+    spi_hw_t* hw = spi_get_hw(spiInstance);
+    
+    dma_channel_config c = dma_channel_get_default_config(spiDmaTx);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, spi_get_dreq(spiInstance, true));
+    dma_channel_configure(spiDmaTx, &c, &hw->dr, &g_spiFillByte, length, false);
+    
+    c = dma_channel_get_default_config(spiDmaRx);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, true);
+    channel_config_set_dreq(&c, spi_get_dreq(spiInstance, false));
+    dma_channel_configure(spiDmaRx, &c, buffer, &hw->dr, length, false);
+    
+    dma_start_channel_mask((1u << spiDmaTx) | (1u << spiDmaRx));
+}
+
+// Start a DMA write: TX channel sends the buffer, RX channel drains the FIFO into a dummy byte
+// (RX must be drained, otherwise the SPI stalls once the RX FIFO is full)
+void SDCardManager::startWriteTransfer(const uint8_t* buffer, uint32_t length) {
+    spi_hw_t* hw = spi_get_hw(spiInstance);
+    
+    dma_channel_config c = dma_channel_get_default_config(spiDmaTx);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, spi_get_dreq(spiInstance, true));
+    dma_channel_configure(spiDmaTx, &c, &hw->dr, buffer, length, false);
+    
+    c = dma_channel_get_default_config(spiDmaRx);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, spi_get_dreq(spiInstance, false));
+    dma_channel_configure(spiDmaRx, &c, &g_spiDiscardByte, &hw->dr, length, false);
+    
+    dma_start_channel_mask((1u << spiDmaTx) | (1u << spiDmaRx));
+}
+
+// RX finishes last - when it is done, every byte has been clocked on the bus
+bool SDCardManager::isTransferDone() const {
+    return spiDmaRx < 0 || !dma_channel_is_busy(spiDmaRx);
+}
+
+void SDCardManager::waitTransfer() {
+    while (!isTransferDone()) {
+        tight_loop_contents();
+    }
+}
+
+// Move block data (512 bytes etc.) - DMA when available
+void SDCardManager::readData(uint8_t* buffer, uint32_t length) {
+    if (spiDmaRx < 0) {
+        spi_read_blocking(spiInstance, 0xFF, buffer, length);
+        return;
+    }
+    startReadTransfer(buffer, length);
+    waitTransfer();
+}
+
+void SDCardManager::writeData(const uint8_t* buffer, uint32_t length) {
+    if (spiDmaTx < 0) {
+        spi_write_blocking(spiInstance, buffer, length);
+        return;
+    }
+    startWriteTransfer(buffer, length);
+    waitTransfer();
+}
+
+// SDAsyncBus - the async engine's view of the card
+bool SDCardManager::busReady() {
+    return initialized;
+}
+
+void SDCardManager::busSelect(bool select) {
+    if (select) {
+        selectCard();
+    } else {
+        deselectCard();
+    }
+}
+
+uint8_t SDCardManager::busCommand(uint8_t cmd, uint32_t arg) {
+    return sendCommand(cmd, arg);
+}
+
+uint8_t SDCardManager::busExchange(uint8_t out) {
+    uint8_t in = 0xFF;
+    spi_write_read_blocking(spiInstance, &out, &in, 1);
+    return in;
+}
+
+void SDCardManager::busStartRead(uint8_t* buffer, uint32_t length) {
+    if (spiDmaRx < 0) {
+        spi_read_blocking(spiInstance, 0xFF, buffer, length);  // No DMA - done on return
+        return;
+    }
+    startReadTransfer(buffer, length);
+}
+
+void SDCardManager::busStartWrite(const uint8_t* buffer, uint32_t length) {
+    if (spiDmaTx < 0) {
+        spi_write_blocking(spiInstance, buffer, length);
+        return;
+    }
+    startWriteTransfer(buffer, length);
+}
+
+bool SDCardManager::busTransferDone() {
+    return isTransferDone();
+}
+
+// Wait until the card has finished programming (MISO held low = busy)
+bool SDCardManager::waitWhileBusy(uint32_t maxBytes) {
+    uint8_t busy = 0;
+    for (uint32_t i = 0; i < maxBytes; i++) {
+        spi_read_blocking(spiInstance, 0xFF, &busy, 1);
+        if (busy == 0xFF) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Write consecutive blocks in one CMD25 transfer
+// ACMD23 tells the card how many blocks follow so it can pre-erase them (optional for the card -
+// a rejected ACMD23 is ignored). The card programs while the next block is sent, and the busy
+// wait is paid per block only as long as the card actually needs - not one CMD24 round trip each.
+bool SDCardManager::writeBlocks(uint32_t blockAddress, const uint8_t* buffer, uint32_t count) {
+    if (!initialized || buffer == nullptr || count == 0) {
+        return false;
+    }
+    if (count == 1) {
+        return writeBlock(blockAddress, buffer);
+    }
+    
+    asyncEngine.finishBusRequest();
+    selectCard();
+    
+    // Pre-erase hint (ACMD23) - 23-bit block count
+    sendACommand(SD_ACMD23, count & 0x7FFFFF);
+    
+    // Send CMD25 (write multiple blocks)
+    uint8_t response = sendCommand(SD_CMD25, blockAddress);
+    if (response != 0) {
+        deselectCard();
+        return false;
+    }
+    
+    bool success = true;
+    for (uint32_t block = 0; block < count; block++) {
+        // Send data token
+        uint8_t token = SD_TOKEN_MULTI_WRITE;
+        spi_write_blocking(spiInstance, &token, 1);
+        
+        // Write 512 bytes
+        writeData(buffer + block * SD_BLOCK_SIZE, SD_BLOCK_SIZE);
+        
+        // Send dummy CRC
+        uint8_t crc[2] = {0xFF, 0xFF};
+        spi_write_blocking(spiInstance, crc, 2);
+        
+        // Wait for response
+        uint8_t writeResponse = 0xFF;
+        for (int i = 0; i < 100; i++) {
+            spi_read_blocking(spiInstance, 0xFF, &writeResponse, 1);
+            if ((writeResponse & 0x1F) == 0x05) {  // Data accepted
+                break;
+            }
+        }
+        
+        // Card is busy programming the block (or its buffer) - next token only when ready
+        if ((writeResponse & 0x1F) != 0x05 || !waitWhileBusy(SD_WRITE_BUSY_TIMEOUT)) {
+            success = false;
+            break;
+        }
+    }
+    
+    // Stop transmission token ends the transfer (also after an error) and wait for the last program
+    uint8_t stop = SD_TOKEN_STOP_TRAN;
+    spi_write_blocking(spiInstance, &stop, 1);
+    uint8_t dummy;
+    spi_read_blocking(spiInstance, 0xFF, &dummy, 1);  // One byte before busy starts
+    if (!waitWhileBusy(SD_WRITE_BUSY_TIMEOUT)) {
+        success = false;
+    }
+    
+    deselectCard();
+    return success;
+}
+
 // Read file using FAT32
 bool SDCardManager::readFile(const char* filename, uint8_t* buffer, uint32_t maxSize, uint32_t* bytesRead) {
     if (!initialized || !buffer) {
@@ -654,16 +955,29 @@ FAT32* SDCardManager::getFAT32() const {
 }
 
 // Load disk image from SD card using FAT32
-bool SDCardManager::loadDiskImage(const char* filename, uint8_t* buffer, uint32_t bufferSize, uint32_t* bytesRead) {
+// file (optional): receives the open handle for later track saves (closed on failure)
+bool SDCardManager::loadDiskImage(const char* filename, uint8_t* buffer, uint32_t bufferSize, uint32_t* bytesRead,
+                                  FAT32File* file) {
+    static FAT32File loadFile;  // Handle when the caller does not keep one (static - ~1KB)
+    if (file == nullptr) {
+        file = &loadFile;
+    }
+    file->open = false;
+    
     if (!initialized || buffer == nullptr) {
         return false;
     }
     
     // Use FAT32 if available
     if (fat32) {
-        // Get file size first
-        uint32_t fileSize = fat32->getFileSize(filename);
+        // Open once - directory lookup and extent map; the reads below use the handle
+        if (!fat32->openFile(filename, file)) {
+            if (bytesRead) *bytesRead = 0;
+            return false;
+        }
+        uint32_t fileSize = file->fileSize;
         if (fileSize == 0) {
+            fat32->closeFile(file);
             if (bytesRead) *bytesRead = 0;
             return false;
         }
@@ -709,10 +1023,12 @@ bool SDCardManager::loadDiskImage(const char* filename, uint8_t* buffer, uint32_
                 // For now, return error - this requires either:
                 // 1. FAT32::readFile with offset support, or
                 // 2. A temporary buffer large enough for fileSize (too much memory)
+                fat32->closeFile(file);
                 if (bytesRead) *bytesRead = 0;
                 return false;
             } else {
                 // Header too large or zero, not supported  
+                fat32->closeFile(file);
                 if (bytesRead) *bytesRead = 0;
                 return false;
             }
@@ -723,7 +1039,8 @@ bool SDCardManager::loadDiskImage(const char* filename, uint8_t* buffer, uint32_
             // NIC files are 286720 bytes, read directly into buffer
             uint32_t bytesReadSoFar = 0;
             uint32_t maxReadSize = bufferSize < fileSize ? bufferSize : fileSize;
-            if (!fat32->readFile(filename, buffer, maxReadSize, &bytesReadSoFar)) {
+            if (!fat32->readFile(file, buffer, maxReadSize, &bytesReadSoFar)) {
+                fat32->closeFile(file);
                 if (bytesRead) *bytesRead = 0;
                 return false;
             }
@@ -740,7 +1057,8 @@ bool SDCardManager::loadDiskImage(const char* filename, uint8_t* buffer, uint32_
         // - .dsk files that are exactly 143360 bytes (no header, already RAW format)
         // - Any other file format (RAW format)
         uint32_t bytesReadSoFar = 0;
-        if (!fat32->readFile(filename, buffer, bufferSize, &bytesReadSoFar)) {
+        if (!fat32->readFile(file, buffer, bufferSize, &bytesReadSoFar)) {
+            fat32->closeFile(file);
             if (bytesRead) *bytesRead = 0;
             return false;
         }
@@ -782,16 +1100,14 @@ bool SDCardManager::loadDiskImage(const char* filename, uint8_t* buffer, uint32_
 }
 
 // Save track data to file at specific track position
-bool SDCardManager::saveTrackToFile(const char* filename, int track, const uint8_t* trackData, uint32_t trackSize) {
-    if (!initialized || !trackData || trackSize == 0) {
+bool SDCardManager::saveTrackToFile(FAT32File* file, int track, const uint8_t* trackData, uint32_t trackSize) {
+    if (!initialized || !file || !trackData || trackSize == 0) {
         return false;
     }
     
     // Use FAT32 if available
     if (fat32) {
-        // Use filename as-is - findFile() searches in current directory
-        // Don't construct full path because listFiles() returns only filenames
-        // and findFile() searches in the current directory context
+        // The handle holds the file's sectors - no directory lookup, independent of 'cd'
         
         // Calculate offset in file: track * bytes per track
         // Determine file type from track size:
@@ -809,18 +1125,131 @@ bool SDCardManager::saveTrackToFile(const char* filename, int track, const uint8
         }
         
         // Write track data at calculated offset
-        return fat32->writeFileAtOffset(filename, offset, trackData, trackSize);
+        return fat32->writeFileAtOffset(file, offset, trackData, trackSize);
     }
     
     return false;
 }
 
-// Read track data from file at specific track position
-bool SDCardManager::readTrackFromFile(const char* filename, int track, uint8_t* trackData, uint32_t trackSize) {
-    //printf("readTrackFromFile: filename='%s', track=%d, trackSize=%u\r\n", 
-    //       filename ? filename : "(null)", track, trackSize);
+// Save only selected sectors of a track to file
+// sectorMask: bit N = sector N of trackData (sector size = trackSize / 16)
+// Consecutive sectors are merged into one write
+bool SDCardManager::saveTrackSectorsToFile(FAT32File* file, int track, const uint8_t* trackData, uint32_t trackSize, uint16_t sectorMask) {
+    if (!initialized || !file || !trackData || trackSize == 0 || sectorMask == 0) {
+        return false;
+    }
+    
+    if (sectorMask == 0xFFFF) {
+        return saveTrackToFile(file, track, trackData, trackSize);
+    }
+    
+    if (fat32) {
+        // 256 bytes per sector for DSK (4096-byte tracks), 512 bytes for NIC (8192-byte tracks)
+        uint32_t sectorSize = trackSize / 16;
+        uint32_t trackOffset = track * trackSize;
+        bool success = true;
+        
+        int sector = 0;
+        while (sector < 16) {
+            if (!(sectorMask & (1u << sector))) {
+                sector++;
+                continue;
+            }
+            
+            // Find run of consecutive dirty sectors
+            int runStart = sector;
+            while (sector < 16 && (sectorMask & (1u << sector))) {
+                sector++;
+            }
+            
+            uint32_t runOffset = runStart * sectorSize;
+            uint32_t runSize = (sector - runStart) * sectorSize;
+            if (!fat32->writeFileAtOffset(file, trackOffset + runOffset, trackData + runOffset, runSize)) {
+                success = false;
+            }
+        }
+        return success;
+    }
     
-    if (!initialized || !trackData || trackSize == 0) {
+    return false;
+}
+
+// Queue selected sectors of a track on the async engine instead of writing them here
+// sectorMask as in saveTrackSectorsToFile(), but only whole 512-byte file blocks can be queued:
+// with 256-byte sectors (DSK) both sectors of a block must be selected.
+// Each run of blocks that is contiguous on the card becomes one write request (callback/context
+// are passed to every request). trackData must not change until all callbacks have run.
+// Nothing is queued (false) if a block is selected only in part, an offset is not mapped or the
+// queue has no room - the caller then uses saveTrackSectorsToFile(). requests = requests queued
+bool SDCardManager::submitTrackSectors(FAT32File* file, int track, const uint8_t* trackData, uint32_t trackSize,
+                                       uint16_t sectorMask, SDAsyncCallback callback, void* context,
+                                       uint32_t* requests) {
+    *requests = 0;
+    uint32_t sectorSize = trackSize / 16;
+    if (!initialized || !fat32 || !file || !trackData || sectorMask == 0 ||
+        (sectorSize != 256 && sectorSize != 512)) {
+        return false;
+    }
+    
+    typedef struct {
+        uint32_t lba;           // First card block of the run
+        uint32_t count;         // Blocks
+        uint32_t dataOffset;    // Offset of the run in trackData
+    } BlockRun;
+    BlockRun runs[16];
+    uint32_t runCount = 0;
+    
+    uint32_t sectorsPerBlock = 512 / sectorSize;
+    uint32_t blockSectorBits = (1u << sectorsPerBlock) - 1;
+    uint32_t trackOffset = track * trackSize;
+    
+    for (uint32_t block = 0; block < trackSize / 512; block++) {
+        uint32_t blockSectors = blockSectorBits << (block * sectorsPerBlock);
+        uint32_t selected = sectorMask & blockSectors;
+        if (selected == 0) {
+            continue;
+        }
+        if (selected != blockSectors) {
+            return false;  // Half of a block - needs the read-modify-write of writeFileAtOffset()
+        }
+        
+        uint32_t lba;
+        uint32_t sectorsLeft;
+        if (!fat32->mapFileOffset(file, trackOffset + block * 512, &lba, &sectorsLeft)) {
+            return false;
+        }
+        
+        // Extend the previous run if this block follows it both in the track and on the card
+        BlockRun* last = runCount > 0 ? &runs[runCount - 1] : nullptr;
+        if (last && last->dataOffset + last->count * 512 == block * 512 && last->lba + last->count == lba) {
+            last->count++;
+        } else {
+            runs[runCount].lba = lba;
+            runs[runCount].count = 1;
+            runs[runCount].dataOffset = block * 512;
+            runCount++;
+        }
+    }
+    
+    if (runCount == 0 || asyncEngine.getPending() + runCount > SD_ASYNC_QUEUE_DEPTH) {
+        return false;
+    }
+    
+    bool success = true;
+    for (uint32_t i = 0; i < runCount; i++) {
+        if (asyncEngine.submitWrite(runs[i].lba, trackData + runs[i].dataOffset, runs[i].count, callback, context) != 0) {
+            (*requests)++;
+        } else if (!writeBlocks(runs[i].lba, trackData + runs[i].dataOffset, runs[i].count)) {
+            // Queue filled up from the other core meanwhile - this run is written here instead
+            success = false;
+        }
+    }
+    return success;
+}
+
+// Read track data from file at specific track position
+bool SDCardManager::readTrackFromFile(FAT32File* file, int track, uint8_t* trackData, uint32_t trackSize) {
+    if (!initialized || !file || !trackData || trackSize == 0) {
         printf("readTrackFromFile: Invalid parameters - initialized=%d, trackData=%p, trackSize=%u\r\n",
                initialized, trackData, trackSize);
         return false;
@@ -828,12 +1257,6 @@ bool SDCardManager::readTrackFromFile(const char* filename, int track, uint8_t*
     
     // Use FAT32 if available
     if (fat32) {
-        // Use filename as-is - findFile() searches in current directory
-        // Don't construct full path because listFiles() returns only filenames
-        // and findFile() searches in the current directory context
-        
-        //printf("readTrackFromFile: Using filename='%s' (findFile will search in current directory)\r\n", filename);
-        
         // Calculate offset in file: track * bytes per track
         // Apple II disk format: 35 tracks * 16 sectors * 256 bytes = 143360 bytes total
         // Each track is 4096 bytes (16 sectors * 256 bytes)
@@ -844,7 +1267,7 @@ bool SDCardManager::readTrackFromFile(const char* filename, int track, uint8_t*
         
         // Read track data at calculated offset
         uint32_t bytesRead = 0;
-        if (fat32->readFileAtOffset(filename, offset, trackData, trackSize, &bytesRead)) {
+        if (fat32->readFileAtOffset(file, offset, trackData, trackSize, &bytesRead)) {
             //printf("readTrackFromFile: readFileAtOffset SUCCESS - bytesRead=%u, expected=%u\r\n",
             //       bytesRead, trackSize);
             return bytesRead == trackSize;
@@ -1145,3 +1568,44 @@ uint32_t SDCardManager::testMaxReadSpeed(uint32_t testBlocks, bool verbose) {
     return maxSuccessfulSpeed ;
 }
 
+// Rewrite one track of a disk image with its own contents, once per write path
+// The file content does not change - this only measures the time of a track flush.
+bool SDCardManager::benchmarkTrackWrite(FAT32File* file, int track, uint32_t trackSize, SDWriteBenchResult* result) {
+    if (!initialized || !fat32 || !file || !result || trackSize == 0) {
+        return false;
+    }
+    
+    // NIC track is too large for the core1 stack - borrow the FAT32 index scratch buffer
+    uint32_t scratchSize = 0;
+    uint8_t* trackData = fat32->getScratchBuffer(&scratchSize);
+    if (trackSize > scratchSize) {
+        return false;
+    }
+    
+    // Finish queued write-back saves first - the track is read back from the card below
+    while (asyncEngine.poll()) {
+    }
+    
+    uint32_t offset = track * trackSize;
+    uint32_t bytesRead = 0;
+    if (!fat32->readFileAtOffset(file, offset, trackData, trackSize, &bytesRead) || bytesRead != trackSize) {
+        return false;
+    }
+    
+    bool success = true;
+    
+    // Old path: read-modify-write of every sector with CMD24
+    fat32->setMultiBlockWrite(false);
+    uint32_t start = time_us_32();
+    success &= fat32->writeFileAtOffset(file, offset, trackData, trackSize);
+    result->legacyUs = time_us_32() - start;
+    
+    // New path: whole sectors without read, consecutive sectors with ACMD23 + CMD25
+    fat32->setMultiBlockWrite(true);
+    start = time_us_32();
+    success &= fat32->writeFileAtOffset(file, offset, trackData, trackSize);
+    result->multiBlockUs = time_us_32() - start;
+    
+    result->trackSize = trackSize;
+    return success;
+}
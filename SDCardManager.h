@@ -3,31 +3,23 @@
 
 #include "pico/stdlib.h"
 #include "hardware/spi.h"
+#include "hardware/dma.h"
 #include "PinConfig.h"
 #include "FAT32.h"
 #include "FloppyEmulator.h"
+#include "SDAsyncEngine.h"
+#include "SDProtocol.h"
 #include <stdint.h>
 #include <stdbool.h>
 
-// SD Card commands
-#define SD_CMD0            0
-#define SD_CMD8            8
-#define SD_CMD16           16
-#define SD_CMD17           17  // Read single block
-#define SD_CMD24           24  // Write single block
-#define SD_CMD55           55
-#define SD_CMD58           58
-#define SD_ACMD41          41
+// Result of the track write benchmark (see SDCardManager::benchmarkTrackWrite())
+typedef struct {
+    uint32_t legacyUs;          // Sector read-modify-write with CMD24 per sector
+    uint32_t multiBlockUs;      // Full sectors streamed with ACMD23 + CMD25
+    uint32_t trackSize;         // Bytes written per pass
+} SDWriteBenchResult;
 
-// SD Card response types
-#define SD_R1              1
-#define SD_R1_IDLE         0x01
-#define SD_R1_ILLEGAL_CMD  0x04
-
-// SD Card block size
-#define SD_BLOCK_SIZE      512
-
-class SDCardManager {
+class SDCardManager : public SDAsyncBus {
 private:
     spi_inst_t* spiInstance;
     uint8_t csPin;
@@ -39,16 +31,28 @@ private:
     bool cardPresent;  // Last known card presence state
     uint32_t currentBaudrate;  // Current SPI baudrate
     
+    // DMA block transfers (TX channel feeds the SPI FIFO, RX channel drains it)
+    // -1 = not claimed - block data then falls back to spi_read/write_blocking()
+    int spiDmaTx;
+    int spiDmaRx;
+    
     // FAT32 filesystem
     FAT32* fat32;
     FAT32_Error lastFAT32Error;  // Store last FAT32 error (preserved even if FAT32 deleted)
     
+    // Non-blocking request queue (polled from the core1 loop)
+    SDAsyncEngine asyncEngine;
+    
     // Internal methods
     void selectCard();
     void deselectCard();
     uint8_t sendCommand(uint8_t cmd, uint32_t arg);
     uint8_t sendACommand(uint8_t cmd, uint32_t arg);
     void waitForReady();
+    bool waitWhileBusy(uint32_t maxBytes);  // Wait until card releases MISO after programming
+    void initSpiDma();                      // Claim and configure the SPI DMA channels (once)
+    void readData(uint8_t* buffer, uint32_t length);         // Block data via DMA (or blocking SPI)
+    void writeData(const uint8_t* buffer, uint32_t length);  // Block data via DMA (or blocking SPI)
     bool waitForResponse(uint8_t* response, uint32_t timeout);
     
 public:
@@ -66,7 +70,28 @@ public:
     
     // Read/Write operations
     bool readBlock(uint32_t blockAddress, uint8_t* buffer);
+    bool readBlocks(uint32_t blockAddress, uint8_t* buffer, uint32_t count);  // CMD18 stream (count == 1 -> CMD17)
     bool writeBlock(uint32_t blockAddress, const uint8_t* buffer);
+    bool writeBlocks(uint32_t blockAddress, const uint8_t* buffer, uint32_t count);  // CMD25 stream (count == 1 -> CMD24)
+    
+    // DMA block transfer primitives (card must be selected)
+    // start*() return immediately; poll isTransferDone() or call waitTransfer() before the next SPI access
+    void startReadTransfer(uint8_t* buffer, uint32_t length);        // Clock out 0xFF, store received bytes
+    void startWriteTransfer(const uint8_t* buffer, uint32_t length); // Send bytes, discard received bytes
+    bool isTransferDone() const;
+    void waitTransfer();
+    
+    // Async engine access - the blocking calls above first finish the engine's request on the bus
+    SDAsyncEngine* getAsyncEngine() { return &asyncEngine; }
+    
+    // SDAsyncBus (used by the async engine - bounded work per call)
+    bool busReady();
+    void busSelect(bool select);
+    uint8_t busCommand(uint8_t cmd, uint32_t arg);
+    uint8_t busExchange(uint8_t out);
+    void busStartRead(uint8_t* buffer, uint32_t length);
+    void busStartWrite(const uint8_t* buffer, uint32_t length);
+    bool busTransferDone();
     
     // File operations (FAT32)
     bool readFile(const char* filename, uint8_t* buffer, uint32_t maxSize, uint32_t* bytesRead);
@@ -74,9 +99,13 @@ public:
     bool listFiles(char* fileList, uint32_t maxSize, uint32_t* fileCount);
     
     // Disk image loading
-    bool loadDiskImage(const char* filename, uint8_t* buffer, uint32_t bufferSize, uint32_t* bytesRead);
-    bool saveTrackToFile(const char* filename, int track, const uint8_t* trackData, uint32_t trackSize);
-    bool readTrackFromFile(const char* filename, int track, uint8_t* trackData, uint32_t trackSize);
+    bool loadDiskImage(const char* filename, uint8_t* buffer, uint32_t bufferSize, uint32_t* bytesRead,
+                       FAT32File* file = nullptr);  // file: handle kept open for the track saves
+    bool saveTrackToFile(FAT32File* file, int track, const uint8_t* trackData, uint32_t trackSize);
+    bool saveTrackSectorsToFile(FAT32File* file, int track, const uint8_t* trackData, uint32_t trackSize, uint16_t sectorMask);
+    bool submitTrackSectors(FAT32File* file, int track, const uint8_t* trackData, uint32_t trackSize, uint16_t sectorMask,
+                            SDAsyncCallback callback, void* context, uint32_t* requests);  // Async engine writes
+    bool readTrackFromFile(FAT32File* file, int track, uint8_t* trackData, uint32_t trackSize);
     
     // FAT32 access
     FAT32* getFAT32() const;
@@ -85,6 +114,9 @@ public:
     // Speed testing
     uint32_t testMaxReadSpeed(uint32_t testBlocks = 5, bool verbose = false);
     
+    // Write benchmark: rewrites one track of the file with its own data (old path vs multi-block path)
+    bool benchmarkTrackWrite(FAT32File* file, int track, uint32_t trackSize, SDWriteBenchResult* result);
+    
     // Get current SPI speed in Hz
     uint32_t getCurrentBaudrate() const { return currentBaudrate; }
 };
@@ -0,0 +1,38 @@
+#ifndef SD_PROTOCOL_H
+#define SD_PROTOCOL_H
+
+// SD card SPI protocol constants - shared by SDCardManager, SDAsyncEngine and the
+// host tests (no SDK headers, so the async engine builds without the Pico SDK)
+
+// SD Card commands
+#define SD_CMD0            0
+#define SD_CMD8            8
+#define SD_CMD12           12  // Stop transmission (ends CMD18)
+#define SD_CMD16           16
+#define SD_CMD17           17  // Read single block
+#define SD_CMD18           18  // Read multiple blocks
+#define SD_CMD24           24  // Write single block
+#define SD_CMD25           25  // Write multiple blocks
+#define SD_CMD55           55
+#define SD_CMD58           58
+#define SD_ACMD41          41
+#define SD_ACMD23          23  // Pre-erase count for next multi-block write
+
+// SD Card response types
+#define SD_R1              1
+#define SD_R1_IDLE         0x01
+#define SD_R1_ILLEGAL_CMD  0x04
+
+// SD Card block size
+#define SD_BLOCK_SIZE      512
+
+// Data tokens
+#define SD_TOKEN_START_BLOCK   0xFE  // Start of a read data block (CMD17/CMD18)
+#define SD_TOKEN_SINGLE_WRITE  0xFE  // Start block (CMD24)
+#define SD_TOKEN_MULTI_WRITE   0xFC  // Start block (CMD25)
+#define SD_TOKEN_STOP_TRAN     0xFD  // Stop CMD25 transfer
+
+// Busy polling limit after a block write (bytes clocked while card holds MISO low)
+#define SD_WRITE_BUSY_TIMEOUT  50000
+
+#endif // SD_PROTOCOL_H
@@ -17,7 +17,14 @@ UIHandler::UIHandler(Display* disp, RotaryEncoder* enc) {
     // Starting Y position: STATUS_BAR_HEIGHT + 12, each file is 8px
     // Available height: CONTENT_AREA_HEIGHT - 12 (header area)
     maxVisibleItems = (CONTENT_AREA_HEIGHT - 12) / 8;  // About 4-5 files for 48px content area
-    memset(fileList, 0, sizeof(fileList));
+    if (maxVisibleItems > UI_FILE_PAGE_SIZE) {
+        maxVisibleItems = UI_FILE_PAGE_SIZE;
+    }
+    filePageCount = 0;
+    filePageValid = false;
+    filePageDirCluster = 0;
+    filePageScrollOffset = 0;
+    filePageMountId = 0;
     memset(loadedFileName, 0, sizeof(loadedFileName));
     encoderStepCounter = 0;
     lastEncoderDirection = ENCODER_NONE;
@@ -181,36 +188,16 @@ void UIHandler::handleEncoderInput() {
         }
         if (currentScreen == UI_SCREEN_FILE_LIST) {
             if (sdCard && selectedIndex < (int)fileCount) {
-                // Extract filename from fileList
-                char* line = fileList;
-                for (int i = 0; i < selectedIndex && line; i++) {
-                    line = strchr(line, '\n');
-                    if (line) line++;
-                }
+                // Selected entry is on the current page (updateFileList() fetches the page at scrollOffset
+                // only if the one on screen is for another position)
+                updateFileList();
+                int pageIndex = selectedIndex - scrollOffset;
                 
-                if (line) {
-                    char filename[64];
-                    int len = 0;
-                    bool isDirectory = false;
-                    
-                    // Extract filename and check for <DIR> marker
-                    char* lineStart = line;
-                    while (*line && *line != '\n' && *line != '\r' && len < 63) {
-                        if (*line == '<') {
-                            // Check if it's <DIR>
-                            if (strncmp(line, "<DIR>", 5) == 0) {
-                                isDirectory = true;
-                                break;
-                            }
-                        }
-                        filename[len++] = *line;
-                        line++;
-                    }
-                    // Trim trailing spaces
-                    while (len > 0 && filename[len - 1] == ' ') {
-                        len--;
-                    }
-                    filename[len] = 0;
+                if (pageIndex >= 0 && pageIndex < (int)filePageCount) {
+                    char filename[FAT32_FILE_NAME_SIZE];
+                    strcpy(filename, filePage[pageIndex].name);
+                    bool isDirectory = filePage[pageIndex].isDirectory;
+                    int len = strlen(filename);
                     
                     if (len > 0) {
                         FAT32* fat32 = sdCard->getFAT32();
@@ -234,16 +221,22 @@ void UIHandler::handleEncoderInput() {
                                 uint32_t diskSize = floppy->getDiskImageSize();
                                 uint32_t bytesRead = 0;
                                 
-                                bool success = sdCard->loadDiskImage(filename, diskImage, diskSize, &bytesRead);
+                                // Flush pending writes of the old image before the buffer is overwritten
+                                floppy->beginDiskImageLoad();
+                                
+                                uint32_t loadStart = time_us_32();
+                                bool success = sdCard->loadDiskImage(filename, diskImage, diskSize, &bytesRead, floppy->getCurrentFile());
                                 
                                 // Show result
                                 if (success) {
+                                    // Set SD card manager and file type in FloppyEmulator for saving tracks
+                                    // File type first - loadDiskImage() needs it (.dsk/.nic)
+                                    floppy->setSDCardManager(sdCard);
+                                    floppy->updateCurrentFileType();
+                                    
                                     // Call FloppyEmulator::loadDiskImage() to set initial track to 17
                                     floppy->loadDiskImage(diskImage, bytesRead);
-                                    
-                                    // Set SD card manager and filename in FloppyEmulator for saving tracks
-                                    floppy->setSDCardManager(sdCard);
-                                    floppy->setCurrentFileName(filename);
+                                    printf("Mounted %s in %lu ms\r\n", filename, (unsigned long)((time_us_32() - loadStart) / 1000));
                                     
                                     // Save loaded file name
                                     strncpy(loadedFileName, filename, sizeof(loadedFileName) - 1);
@@ -256,8 +249,9 @@ void UIHandler::handleEncoderInput() {
                                     loadingEndTime = make_timeout_time_ms(500);
                                     // Don't change screen yet - will be handled in update()
                                 } else {
-                                    // Clear file name on error
+                                    // Clear file name on error - the drive reads as an empty disk
                                     loadedFileName[0] = 0;
+                                    floppy->abortDiskImageLoad();
                                     
                                     renderLoadingScreen("ERROR");
                                     display->update();
@@ -280,9 +274,10 @@ void UIHandler::handleEncoderInput() {
             // Enter selected menu option (0=Files, 1=Status, 2=Info)
             if (selectedIndex == 0) {
                 currentScreen = UI_SCREEN_FILE_LIST;
-                updateFileList();
                 selectedIndex = 0;
                 scrollOffset = 0;
+                invalidateFileList();  // Directory may have changed since (CLI, image writes)
+                updateFileList();
             } else if (selectedIndex == 1) {
                 currentScreen = UI_SCREEN_STATUS;
             } else if (selectedIndex == 2) {
@@ -293,23 +288,33 @@ void UIHandler::handleEncoderInput() {
     }
 }
 
+// Fetch the visible page of the sorted listing (FAT32 keeps a window around it, so
+// scrolling within a few screens does not touch the card). The page is kept until the
+// directory, scroll position or mount changes - screen refreshes redraw it as is
 void UIHandler::updateFileList() {
-    if (!sdCard) {
+    FAT32* fat32 = sdCard ? sdCard->getFAT32() : nullptr;
+    if (!fat32) {
+        filePageCount = 0;
         fileCount = 0;
+        filePageValid = false;
         return;
     }
     
-    FAT32* fat32 = sdCard->getFAT32();
-    if (!fat32) {
-        fileCount = 0;
+    uint32_t dirCluster = fat32->getCurrentDirectoryCluster();
+    uint32_t mountId = fat32->getMountId();
+    if (filePageValid && filePageDirCluster == dirCluster && filePageScrollOffset == scrollOffset &&
+        filePageMountId == mountId) {
         return;
     }
     
-    if (fat32->listFiles(fileList, sizeof(fileList), &fileCount)) {
-        // File list updated
-    } else {
-        fileCount = 0;
+    filePageCount = 0;
+    filePageValid = fat32->listFilesPage(scrollOffset, filePage, maxVisibleItems, &filePageCount, &fileCount);
+    if (!filePageValid) {
+        fileCount = 0;  // Fetched again on the next refresh
     }
+    filePageDirCluster = dirCluster;
+    filePageScrollOffset = scrollOffset;
+    filePageMountId = mountId;
 }
 
 // Icon bitmaps (8x8 pixels, packed format: byte per row, MSB first, row major order)
@@ -452,70 +457,31 @@ void UIHandler::renderFileListScreen() {
     display->drawString(0, STATUS_BAR_HEIGHT + 2, "Files:", true);
     display->drawLine(0, STATUS_BAR_HEIGHT + 10, DISPLAY_WIDTH, STATUS_BAR_HEIGHT + 10, true);
     
-    if (fileCount == 0) {
-        updateFileList();
-    }
+    updateFileList();
     
     if (fileCount == 0) {
         display->drawString(0, STATUS_BAR_HEIGHT + 18, "No files found", true);
     } else {
-        char* line = fileList;
-        int visibleIndex = 0;
-        int lineIndex = 0;
-        
-        while (line && *line && visibleIndex < maxVisibleItems) {
-            char* lineStart = line;
+        for (int visibleIndex = 0; visibleIndex < (int)filePageCount; visibleIndex++) {
+            const FAT32_ListEntry* item = &filePage[visibleIndex];
             
-            // Find end of line
-            while (*line && *line != '\n' && *line != '\r') {
-                line++;
-            }
+            // Draw this line (directories keep the <DIR> marker of the text listing)
+            char displayLine[21];  // 128 pixels / 6 pixels per char = ~21 chars
+            snprintf(displayLine, sizeof(displayLine), "%s%s", item->name, item->isDirectory ? " <DIR>" : "");
+            bool isSelected = (scrollOffset + visibleIndex == selectedIndex);
             
-            // Check if line has content (at least one non-whitespace char)
-            bool hasContent = false;
-            for (char* p = lineStart; p < line; p++) {
-                if (*p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') {
-                    hasContent = true;
-                    break;
-                }
-            }
+            int yPos = STATUS_BAR_HEIGHT + 12 + visibleIndex * 8;
             
-            // Only process lines with content
-            if (hasContent) {
-                if (lineIndex >= scrollOffset) {
-                    // Draw this line
-                    char displayLine[21];  // 128 pixels / 6 pixels per char = ~21 chars
-                    int len = 0;
-                    bool isSelected = (lineIndex == selectedIndex);
-                    
-                    // Don't add '>' prefix - we'll use inverted background instead
-                    // Copy line content
-                    char* p = lineStart;
-                    while (p < line && len < 20) {
-                        displayLine[len++] = *p++;
-                    }
-                    displayLine[len] = 0;
-                    
-                    int yPos = STATUS_BAR_HEIGHT + 12 + visibleIndex * 8;
-                    
-                    // Draw inverted background rectangle for selected item
-                    if (isSelected) {
-                        // Fill rectangle with inverted color (white/true)
-                        display->fillRect(0, yPos, DISPLAY_WIDTH, 8, true);
-                        // Draw text with inverted color (black/false)
-                        display->drawString(0, yPos, displayLine, false);
-                    } else {
-                        // Draw text with normal color (white/true)
-                        display->drawString(0, yPos, displayLine, true);
-                    }
-                    visibleIndex++;
-                }
-                lineIndex++;
+            // Draw inverted background rectangle for selected item
+            if (isSelected) {
+                // Fill rectangle with inverted color (white/true)
+                display->fillRect(0, yPos, DISPLAY_WIDTH, 8, true);
+                // Draw text with inverted color (black/false)
+                display->drawString(0, yPos, displayLine, false);
+            } else {
+                // Draw text with normal color (white/true)
+                display->drawString(0, yPos, displayLine, true);
             }
-            
-            // Skip newline characters
-            if (*line == '\r') line++;
-            if (*line == '\n') line++;
         }
     }
 }
@@ -44,6 +44,9 @@ typedef enum {
     #define STATUS_SEPARATOR_Y 0
 #endif
 
+// File list rows fetched per page (upper bound for maxVisibleItems)
+#define UI_FILE_PAGE_SIZE 8
+
 // Encoder sensitivity (number of encoder steps to skip before reacting)
 #define ENCODER_SENSITIVITY 2  // Number of encoder steps to ignore before UI reacts (1 = most sensitive, higher = less sensitive)
 
@@ -58,9 +61,14 @@ private:
     int selectedIndex;
     int scrollOffset;
     
-    // File list state
-    char fileList[512];
-    uint32_t fileCount;
+    // File list state - only the visible page is held (FAT32::listFilesPage())
+    FAT32_ListEntry filePage[UI_FILE_PAGE_SIZE];
+    uint32_t filePageCount;
+    uint32_t fileCount;             // Entries in the whole listing
+    bool filePageValid;             // filePage holds the page of the key below
+    uint32_t filePageDirCluster;    // Directory, first entry and FAT32 mount the page was fetched for
+    int filePageScrollOffset;
+    uint32_t filePageMountId;
     int maxVisibleItems;
     
     // Loaded file name
@@ -93,6 +101,7 @@ private:
     // Navigation
     void handleEncoderInput();
     void updateFileList();
+    void invalidateFileList() { filePageValid = false; }
     
 public:
     UIHandler(Display* disp, RotaryEncoder* enc);
@@ -0,0 +1,39 @@
+// Host test of the write data separator: FluxPLL::runSyntheticTest() must decode a
+// synthetic GCR stream without bit errors at +/-3% and +/-5% drive speed, with up to
+// 20% edge jitter, at the cell periods of the supported system clocks
+
+#include "FluxPLL.h"
+#include "TestCheck.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+static void runPLLTest(TestResult* result, bool verbose) {
+    // Capture counter runs at clk_sys / 2: 4μs cell = 300 ticks at 150MHz, 400 ticks at 200MHz
+    static const uint32_t cellTicks[] = { 300, 400 };
+    static const int32_t speeds[] = { -50, -30, 30, 50 };   // Permille
+    static const uint32_t jitters[] = { 0, 10, 20 };        // % of a bit cell
+    char what[128];
+
+    for (uint32_t c = 0; c < sizeof(cellTicks) / sizeof(cellTicks[0]); c++) {
+        for (uint32_t s = 0; s < sizeof(speeds) / sizeof(speeds[0]); s++) {
+            for (uint32_t j = 0; j < sizeof(jitters) / sizeof(jitters[0]); j++) {
+                FluxPLLTestResult test;
+                FluxPLL::runSyntheticTest(cellTicks[c], FLUX_PLL_DEFAULT_TOLERANCE_PCT, speeds[s], jitters[j],
+                                          1024, &test);
+                snprintf(what, sizeof(what), "cell %u ticks, speed %+d permille, jitter %u%%: %u/%u bit errors",
+                         (unsigned)cellTicks[c], (int)speeds[s], (unsigned)jitters[j],
+                         (unsigned)test.bitErrors, (unsigned)test.bitsSent);
+                testCheck(result, test.bitErrors == 0 && test.bitsSent > 0, what, verbose);
+            }
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    bool verbose = argc > 1 && strcmp(argv[1], "-v") == 0;
+    TestResult result = {0, 0};
+    runPLLTest(&result, verbose);
+    printf("FluxPLL: %u checks, %u failed\n", (unsigned)result.checks, (unsigned)result.failures);
+    return result.failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,259 @@
+// Host test and microbenchmark of the NIC data field codec (NICCodec.cpp): the table-driven
+// encoder/decoder must produce the same data fields as the original implementations kept below,
+// and round-trip every test pattern. Time per sector of both is printed (informational - the
+// host CPU caches and predicts branches unlike the Cortex-M33, so the ratio differs on the RP2350).
+
+#include "NICCodec.h"
+#include "TestCheck.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <chrono>
+
+// Tables as the original codec used them
+static const uint8_t NIC_ENCODE_TABLE[64] = {
+    0x96, 0x97, 0x9A, 0x9B, 0x9D, 0x9E, 0x9F, 0xA6,
+    0xA7, 0xAB, 0xAC, 0xAD, 0xAE, 0xAF, 0xB2, 0xB3,
+    0xB4, 0xB5, 0xB6, 0xB7, 0xB9, 0xBA, 0xBB, 0xBC,
+    0xBD, 0xBE, 0xBF, 0xCB, 0xCD, 0xCE, 0xCF, 0xD3,
+    0xD6, 0xD7, 0xD9, 0xDA, 0xDB, 0xDC, 0xDD, 0xDE,
+    0xDF, 0xE5, 0xE6, 0xE7, 0xE9, 0xEA, 0xEB, 0xEC,
+    0xED, 0xEE, 0xEF, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6,
+    0xF7, 0xF9, 0xFA, 0xFB, 0xFC, 0xFD, 0xFE, 0xFF
+};
+static const uint8_t FLIP_BIT1[4] = { 0, 2, 1, 3 };
+static const uint8_t FLIP_BIT2[4] = { 0, 8, 4, 12 };
+static const uint8_t FLIP_BIT3[4] = { 0, 32, 16, 48 };
+static uint8_t NIC_DECODE_TABLE[256];   // Filled by initReferenceTables()
+
+static void initReferenceTables() {
+    memset(NIC_DECODE_TABLE, 0xFF, sizeof(NIC_DECODE_TABLE));
+    for (int i = 0; i < 64; i++) {
+        NIC_DECODE_TABLE[NIC_ENCODE_TABLE[i]] = i;
+    }
+}
+
+// Decode NIC-encoded data field to raw sector data
+// Based on reverse of encoding logic in updateGCRTrackCache()
+// Encoding process:
+//   1. First 86 bytes: x = FLIP_BIT1[src[i] & 3] | FLIP_BIT2[src[i + 86] & 3] | FLIP_BIT3[src[i + 172] & 3]
+//      encoded = NIC_ENCODE_TABLE[(x ^ ox) & 0x3F], ox = x
+//   2. All 256 bytes: x = (src[i] >> 2)
+//      encoded = NIC_ENCODE_TABLE[(x ^ ox) & 0x3F], ox = x
+//   3. Last byte: encoded = NIC_ENCODE_TABLE[ox & 0x3F]
+// Reference implementation: the original branch-based FlipBit decode
+static void decodeNICDataFieldReference(const uint8_t* gcrData, uint16_t gcrLength, uint8_t* decodedData, uint16_t* decodedLength) {
+    
+    // Need at least: 86 (first encoding) + 256 (standard encoding) + 1 (last byte) = 343 bytes
+    if (gcrLength < 343) {
+        *decodedLength = 0;
+        return;
+    }
+    
+    uint8_t ox = 0;  // Previous XOR state (starts at 0)
+    uint8_t decoded6bit[343];  // Decoded 6-bit values
+    
+    // Step 1: Decode all GCR bytes to 6-bit values (XOR decode)
+    // Encoding: encoded = NIC_ENCODE_TABLE[(x ^ ox) & 0x3F], then ox = x
+    // Decoding: raw = NIC_DECODE_TABLE[encoded] = (x ^ prev_ox), then x = raw ^ prev_ox
+    //           ox must be updated to DECODED value (x), not raw value!
+    for (uint16_t i = 0; i < 343 && i < gcrLength; i++) {
+        uint8_t encoded = gcrData[i];
+        uint8_t raw = NIC_DECODE_TABLE[encoded];  // raw = (original_x ^ previous_ox)
+        if (raw == 0xFF) {
+            // Invalid GCR code - print diagnostic info
+            printf("ERROR: Invalid GCR code 0x%02X at position %u (gcrData[%u])\r\n", encoded, i, i);
+            *decodedLength = 0;
+            return;
+        }
+        decoded6bit[i] = raw ^ ox;  // XOR decode: x = (x ^ prev_ox) ^ prev_ox = x
+        ox = decoded6bit[i];  // CRITICAL: ox must be the DECODED value for next iteration!
+    }
+    
+    // Step 2: Decode the 256 bytes from standard encoding (positions 86 to 86+256)
+    // Each decoded6bit[i] (for i=86 to 86+256) represents (src[i-86] >> 2)
+    // So: src[i-86] = (decoded6bit[i] << 2) | lower_2_bits
+    // The lower 2 bits come from the first 86 bytes (FlipBit encoding)
+    
+    // Initialize decoded data with upper 6 bits
+    *decodedLength = 256;
+    for (uint16_t i = 0; i < 256; i++) {
+        if (86 + i < 343) {
+            uint8_t x = decoded6bit[86 + i];  // This is (src[i] >> 2)
+            decodedData[i] = (x << 2);  // Upper 6 bits (lower 2 bits = 0 for now)
+        } else {
+            decodedData[i] = 0;
+        }
+    }
+    
+    // Step 3: Decode lower 2 bits from first 86 bytes using reverse FlipBit mapping
+    // decoded6bit[0..85] contains: FLIP_BIT1[src[i] & 3] | FLIP_BIT2[src[i + 86] & 3] | FLIP_BIT3[src[i + 172] & 3]
+    // We need to extract src[i] & 3, src[i+86] & 3, src[i+172] & 3 from this
+    
+    // Decode lower 2 bits for bytes 0-85, 86-171, 172-257
+    for (uint16_t i = 0; i < 86 && i < 343; i++) {
+        uint8_t x = decoded6bit[i];  // FLIP_BIT1[a] | FLIP_BIT2[b] | FLIP_BIT3[c]
+        
+        // Extract individual components using reverse lookup
+        // FLIP_BIT1: {0,2,1,3} -> reverse: 0->0, 2->1, 1->2, 3->3
+        uint8_t a = 0;
+        uint8_t x_low = x & 0x03;
+        if (x_low == 0) a = 0;
+        else if (x_low == 2) a = 1;
+        else if (x_low == 1) a = 2;
+        else if (x_low == 3) a = 3;
+        
+        // FLIP_BIT2: {0,8,4,12} -> reverse: 0->0, 8->1, 4->2, 12->3
+        uint8_t b = 0;
+        uint8_t x_mid = x & 0x0C;
+        if (x_mid == 0) b = 0;
+        else if (x_mid == 8) b = 1;
+        else if (x_mid == 4) b = 2;
+        else if (x_mid == 12) b = 3;
+        
+        // FLIP_BIT3: {0,32,16,48} -> reverse: 0->0, 32->1, 16->2, 48->3
+        uint8_t c = 0;
+        uint8_t x_high = x & 0x30;
+        if (x_high == 0) c = 0;
+        else if (x_high == 32) c = 1;
+        else if (x_high == 16) c = 2;
+        else if (x_high == 48) c = 3;
+        
+        // Apply lower 2 bits to decoded data
+        if (i < 256) {
+            decodedData[i] = (decodedData[i] & 0xFC) | a;
+        }
+        if (i + 86 < 256) {
+            decodedData[i + 86] = (decodedData[i + 86] & 0xFC) | b;
+        }
+        if (i + 172 < 256) {
+            decodedData[i + 172] = (decodedData[i + 172] & 0xFC) | c;
+        }
+    }
+}
+
+// Reference NIC data field encoder (original per-call FlipBit encoding with a 258-byte source copy)
+static void encodeNICDataFieldReference(const uint8_t* sectorData, uint8_t* gcr) {
+    uint8_t src[256 + 2];
+    uint32_t gcrIndex = 0;
+    
+    // Copy sector data (2 extra zero bytes for the FlipBit encoding of bytes 256/257)
+    memcpy(src, sectorData, 256);
+    src[256] = src[257] = 0;
+    
+    // Encode first 86 bytes (special encoding with FlipBit tables)
+    uint8_t ox = 0;
+    for (int i = 0; i < 86; i++) {
+        uint8_t x = (FLIP_BIT1[src[i] & 3] | FLIP_BIT2[src[i + 86] & 3] | FLIP_BIT3[src[i + 172] & 3]);
+        gcr[gcrIndex++] = NIC_ENCODE_TABLE[(x ^ ox) & 0x3F];
+        ox = x;
+    }
+    
+    // Encode all 256 bytes (standard encoding: src[i] >> 2)
+    for (int i = 0; i < 256; i++) {
+        uint8_t x = (src[i] >> 2);
+        gcr[gcrIndex++] = NIC_ENCODE_TABLE[(x ^ ox) & 0x3F];
+        ox = x;
+    }
+    
+    // Last byte
+    gcr[gcrIndex++] = NIC_ENCODE_TABLE[ox & 0x3F];
+}
+
+// Nanoseconds per call of one codec over iterations sectors
+template <typename Fn>
+static double timePerSector(uint32_t iterations, Fn fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t n = 0; n < iterations; n++) {
+        fn(n);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+}
+
+static void runCodecTest(TestResult* result, bool verbose, uint32_t iterations) {
+    static uint8_t sectorData[256];
+    static uint8_t gcrNew[NIC_DATA_FIELD_SIZE];
+    static uint8_t gcrRef[NIC_DATA_FIELD_SIZE];
+    static uint8_t decodedNew[256];
+    static uint8_t decodedRef[256];
+    uint16_t decodedLength = 0;
+    char what[96];
+    
+    // Correctness: every byte value in every position class, plus a pseudo-random pattern
+    uint32_t encodeMismatches = 0;
+    uint32_t decodeMismatches = 0;
+    uint32_t referenceMismatches = 0;
+    for (int pattern = 0; pattern < 257; pattern++) {
+        uint32_t seed = 0x12345678u + pattern;
+        for (int i = 0; i < 256; i++) {
+            if (pattern < 256) {
+                sectorData[i] = (uint8_t)(i + pattern);
+            } else {
+                seed = seed * 1103515245u + 12345u;
+                sectorData[i] = (uint8_t)(seed >> 16);
+            }
+        }
+        encodeNICDataField(sectorData, gcrNew);
+        encodeNICDataFieldReference(sectorData, gcrRef);
+        if (memcmp(gcrNew, gcrRef, sizeof(gcrNew)) != 0) {
+            encodeMismatches++;
+        }
+        decodeNICDataField(gcrNew, NIC_DATA_FIELD_SIZE, decodedNew, &decodedLength);
+        if (decodedLength != 256 || memcmp(decodedNew, sectorData, 256) != 0) {
+            decodeMismatches++;
+        }
+        decodeNICDataFieldReference(gcrRef, NIC_DATA_FIELD_SIZE, decodedRef, &decodedLength);
+        if (decodedLength != 256 || memcmp(decodedRef, sectorData, 256) != 0) {
+            referenceMismatches++;
+        }
+    }
+    snprintf(what, sizeof(what), "encoder matches reference (%u of 257 patterns differ)", (unsigned)encodeMismatches);
+    testCheck(result, encodeMismatches == 0, what, verbose);
+    snprintf(what, sizeof(what), "decoder round trip (%u of 257 patterns differ)", (unsigned)decodeMismatches);
+    testCheck(result, decodeMismatches == 0, what, verbose);
+    snprintf(what, sizeof(what), "reference decoder round trip (%u of 257 patterns differ)", (unsigned)referenceMismatches);
+    testCheck(result, referenceMismatches == 0, what, verbose);
+    
+    // Short fields and invalid disk bytes are rejected
+    decodeNICDataField(gcrNew, NIC_DATA_FIELD_SIZE - 1, decodedNew, &decodedLength);
+    testCheck(result, decodedLength == 0, "short data field rejected", verbose);
+    gcrNew[100] = 0xAA;  // Not a disk byte
+    decodeNICDataField(gcrNew, NIC_DATA_FIELD_SIZE, decodedNew, &decodedLength);
+    testCheck(result, decodedLength == 0, "invalid disk byte rejected", verbose);
+    
+    // Before/after timing
+    double encodeRef = timePerSector(iterations, [&](uint32_t n) {
+        sectorData[n & 0xFF] = (uint8_t)n;
+        encodeNICDataFieldReference(sectorData, gcrRef);
+    });
+    double encodeNew = timePerSector(iterations, [&](uint32_t n) {
+        sectorData[n & 0xFF] = (uint8_t)n;
+        encodeNICDataField(sectorData, gcrNew);
+    });
+    double decodeRef = timePerSector(iterations, [&](uint32_t) {
+        decodeNICDataFieldReference(gcrRef, NIC_DATA_FIELD_SIZE, decodedRef, &decodedLength);
+    });
+    double decodeNew = timePerSector(iterations, [&](uint32_t) {
+        decodeNICDataField(gcrRef, NIC_DATA_FIELD_SIZE, decodedNew, &decodedLength);
+    });
+    printf("Encode: %.0f ns/sector (reference: %.0f)\n", encodeNew, encodeRef);
+    printf("Decode: %.0f ns/sector (reference: %.0f)\n", decodeNew, decodeRef);
+}
+
+int main(int argc, char** argv) {
+    bool verbose = false;
+    uint32_t iterations = 100000;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-v") == 0) {
+            verbose = true;
+        } else if (atoi(argv[i]) > 0) {
+            iterations = (uint32_t)atoi(argv[i]);
+        }
+    }
+    TestResult result = {0, 0};
+    initReferenceTables();
+    runCodecTest(&result, verbose, iterations);
+    printf("NICCodec: %u checks, %u failed\n", (unsigned)result.checks, (unsigned)result.failures);
+    return result.failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,144 @@
+// Host test of SDAsyncEngine against SDMockCard: request ordering, cancellation
+// (queued and in flight), error reporting and queue limits
+
+#include "SDAsyncEngine.h"
+#include "SDMockCard.h"
+#include "SDProtocol.h"
+#include "TestCheck.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+// Completion order recorded by the test callback
+typedef struct {
+    uint32_t ids[16];
+    SDAsyncStatus status[16];
+    uint32_t count;
+} MockCompletionLog;
+
+static void mockTestCallback(const SDAsyncRequest* request, void* context) {
+    MockCompletionLog* log = (MockCompletionLog*)context;
+    if (log->count < 16) {
+        log->ids[log->count] = request->id;
+        log->status[log->count] = request->status;
+        log->count++;
+    }
+}
+
+// Poll until the queue is empty (bounded - a stuck engine fails the test instead of hanging)
+static bool mockDrain(SDAsyncEngine* engine) {
+    for (uint32_t i = 0; i < 100000; i++) {
+        if (!engine->poll()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void runEngineTest(TestResult* result, bool verbose) {
+    static SDMockCard card;
+    static uint8_t writeBuffer[3 * SD_BLOCK_SIZE];
+    static uint8_t readBuffer[8 * SD_BLOCK_SIZE];
+
+    result->checks = 0;
+    result->failures = 0;
+
+    card.reset();
+    card.fill(0x11);
+    card.tokenDelay = 40;   // Several poll() calls per token / busy wait
+    card.busyBytes = 50;
+    card.dmaPolls = 3;
+
+    SDAsyncEngine engine(&card);
+    MockCompletionLog log;
+
+    // 1. Ordering: write, read back, flush - completions and bus commands in submit order
+    memset(&log, 0, sizeof(log));
+    for (uint32_t i = 0; i < sizeof(writeBuffer); i++) {
+        writeBuffer[i] = (uint8_t)(i * 7 + 3);
+    }
+    memset(readBuffer, 0, sizeof(readBuffer));
+    uint32_t idWrite = engine.submitWrite(2, writeBuffer, 3, mockTestCallback, &log);
+    uint32_t idRead = engine.submitRead(2, readBuffer, 3, mockTestCallback, &log);
+    uint32_t idFlush = engine.submitFlush(mockTestCallback, &log);
+    testCheck(result, idWrite != 0 && idRead != 0 && idFlush != 0, "submit write/read/flush", verbose);
+    testCheck(result, mockDrain(&engine), "queue drains", verbose);
+    testCheck(result, log.count == 3 && log.ids[0] == idWrite && log.ids[1] == idRead && log.ids[2] == idFlush,
+              "completions in submit order", verbose);
+    testCheck(result, log.status[0] == SD_ASYNC_DONE && log.status[1] == SD_ASYNC_DONE && log.status[2] == SD_ASYNC_DONE,
+              "all requests DONE", verbose);
+    testCheck(result, memcmp(card.getBlock(2), writeBuffer, SD_BLOCK_SIZE) == 0 &&
+                      memcmp(card.getBlock(4), writeBuffer + 2 * SD_BLOCK_SIZE, SD_BLOCK_SIZE) == 0,
+              "write reached the card", verbose);
+    testCheck(result, memcmp(readBuffer, writeBuffer, sizeof(writeBuffer)) == 0, "read returns written data", verbose);
+    testCheck(result, card.getCommand(0) == SD_CMD55 && card.getCommand(1) == SD_ACMD23 &&
+                      card.getCommand(2) == SD_CMD25 && card.getCommand(3) == SD_CMD18 &&
+                      card.getCommand(4) == SD_CMD12 && card.getCommandCount() == 5,
+              "bus commands ACMD23, CMD25, CMD18, CMD12", verbose);
+
+    // 2. Cancel a queued request: never reaches the card, later requests still run
+    memset(&log, 0, sizeof(log));
+    card.clearLog();
+    uint32_t idA = engine.submitRead(0, readBuffer, 1, mockTestCallback, &log);
+    uint32_t idB = engine.submitRead(1, readBuffer + SD_BLOCK_SIZE, 1, mockTestCallback, &log);
+    uint32_t idC = engine.submitRead(5, readBuffer + 2 * SD_BLOCK_SIZE, 1, mockTestCallback, &log);
+    testCheck(result, engine.cancel(idB), "cancel queued request", verbose);
+    mockDrain(&engine);
+    testCheck(result, log.count == 3 && log.ids[0] == idA && log.ids[1] == idB && log.ids[2] == idC &&
+                      log.status[0] == SD_ASYNC_DONE && log.status[1] == SD_ASYNC_CANCELLED &&
+                      log.status[2] == SD_ASYNC_DONE,
+              "queued cancel reported in order", verbose);
+    testCheck(result, card.getCommandCount() == 2 && card.getCommand(0) == SD_CMD17 && card.getCommand(1) == SD_CMD17,
+              "cancelled request sent no command", verbose);
+    testCheck(result, memcmp(readBuffer + 2 * SD_BLOCK_SIZE, card.getBlock(5), SD_BLOCK_SIZE) == 0,
+              "request after cancel reads correct block", verbose);
+
+    // 3. Cancel in flight: stream stops at a block boundary with CMD12, card usable afterwards
+    memset(&log, 0, sizeof(log));
+    card.clearLog();
+    uint32_t idLong = engine.submitRead(0, readBuffer, 8, mockTestCallback, &log);
+    uint32_t idAfter = engine.submitRead(7, readBuffer, 1, mockTestCallback, &log);
+    for (uint32_t i = 0; i < 100000 && engine.getBlocksDone(idLong) < 2; i++) {
+        engine.poll();
+    }
+    uint32_t doneAtCancel = engine.getBlocksDone(idLong);
+    engine.cancel(idLong);
+    mockDrain(&engine);
+    testCheck(result, log.count == 2 && log.ids[0] == idLong && log.status[0] == SD_ASYNC_CANCELLED,
+              "in-flight cancel reports CANCELLED", verbose);
+    testCheck(result, doneAtCancel >= 2 && doneAtCancel < 8 && card.getCommand(1) == SD_CMD12,
+              "stream stopped early with CMD12", verbose);
+    testCheck(result, log.ids[1] == idAfter && log.status[1] == SD_ASYNC_DONE &&
+                      memcmp(readBuffer, card.getBlock(7), SD_BLOCK_SIZE) == 0,
+              "next request after in-flight cancel", verbose);
+
+    // 4. Errors: bad address (R1) and a stream running off the card (error token)
+    memset(&log, 0, sizeof(log));
+    engine.submitRead(SD_MOCK_BLOCKS + 4, readBuffer, 1, mockTestCallback, &log);
+    engine.submitRead(SD_MOCK_BLOCKS - 2, readBuffer, 4, mockTestCallback, &log);
+    engine.submitWrite(SD_MOCK_BLOCKS - 1, writeBuffer, 2, mockTestCallback, &log);
+    engine.submitRead(3, readBuffer, 2, mockTestCallback, &log);
+    mockDrain(&engine);
+    testCheck(result, log.count == 4 && log.status[0] == SD_ASYNC_ERROR && log.status[1] == SD_ASYNC_ERROR &&
+                      log.status[2] == SD_ASYNC_ERROR && log.status[3] == SD_ASYNC_DONE,
+              "errors reported, following request succeeds", verbose);
+
+    // 5. Queue full is rejected, not overwritten
+    uint32_t accepted = 0;
+    for (uint32_t i = 0; i < SD_ASYNC_QUEUE_DEPTH + 2; i++) {
+        if (engine.submitFlush()) {
+            accepted++;
+        }
+    }
+    testCheck(result, accepted == SD_ASYNC_QUEUE_DEPTH, "full queue rejects submit", verbose);
+    mockDrain(&engine);
+    testCheck(result, engine.isIdle() && !engine.isBusActive(), "engine idle at end", verbose);
+}
+
+int main(int argc, char** argv) {
+    bool verbose = argc > 1 && strcmp(argv[1], "-v") == 0;
+    TestResult result = {0, 0};
+    runEngineTest(&result, verbose);
+    printf("SDAsyncEngine: %u checks, %u failed\n", (unsigned)result.checks, (unsigned)result.failures);
+    return result.failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,192 @@
+#include "SDMockCard.h"
+#include "SDProtocol.h"
+#include <string.h>
+
+SDMockCard::SDMockCard() {
+    reset();
+}
+
+// Power-on state: empty card, no latencies, empty command log
+void SDMockCard::reset() {
+    selected = false;
+    mode = MODE_NONE;
+    phase = PHASE_TOKEN;
+    singleBlock = false;
+    appCommand = false;
+    block = 0;
+    delayLeft = 0;
+    crcLeft = 0;
+    busyLeft = 0;
+    dmaLeft = 0;
+    cmdLogCount = 0;
+    tokenDelay = 0;
+    busyBytes = 0;
+    dmaPolls = 0;
+    memset(data, 0, sizeof(data));
+}
+
+void SDMockCard::fill(uint8_t seed) {
+    for (uint32_t b = 0; b < SD_MOCK_BLOCKS; b++) {
+        for (uint32_t i = 0; i < 512; i++) {
+            data[b][i] = (uint8_t)(seed + b * 31 + i);
+        }
+    }
+}
+
+bool SDMockCard::busReady() {
+    return true;
+}
+
+void SDMockCard::busSelect(bool select) {
+    selected = select;
+}
+
+uint8_t SDMockCard::busCommand(uint8_t cmd, uint32_t arg) {
+    if (!selected) {
+        return 0xFF;
+    }
+    if (cmdLogCount < SD_MOCK_LOG_SIZE) {
+        cmdLog[cmdLogCount++] = cmd;
+    }
+
+    bool app = appCommand;
+    appCommand = false;
+
+    switch (cmd) {
+        case SD_CMD55:
+            appCommand = true;
+            return 0x00;
+        case SD_CMD12:
+            // Stop a read stream - card is busy for a moment afterwards
+            mode = MODE_NONE;
+            busyLeft = 2;
+            return 0x00;
+        case SD_CMD17:
+        case SD_CMD18:
+        case SD_CMD24:
+        case SD_CMD25:
+            if (arg >= SD_MOCK_BLOCKS) {
+                return 0x40;  // Parameter (address) error
+            }
+            mode = (cmd == SD_CMD17 || cmd == SD_CMD18) ? MODE_READ : MODE_WRITE;
+            singleBlock = (cmd == SD_CMD17 || cmd == SD_CMD24);
+            block = arg;
+            phase = PHASE_TOKEN;
+            delayLeft = tokenDelay;
+            return 0x00;
+        default:
+            if (app && cmd == SD_ACMD23) {
+                return 0x00;
+            }
+            return SD_R1_ILLEGAL_CMD;
+    }
+}
+
+uint8_t SDMockCard::busExchange(uint8_t out) {
+    if (!selected) {
+        return 0xFF;
+    }
+
+    if (mode == MODE_READ) {
+        switch (phase) {
+            case PHASE_TOKEN:
+                if (delayLeft > 0) {
+                    delayLeft--;
+                    return 0xFF;
+                }
+                if (block >= SD_MOCK_BLOCKS) {
+                    return 0x08;  // Data error token: out of range (stream ran off the card)
+                }
+                phase = PHASE_DATA;
+                return SD_TOKEN_START_BLOCK;
+            case PHASE_CRC:
+                if (--crcLeft == 0) {
+                    block++;
+                    phase = PHASE_TOKEN;
+                    delayLeft = tokenDelay;
+                    if (singleBlock) {
+                        mode = MODE_NONE;
+                    }
+                }
+                return 0x00;
+            default:
+                return 0xFF;
+        }
+    }
+
+    if (mode == MODE_WRITE) {
+        switch (phase) {
+            case PHASE_TOKEN:
+                if (out == SD_TOKEN_STOP_TRAN && !singleBlock) {
+                    mode = MODE_NONE;
+                    busyLeft = busyBytes + 1;  // One byte before busy starts
+                } else if (out == SD_TOKEN_MULTI_WRITE || out == SD_TOKEN_SINGLE_WRITE) {
+                    phase = PHASE_DATA;
+                }
+                return 0xFF;
+            case PHASE_CRC:
+                if (--crcLeft == 0) {
+                    phase = PHASE_RESPONSE;
+                }
+                return 0xFF;
+            case PHASE_RESPONSE:
+                if (block >= SD_MOCK_BLOCKS) {
+                    phase = PHASE_TOKEN;
+                    return 0x0D;  // Write error
+                }
+                phase = PHASE_BUSY;
+                busyLeft = busyBytes;
+                return 0x05;      // Data accepted
+            case PHASE_BUSY:
+                if (busyLeft > 0) {
+                    busyLeft--;
+                    return 0x00;
+                }
+                block++;
+                phase = PHASE_TOKEN;
+                if (singleBlock) {
+                    mode = MODE_NONE;
+                }
+                return 0xFF;
+            default:
+                return 0xFF;
+        }
+    }
+
+    // No transfer - MISO low while still busy
+    if (busyLeft > 0) {
+        busyLeft--;
+        return 0x00;
+    }
+    return 0xFF;
+}
+
+void SDMockCard::busStartRead(uint8_t* buffer, uint32_t length) {
+    if (mode == MODE_READ && phase == PHASE_DATA && block < SD_MOCK_BLOCKS) {
+        memcpy(buffer, data[block], length > 512 ? 512 : length);
+        phase = PHASE_CRC;
+        crcLeft = 2;
+    } else {
+        memset(buffer, 0xFF, length);
+    }
+    dmaLeft = dmaPolls;
+}
+
+void SDMockCard::busStartWrite(const uint8_t* buffer, uint32_t length) {
+    if (mode == MODE_WRITE && phase == PHASE_DATA) {
+        if (block < SD_MOCK_BLOCKS) {
+            memcpy(data[block], buffer, length > 512 ? 512 : length);
+        }
+        phase = PHASE_CRC;
+        crcLeft = 2;
+    }
+    dmaLeft = dmaPolls;
+}
+
+bool SDMockCard::busTransferDone() {
+    if (dmaLeft > 0) {
+        dmaLeft--;
+        return false;
+    }
+    return true;
+}
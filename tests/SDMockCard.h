@@ -0,0 +1,71 @@
+#ifndef SD_MOCK_CARD_H
+#define SD_MOCK_CARD_H
+
+#include "SDAsyncEngine.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+// In-memory SD card speaking the SPI protocol at byte level (R1, data tokens, CRC bytes,
+// data response, busy) for tests/SDAsyncEngineTest.cpp. Latencies are configurable so
+// the engine has to wait across several poll() calls like on a real card.
+
+#define SD_MOCK_BLOCKS        16      // Card capacity (blocks) - addresses beyond return R1 0x40
+#define SD_MOCK_LOG_SIZE      64      // Commands kept in the command log
+
+class SDMockCard : public SDAsyncBus {
+private:
+    typedef enum {
+        MODE_NONE = 0,
+        MODE_READ,
+        MODE_WRITE
+    } Mode;
+
+    typedef enum {
+        PHASE_TOKEN = 0,        // Read: 0xFF for tokenDelay bytes, then 0xFE / write: waiting for a token
+        PHASE_DATA,             // Waiting for busStartRead() / busStartWrite()
+        PHASE_CRC,              // 2 CRC bytes
+        PHASE_RESPONSE,         // Write: data response token
+        PHASE_BUSY              // Write: programming
+    } Phase;
+
+    uint8_t data[SD_MOCK_BLOCKS][512];
+    bool selected;
+    Mode mode;
+    Phase phase;
+    bool singleBlock;
+    bool appCommand;
+    uint32_t block;             // Current block of the transfer
+    uint32_t delayLeft;         // Bytes until the read token
+    uint32_t crcLeft;
+    uint32_t busyLeft;          // Bytes MISO stays low
+    uint32_t dmaLeft;           // busTransferDone() calls still returning false
+
+    uint8_t cmdLog[SD_MOCK_LOG_SIZE];
+    uint32_t cmdLogCount;
+
+public:
+    // Latencies (bytes / calls) - may be changed between requests
+    uint32_t tokenDelay;        // 0xFF bytes before every read data token
+    uint32_t busyBytes;         // Busy bytes after every accepted block
+    uint32_t dmaPolls;          // busTransferDone() polls per block transfer
+
+    SDMockCard();
+
+    void reset();
+    void fill(uint8_t seed);                       // Deterministic pattern in every block
+    const uint8_t* getBlock(uint32_t index) const { return data[index]; }
+    uint32_t getCommandCount() const { return cmdLogCount; }
+    uint8_t getCommand(uint32_t index) const { return index < cmdLogCount ? cmdLog[index] : 0xFF; }
+    void clearLog() { cmdLogCount = 0; }
+
+    // SDAsyncBus
+    bool busReady();
+    void busSelect(bool select);
+    uint8_t busCommand(uint8_t cmd, uint32_t arg);
+    uint8_t busExchange(uint8_t out);
+    void busStartRead(uint8_t* buffer, uint32_t length);
+    void busStartWrite(const uint8_t* buffer, uint32_t length);
+    bool busTransferDone();
+};
+
+#endif // SD_MOCK_CARD_H
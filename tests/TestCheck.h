@@ -0,0 +1,24 @@
+#ifndef TEST_CHECK_H
+#define TEST_CHECK_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Pass / fail counters of one host test executable
+typedef struct {
+    uint32_t checks;
+    uint32_t failures;
+} TestResult;
+
+// Count one check - failures are always printed, passes only with verbose
+static inline void testCheck(TestResult* result, bool ok, const char* what, bool verbose) {
+    result->checks++;
+    if (!ok) {
+        result->failures++;
+    }
+    if (verbose || !ok) {
+        printf("  %s %s\n", ok ? "PASS" : "FAIL", what);
+    }
+}
+
+#endif // TEST_CHECK_H
@@ -0,0 +1,8 @@
+#ifndef TEST_STUB_SYNC_H
+#define TEST_STUB_SYNC_H
+
+// Host stand-in: everything runs on "core 0"
+static inline unsigned int get_core_num(void) { return 0; }
+static inline void tight_loop_contents(void) {}
+
+#endif // TEST_STUB_SYNC_H
@@ -0,0 +1,13 @@
+#ifndef TEST_STUB_TIMER_H
+#define TEST_STUB_TIMER_H
+
+#include <stdint.h>
+#include <chrono>
+
+// Host stand-in for the 1MHz timer
+static inline uint32_t time_us_32(void) {
+    return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+#endif // TEST_STUB_TIMER_H
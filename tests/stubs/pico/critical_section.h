@@ -0,0 +1,13 @@
+#ifndef TEST_STUB_CRITICAL_SECTION_H
+#define TEST_STUB_CRITICAL_SECTION_H
+
+// Host stand-in for the Pico SDK critical section (host tests are single threaded)
+typedef struct {
+    int unused;
+} critical_section_t;
+
+static inline void critical_section_init(critical_section_t* cs) { (void)cs; }
+static inline void critical_section_enter_blocking(critical_section_t* cs) { (void)cs; }
+static inline void critical_section_exit(critical_section_t* cs) { (void)cs; }
+
+#endif // TEST_STUB_CRITICAL_SECTION_H